@@ -0,0 +1,154 @@
+/*
+Benchmark of the library memory and string routine variants.
+*/
+
+/* INCLUDES */
+
+#include <app.h>
+#include <io.h>
+#include <memory.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <internal/cpu/features.h>
+#include <internal/memory/memory.h>
+
+
+/* TYPES */
+
+// Routine under test, wrapped into a common signature.
+typedef void (*bench_func_t)(uint8_t *dst, uint8_t *src, uint64_t size);
+
+
+/* VARIABLES */
+
+// Measured sizes.
+static const uint64_t sizes[] = { 16, 64, 256, 1024, 4096, 64 * 1024, 1024 * 1024 };
+#define SIZE_COUNT (int)(sizeof(sizes) / sizeof(*sizes))
+
+// Repetitions per size; the minimum time is reported.
+#define REPETITIONS 200
+
+// Buffer size: Largest size plus some slack for the unaligned runs.
+#define BUFFER_SIZE (1024 * 1024 + 64)
+
+
+/* FUNCTIONS */
+
+static void bench_memcpy(uint8_t *dst, uint8_t *src, uint64_t size) { memcpy(dst, src, size); }
+static void bench_memcpy_sse2(uint8_t *dst, uint8_t *src, uint64_t size) { memcpy_sse2(dst, src, size); }
+static void bench_memcpy_avx2(uint8_t *dst, uint8_t *src, uint64_t size) { memcpy_avx2(dst, src, size); }
+static void bench_memcpy_erms(uint8_t *dst, uint8_t *src, uint64_t size) { memcpy_erms(dst, src, size); }
+static void bench_memset(uint8_t *dst, uint8_t *src, uint64_t size) { memset(dst, 0x5A, size); }
+static void bench_memset_sse2(uint8_t *dst, uint8_t *src, uint64_t size) { memset_sse2(dst, 0x5A, size); }
+static void bench_memset_avx2(uint8_t *dst, uint8_t *src, uint64_t size) { memset_avx2(dst, 0x5A, size); }
+static void bench_memset_erms(uint8_t *dst, uint8_t *src, uint64_t size) { memset_erms(dst, 0x5A, size); }
+static void bench_memmove(uint8_t *dst, uint8_t *src, uint64_t size) { memmove(dst + 8, dst, size); }
+static void bench_memcmp_sse2(uint8_t *dst, uint8_t *src, uint64_t size) { memcmp_sse2(dst, src, size); }
+static void bench_memcmp_avx2(uint8_t *dst, uint8_t *src, uint64_t size) { memcmp_avx2(dst, src, size); }
+
+// The string routines run on strings of the given length, which are prepared by run_benchmark().
+static void bench_strlen_sse2(uint8_t *dst, uint8_t *src, uint64_t size) { strlen_sse2((char *)src); }
+static void bench_strlen_avx2(uint8_t *dst, uint8_t *src, uint64_t size) { strlen_avx2((char *)src); }
+static void bench_strcmp_sse2(uint8_t *dst, uint8_t *src, uint64_t size) { strcmp_sse2((char *)dst, (char *)src); }
+static void bench_strcmp_avx2(uint8_t *dst, uint8_t *src, uint64_t size) { strcmp_avx2((char *)dst, (char *)src); }
+
+// Reads the time stamp counter, after all preceding instructions have completed.
+static uint64_t read_tsc(void)
+{
+	__builtin_ia32_lfence();
+	return __builtin_ia32_rdtsc();
+}
+
+// Measures the given routine for all sizes and prints the minimum times.
+static void run_benchmark(const char *name, bench_func_t func, uint8_t *dst, uint8_t *src, bool strings)
+{
+	printf_locked("%-16s", name);
+	for(int s = 0; s < SIZE_COUNT; ++s)
+	{
+		uint64_t size = sizes[s];
+		
+		// Equal strings of the given length for strlen() and strcmp(), the other routines use arbitrary contents
+		if(strings)
+		{
+			memset(src, 'a', size);
+			memset(dst, 'a', size);
+			src[size] = 0;
+			dst[size] = 0;
+		}
+		
+		uint64_t min = UINT64_MAX;
+		for(int r = 0; r < REPETITIONS; ++r)
+		{
+			uint64_t start = read_tsc();
+			func(dst, src, size);
+			uint64_t cycles = read_tsc() - start;
+			if(cycles < min)
+				min = cycles;
+		}
+		printf_locked(" %9llu", min);
+	}
+	printf_locked("\n");
+}
+
+void main()
+{
+	// Initialize library
+	_start();
+	
+	uint32_t features = cpu_features_get();
+	printf_locked("Memory routine benchmark (minimum of %d runs, TSC ticks)\n", REPETITIONS);
+	printf_locked("CPU features: AVX2 %s, ERMS %s, FSRM %s\n\n", (features & CPU_FEATURE_AVX2) ? "yes" : "no",
+		(features & CPU_FEATURE_ERMS) ? "yes" : "no", (features & CPU_FEATURE_FSRM) ? "yes" : "no");
+	
+	uint8_t *src = malloc(BUFFER_SIZE);
+	uint8_t *dst = malloc(BUFFER_SIZE);
+	if(!src || !dst)
+	{
+		printf_locked("Could not allocate buffers.\n");
+		_end(1);
+	}
+	memset(src, 0xA5, BUFFER_SIZE);
+	memset(dst, 0xA5, BUFFER_SIZE);
+	
+	printf_locked("%-16s", "Routine");
+	for(int s = 0; s < SIZE_COUNT; ++s)
+		printf_locked(" %9llu", sizes[s]);
+	printf_locked("\n");
+	
+	bool avx2 = (features & CPU_FEATURE_AVX2) != 0;
+	bool erms = (features & CPU_FEATURE_ERMS) != 0;
+	run_benchmark("memcpy", &bench_memcpy, dst, src, false);
+	run_benchmark("memcpy (sse2)", &bench_memcpy_sse2, dst, src, false);
+	if(avx2)
+		run_benchmark("memcpy (avx2)", &bench_memcpy_avx2, dst, src, false);
+	if(erms)
+		run_benchmark("memcpy (erms)", &bench_memcpy_erms, dst, src, false);
+	run_benchmark("memcpy (unalig.)", &bench_memcpy, dst + 3, src + 1, false);
+	run_benchmark("memset", &bench_memset, dst, src, false);
+	run_benchmark("memset (sse2)", &bench_memset_sse2, dst, src, false);
+	if(avx2)
+		run_benchmark("memset (avx2)", &bench_memset_avx2, dst, src, false);
+	if(erms)
+		run_benchmark("memset (erms)", &bench_memset_erms, dst, src, false);
+	run_benchmark("memmove (back)", &bench_memmove, dst, src, false);
+	
+	// Equal arrays, so the whole length is compared
+	memset(src, 0xA5, BUFFER_SIZE);
+	memset(dst, 0xA5, BUFFER_SIZE);
+	run_benchmark("memcmp (sse2)", &bench_memcmp_sse2, dst, src, false);
+	if(avx2)
+		run_benchmark("memcmp (avx2)", &bench_memcmp_avx2, dst, src, false);
+	run_benchmark("strlen (sse2)", &bench_strlen_sse2, dst, src, true);
+	if(avx2)
+		run_benchmark("strlen (avx2)", &bench_strlen_avx2, dst, src, true);
+	run_benchmark("strcmp (sse2)", &bench_strcmp_sse2, dst, src, true);
+	if(avx2)
+		run_benchmark("strcmp (avx2)", &bench_strcmp_avx2, dst, src, true);
+	
+	free(src);
+	free(dst);
+	
+	// Exit with return code
+	_end(0);
+}
\ No newline at end of file
@@ -30,7 +30,7 @@ void mcfg_scan(mcfg_t *mcfg)
 				{
 					// Calculate and map physical address of configuration space
 					uint64_t physicalAddress = entry->baseAddress | (b << 20) | (d << 15) | (f << 12);
-					void *cfgSpace = mmio_map(physicalAddress, 4096, VM_R);
+					void *cfgSpace = mmio_map(physicalAddress, 4096, VM_R | VM_W);
 					if(!cfgSpace)
 						panic("Couldn't map PCIe device configuration space");
 					
@@ -6,11 +6,29 @@
 
 #define CPUID_VENDOR       0x00000000
 #define CPUID_FEATURES     0x00000001
+#define CPUID_MWAIT        0x00000005
+#define CPUID_STRUCT_FEATURES 0x00000007
+#define CPUID_XSAVE        0x0000000D
 #define CPUID_EXT_VENDOR   0x80000000
 #define CPUID_EXT_FEATURES 0x80000001
 
 #define CPUID_EXT_FEATURE_EDX_1GB_PAGE 0x04000000
 
+#define CPUID_FEATURE_ECX_MONITOR 0x00000008
+
+/* CPUID_MWAIT */
+#define CPUID_MWAIT_ECX_EMX 0x00000001 /* C-state enumeration in EDX is valid */
+
+/* CPUID_STRUCT_FEATURES sub-leaf 0 */
+#define CPUID_STRUCT_FEATURE_EBX_ERMS 0x00000200 /* enhanced REP MOVSB/STOSB */
+#define CPUID_STRUCT_FEATURE_EDX_FSRM 0x00000010 /* fast short REP MOVSB */
+
+/* CPUID_XSAVE sub-leaf 1 */
+#define CPUID_XSAVE_EAX_XSAVEOPT 0x00000001
+#define CPUID_XSAVE_EAX_XSAVEC   0x00000002
+#define CPUID_XSAVE_EAX_XGETBV1  0x00000004
+#define CPUID_XSAVE_EAX_XSAVES   0x00000008
+
 void cpu_id(uint32_t code, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx);
 
 void cpu_id_special(uint32_t eaxIn, uint32_t ecxIn, uint32_t *eaxOut, uint32_t *ebxOut, uint32_t *ecxOut, uint32_t *edxOut);
@@ -36,6 +36,38 @@ void cpu_features_init(void)
     if (edx & CPUID_EXT_FEATURE_EDX_1GB_PAGE)
       cpu_feature_set(FEATURE_1G_PAGE);
   }
+
+  /* detect MONITOR/MWAIT */
+  uint32_t ecx;
+  cpu_id(CPUID_FEATURES, &tmp, &tmp, &ecx, &tmp);
+  if ((ecx & CPUID_FEATURE_ECX_MONITOR) && CPUID_MWAIT <= max)
+    cpu_feature_set(FEATURE_MWAIT);
+
+  /* detect fast string instructions */
+  if (CPUID_STRUCT_FEATURES <= max)
+  {
+    uint32_t ebx, edx;
+    cpu_id_special(CPUID_STRUCT_FEATURES, 0, &tmp, &ebx, &tmp, &edx);
+    if (ebx & CPUID_STRUCT_FEATURE_EBX_ERMS)
+      cpu_feature_set(FEATURE_ERMS);
+    if (edx & CPUID_STRUCT_FEATURE_EDX_FSRM)
+      cpu_feature_set(FEATURE_FSRM);
+  }
+
+  /* detect optimized XSAVE variants */
+  if (CPUID_XSAVE <= max)
+  {
+    uint32_t eax;
+    cpu_id_special(CPUID_XSAVE, 1, &eax, &tmp, &tmp, &tmp);
+    if (eax & CPUID_XSAVE_EAX_XSAVEOPT)
+      cpu_feature_set(FEATURE_XSAVEOPT);
+    if (eax & CPUID_XSAVE_EAX_XSAVEC)
+      cpu_feature_set(FEATURE_XSAVEC);
+    if (eax & CPUID_XSAVE_EAX_XSAVES)
+      cpu_feature_set(FEATURE_XSAVES);
+    if (eax & CPUID_XSAVE_EAX_XGETBV1)
+      cpu_feature_set(FEATURE_XGETBV1);
+  }
 }
 
 bool cpu_feature_supported(cpu_feature_t feature)
@@ -7,6 +7,13 @@
 typedef enum
 {
   FEATURE_1G_PAGE,
+  FEATURE_XSAVEOPT,
+  FEATURE_XSAVEC,
+  FEATURE_XSAVES,
+  FEATURE_XGETBV1,
+  FEATURE_MWAIT,
+  FEATURE_ERMS,
+  FEATURE_FSRM,
   _FEATURE_MAX
 } cpu_feature_t;
 
@@ -0,0 +1,77 @@
+
+#include <cpu/fpu.h>
+#include <cpu/xsave.h>
+#include <lock/intr.h>
+#include <lock/preempt.h>
+#include <smp/cpu.h>
+#include <stdlib/assert.h>
+
+// Set by kernel_fpu_init(), as the XSAVE area format is not known before.
+static bool kernelFpuReady = false;
+
+void kernel_fpu_init(void)
+{
+	kernelFpuReady = true;
+}
+
+bool kernel_fpu_begin(void)
+{
+	if(!kernelFpuReady)
+		return false;
+	
+	// Interrupts are masked while the CPU state is changed, so an interrupt handler sees either no section or a
+	// complete one
+	intr_lock();
+	cpu_t *cpu = cpu_get();
+	if(cpu->fpuActive)
+	{
+		intr_unlock();
+		return false;
+	}
+	cpu->fpuActive = true;
+	preempt_disable();
+	
+	// Save the registers if they belong to the current thread; in this case they were loaded when the thread was
+	// switched in, and may have been modified since. The init state shortcut also requires MXCSR to be at its default,
+	// else a custom rounding mode or exception mask would be lost when kernel_fpu_end() loads the init state
+	thread_t *thread = cpu->thread;
+	if(thread && thread->xsave_state && cpu->xsave_owner == thread)
+	{
+		if(xsave_in_use())
+		{
+			xsave(thread->xsave_state);
+			thread->xsave_init = false;
+		}
+		else
+			thread->xsave_init = true;
+	}
+	
+	// The registers now belong to the kernel, the next user thread switched in has to reload its state
+	cpu->xsave_owner = 0;
+	
+	intr_unlock();
+	return true;
+}
+
+void kernel_fpu_end(void)
+{
+	intr_lock();
+	cpu_t *cpu = cpu_get();
+	assert(cpu->fpuActive);
+	
+	// Hand the registers back to the current user thread before it returns to user space
+	thread_t *thread = cpu->thread;
+	if(thread && thread->xsave_state)
+	{
+		if(!thread->xsave_init)
+			xrstor(thread->xsave_state);
+		else
+			xrstor_init();
+		cpu->xsave_owner = thread;
+		thread->xsave_core = cpu->coreId;
+	}
+	
+	cpu->fpuActive = false;
+	intr_unlock();
+	preempt_enable();
+}
@@ -0,0 +1,33 @@
+
+#ifndef _CPU_FPU_H
+#define _CPU_FPU_H
+
+#include <stdbool.h>
+
+// The kernel is compiled without SSE, so its C code never touches the vector registers; these hold the state of the
+// user thread which ran last on the core. Assembly routines may use SSE instructions between kernel_fpu_begin() and
+// kernel_fpu_end():
+//     if(kernel_fpu_begin())
+//     {
+//         ... vector routine ...
+//         kernel_fpu_end();
+//     }
+//     else
+//         ... scalar routine ...
+//
+// kernel_fpu_begin() saves the registers of the current thread only if they are live and in use; the registers of
+// other threads were already saved when these were switched out. kernel_fpu_end() loads the state of the current
+// user thread again, kernel threads leave the reload to the next switch to a user thread.
+// Preemption is disabled within the section, so the code must not block or yield.
+
+// Enables kernel_fpu_begin(). Must be called once on the bootstrap processor, after xsave_init().
+void kernel_fpu_init(void);
+
+// Makes the vector registers usable by the kernel. Returns false if they cannot be used, i.e. during early boot or if
+// the section interrupted another one on this core; in this case kernel_fpu_end() must not be called.
+bool kernel_fpu_begin(void);
+
+// Ends a section started by a successful kernel_fpu_begin().
+void kernel_fpu_end(void);
+
+#endif
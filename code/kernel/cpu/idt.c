@@ -98,6 +98,8 @@ void idt_bsp_init(void)
   idt_encode_descriptor(IRQ21,     &irq21,     IDT_PRESENT | IDT_INTERRUPT);
   idt_encode_descriptor(IRQ22,     &irq22,     IDT_PRESENT | IDT_INTERRUPT);
   idt_encode_descriptor(IRQ23,     &irq23,     IDT_PRESENT | IDT_INTERRUPT);
+  idt_encode_descriptor(IPI_RCU,   &ipi_rcu,   IDT_PRESENT | IDT_INTERRUPT);
+  idt_encode_descriptor(IPI_RESCHED, &ipi_resched, IDT_PRESENT | IDT_INTERRUPT);
   idt_encode_descriptor(IPI_PANIC, &ipi_panic, IDT_PRESENT | IDT_INTERRUPT);
   idt_encode_descriptor(IPI_TLB,   &ipi_tlb,   IDT_PRESENT | IDT_INTERRUPT);
   idt_encode_descriptor(LVT_TIMER, &lvt_timer, IDT_PRESENT | IDT_INTERRUPT);
@@ -13,6 +13,7 @@
 #define MSR_LSTAR          0xC0000082
 #define MSR_CSTAR          0xC0000083
 #define MSR_SFMASK         0xC0000084
+#define MSR_XSS            0x00000DA0
 
 #define APIC_BASE_ENABLED 0x800
 #define APIC_BASE_X2_MODE 0x400
@@ -0,0 +1,17 @@
+#ifndef _CPU_MWAIT_H
+#define _CPU_MWAIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// MWAIT hint for the C1 state, which has the lowest exit latency.
+#define MWAIT_HINT_C1 0x00
+
+// Sleeps in the C-state given by the hint using MONITOR/MWAIT, until the given flag is written or an interrupt arrives.
+// Returns immediately if the flag is already set.
+void mwait_idle(volatile bool *flag, uint32_t hint);
+
+// Sleeps using HLT until an interrupt arrives. Returns immediately if the given flag is already set.
+void halt_idle(volatile bool *flag);
+
+#endif
@@ -0,0 +1,44 @@
+; Idle primitives which sleep until the given wake-up flag is set.
+; Parameters:
+;     - rdi: Pointer to the wake-up flag (1 byte).
+;     - esi: MWAIT hint (target C-state and sub-state), only for mwait_idle.
+; Interrupts are expected to be enabled on entry and are enabled on return.
+
+[global mwait_idle]
+mwait_idle:
+	; Arm the monitor on the flag's cache line; any write to it ends MWAIT
+	cli
+	mov rax, rdi
+	xor ecx, ecx
+	xor edx, edx
+	monitor
+	
+	; The flag might have been set before the monitor was armed
+	cmp byte [rdi], 0
+	jne .done
+	
+	; Sleep; STI delays interrupt recognition by one instruction, so a pending
+	; interrupt wakes MWAIT instead of being handled before it
+	mov eax, esi
+	sti
+	mwait
+	ret
+	
+.done:
+	sti
+	ret
+
+[global halt_idle]
+halt_idle:
+	; Fallback for CPUs without MWAIT: The flag is set together with a
+	; reschedule IPI, which ends HLT
+	cli
+	cmp byte [rdi], 0
+	jne .done
+	sti
+	hlt
+	ret
+	
+.done:
+	sti
+	ret
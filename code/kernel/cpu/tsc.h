@@ -0,0 +1,11 @@
+
+#ifndef _CPU_TSC_H
+#define _CPU_TSC_H
+
+#include <stdint.h>
+
+// Returns the current value of the time stamp counter. The counter frequency of the current core is stored in
+// cpu_t::tsc_ticks_per_ms.
+uint64_t tsc_read(void);
+
+#endif
@@ -0,0 +1,12 @@
+; Reads the time stamp counter.
+; The preceding LFENCE keeps earlier instructions from completing after the counter is read.
+; Return value:
+;     - rax: Current TSC value.
+
+[global tsc_read]
+tsc_read:
+	lfence
+	rdtsc
+	shl rdx, 32
+	or rax, rdx
+	ret
@@ -1,15 +1,28 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
-// Returns a sufficient memory block for XSAVE.
+// Detects the supported XSAVE variants and determines the size of the XSAVE area.
+// Must be called once on the bootstrap processor, after cpu_features_init().
+void xsave_init(void);
+
+// Returns a sufficient memory block for XSAVE, initialized to the processor's init state.
 void* xsave_alloc(void);
 
 // Free XSAVE memory block.
 void xsave_free(void *mem);
 
 // Saves the entire vector register state to the given memory block.
+// Depending on processor support this uses XSAVES, XSAVEC or XSAVEOPT, which skip unmodified and init components.
 void xsave(void *mem);
 
 // Restores the vector register state from the given memory block.
-void xrstor(void *mem);
\ No newline at end of file
+void xrstor(void *mem);
+
+// Puts all vector registers into their init state.
+void xrstor_init(void);
+
+// Returns whether any vector register component is not in its init state, including MXCSR.
+// If the processor cannot report this, true is returned.
+bool xsave_in_use(void);
@@ -1,21 +1,91 @@
+; XSAVE/XRSTOR variants. xsave_c.c selects the best supported one on boot.
+; Parameters:
+;     - rdi: Pointer to 64-byte aligned XSAVE area.
+;     - rsi: Requested-feature bitmap (loaded into EDX:EAX).
 
-[global xsave]
-xsave:
-	; Save x87, SSE and AVX state
-	mov eax, 0x00000007
-	xor edx, edx
+[global xsave_std]
+xsave_std:
+	; Save x87, SSE and AVX state (standard format)
+	mov eax, esi
+	mov rdx, rsi
+	shr rdx, 32
 	xsave64 [rdi]
 	
 	; Done
 	ret
+
+[global xsave_opt]
+xsave_opt:
+	; Save state, skipping components that are in init state or were not
+	; modified since the last XRSTOR of this area
+	mov eax, esi
+	mov rdx, rsi
+	shr rdx, 32
+	xsaveopt64 [rdi]
+	
+	; Done
+	ret
+
+[global xsave_c]
+xsave_c:
+	; Save state in compacted format, skipping components in init state
+	mov eax, esi
+	mov rdx, rsi
+	shr rdx, 32
+	xsavec64 [rdi]
 	
-[global xrstor]
-xrstor:
-	; Restore x87, SSE and AVX state
-	mov eax, 0x00000007
-	xor edx, edx
+	; Done
+	ret
+
+[global xsave_s]
+xsave_s:
+	; Save state in compacted format, with init and modified optimizations
+	mov eax, esi
+	mov rdx, rsi
+	shr rdx, 32
+	xsaves64 [rdi]
+	
+	; Done
+	ret
+	
+[global xrstor_std]
+xrstor_std:
+	; Restore state (standard or compacted format)
+	mov eax, esi
+	mov rdx, rsi
+	shr rdx, 32
 	xrstor64 [rdi]
 	
 	; Done
 	ret
+
+[global xrstor_s]
+xrstor_s:
+	; Restore state saved by XSAVES
+	mov eax, esi
+	mov rdx, rsi
+	shr rdx, 32
+	xrstors64 [rdi]
 	
+	; Done
+	ret
+
+; Reads the given extended control register.
+; Parameters:
+;     - rdi: Register index (0 = XCR0, 1 = XINUSE).
+[global xgetbv_read]
+xgetbv_read:
+	mov ecx, edi
+	xgetbv
+	shl rdx, 32
+	or rax, rdx
+	ret
+
+; Reads the MXCSR register.
+[global mxcsr_read]
+mxcsr_read:
+	sub rsp, 8
+	stmxcsr [rsp]
+	mov eax, [rsp]
+	add rsp, 8
+	ret
@@ -1,24 +1,131 @@
 
 #include <cpu/xsave.h>
 #include <cpu/cpuid.h>
+#include <cpu/features.h>
+#include <cpu/msr.h>
 #include <stdlib/stdlib.h>
+#include <stdlib/string.h>
+#include <panic/panic.h>
 #include <trace/trace.h>
+#include <lock/spinlock.h>
 
-void* xsave_alloc(void)
+// Offsets of fields within the XSAVE area.
+#define XSAVE_MXCSR_OFFSET 24
+#define XSAVE_XCOMP_BV_OFFSET 520
+
+// Default MXCSR value (all exceptions masked).
+#define XSAVE_MXCSR_DEFAULT 0x1F80
+
+// Bit in XCOMP_BV marking an area as being in compacted format.
+#define XSAVE_XCOMP_BV_COMPACTED 0x8000000000000000ULL
+
+// Maximum number of cached XSAVE areas.
+#define XSAVE_CACHE_SIZE 32
+
+// Assembly implementations (xsave.s).
+void xsave_std(void *mem, uint64_t mask);
+void xsave_opt(void *mem, uint64_t mask);
+void xsave_c(void *mem, uint64_t mask);
+void xsave_s(void *mem, uint64_t mask);
+void xrstor_std(void *mem, uint64_t mask);
+void xrstor_s(void *mem, uint64_t mask);
+uint64_t xgetbv_read(uint32_t reg);
+uint32_t mxcsr_read(void);
+
+// The save and restore implementations chosen by xsave_init().
+static void (*xsave_func)(void *mem, uint64_t mask) = &xsave_std;
+static void (*xrstor_func)(void *mem, uint64_t mask) = &xrstor_std;
+
+// The state components enabled in XCR0.
+static uint64_t xsave_mask = 0x7;
+
+// Size of an XSAVE area in the selected format.
+static uint32_t xsave_size = 0;
+
+// Areas of destroyed threads, which are reused for new threads.
+static void *xsave_cache[XSAVE_CACHE_SIZE];
+static int xsave_cache_count = 0;
+static spinlock_t xsave_cache_lock = SPIN_UNLOCKED;
+
+// Determines whether the selected format is the compacted one (XSAVEC/XSAVES).
+static bool xsave_compacted = false;
+
+// Determines whether XGETBV can be used to query the XINUSE bitmap.
+static bool xsave_xinuse_supported = false;
+
+// XSAVE area containing the init state of all components.
+static void *xsave_init_area = 0;
+
+// Prepares the given XSAVE area such that restoring it yields the init state.
+static void xsave_area_reset(void *mem)
 {
-	// Determine size of XSAVE region
+	memclr(mem, xsave_size);
+	*(uint32_t *)((uint8_t *)mem + XSAVE_MXCSR_OFFSET) = XSAVE_MXCSR_DEFAULT;
+	if(xsave_compacted)
+		*(uint64_t *)((uint8_t *)mem + XSAVE_XCOMP_BV_OFFSET) = XSAVE_XCOMP_BV_COMPACTED | xsave_mask;
+}
+
+void xsave_init(void)
+{
+	// Retrieve enabled state components (set up by start.s and trampoline.s)
+	xsave_mask = xgetbv_read(0);
+	
+	// Choose save variant, the size of the area depends on the format
 	uint32_t eax;
 	uint32_t ebx;
 	uint32_t ecx;
 	uint32_t edx;
-	cpu_id_special(0x0D, 0x00, &eax, &ebx, &ecx, &edx);
-	uint32_t size = ebx;
+	if(cpu_feature_supported(FEATURE_XSAVES))
+	{
+		// We do not use supervisor state components
+		msr_write(MSR_XSS, 0);
+		
+		xsave_func = &xsave_s;
+		xrstor_func = &xrstor_s;
+		xsave_compacted = true;
+		cpu_id_special(CPUID_XSAVE, 0x01, &eax, &ebx, &ecx, &edx);
+		trace_printf("Using XSAVES for vector state switching\n");
+	}
+	else if(cpu_feature_supported(FEATURE_XSAVEC))
+	{
+		xsave_func = &xsave_c;
+		xrstor_func = &xrstor_std;
+		xsave_compacted = true;
+		cpu_id_special(CPUID_XSAVE, 0x01, &eax, &ebx, &ecx, &edx);
+		trace_printf("Using XSAVEC for vector state switching\n");
+	}
+	else
+	{
+		xsave_func = cpu_feature_supported(FEATURE_XSAVEOPT) ? &xsave_opt : &xsave_std;
+		xrstor_func = &xrstor_std;
+		xsave_compacted = false;
+		cpu_id_special(CPUID_XSAVE, 0x00, &eax, &ebx, &ecx, &edx);
+		trace_printf("Using %s for vector state switching\n", cpu_feature_supported(FEATURE_XSAVEOPT) ? "XSAVEOPT" : "XSAVE");
+	}
+	xsave_size = ebx;
+	xsave_xinuse_supported = cpu_feature_supported(FEATURE_XGETBV1);
 	
-	// Allocate XSAVE region
-	void *mem = memalign(64, size);
+	// Create init state area
+	xsave_init_area = xsave_alloc();
+	if(!xsave_init_area)
+		panic("couldn't allocate XSAVE init area");
+}
+
+void* xsave_alloc(void)
+{
+	// Reuse cached XSAVE region, or allocate a new one
+	void *mem = 0;
+	spin_lock_plain(&xsave_cache_lock);
+	if(xsave_cache_count > 0)
+		mem = xsave_cache[--xsave_cache_count];
+	spin_unlock_plain(&xsave_cache_lock);
+	if(!mem)
+		mem = memalign(64, xsave_size);
+	if(!mem)
+		return 0;
 	
-	// Write dummy data to get a valid state
-	xsave(mem);
+	// Initialize with a valid init state
+	xsave_area_reset(mem);
 	
 	// Done
 	return mem;
@@ -26,6 +133,42 @@ void* xsave_alloc(void)
 
 void xsave_free(void *mem)
 {
+	// Keep region for reuse, if there is space in the cache
+	spin_lock_plain(&xsave_cache_lock);
+	if(xsave_cache_count < XSAVE_CACHE_SIZE)
+	{
+		xsave_cache[xsave_cache_count++] = mem;
+		mem = 0;
+	}
+	spin_unlock_plain(&xsave_cache_lock);
+	
 	// Free
-	free(mem);
-}
\ No newline at end of file
+	if(mem)
+		free(mem);
+}
+
+void xsave(void *mem)
+{
+	xsave_func(mem, xsave_mask);
+}
+
+void xrstor(void *mem)
+{
+	xrstor_func(mem, xsave_mask);
+}
+
+void xrstor_init(void)
+{
+	xrstor_func(xsave_init_area, xsave_mask);
+}
+
+bool xsave_in_use(void)
+{
+	if(!xsave_xinuse_supported)
+		return true;
+	if((xgetbv_read(1) & xsave_mask) != 0)
+		return true;
+	
+	// XINUSE does not track MXCSR, so the SSE component may be reported as unused while it holds a custom value
+	return mxcsr_read() != XSAVE_MXCSR_DEFAULT;
+}
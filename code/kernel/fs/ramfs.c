@@ -9,7 +9,7 @@ and to its first and last child directories on the next level.
 #include <fs/ramfs.h>
 #include <stdlib/stdlib.h>
 #include <stdlib/string.h>
-#include <lock/spinlock.h>
+#include <lock/rwlock.h>
 #include <stdbool.h>
 
 
@@ -114,8 +114,9 @@ static ramfs_directory_t *root;
 // The total amount of directories and files.
 static int totalEntryCount = 0;
 
-// Lock to protect file system structure on simultaneous access.
-static spinlock_t ramfsLock = SPIN_UNLOCKED;
+// Lock to protect file system structure on simultaneous access. Not used by interrupt handlers, so interrupts stay enabled.
+// Lookups only need to read the structure, so they can run in parallel.
+static rwlock_t ramfsLock = RWLOCK_UNLOCKED;
 
 // Active file handles.
 #define FILE_HANDLE_COUNT 64
@@ -141,14 +142,24 @@ void ramfs_init()
         fileHandles[i].active = false;
 }
 
-static void acquire_lock()
+static void acquire_read_lock()
 {
-    spin_lock(&ramfsLock);
+    rw_rlock_plain(&ramfsLock);
 }
 
-static void release_lock()
+static void release_read_lock()
 {
-    spin_unlock(&ramfsLock);
+    rw_runlock_plain(&ramfsLock);
+}
+
+static void acquire_write_lock()
+{
+    rw_wlock_plain(&ramfsLock);
+}
+
+static void release_write_lock()
+{
+    rw_wunlock_plain(&ramfsLock);
 }
 
 // Traverses the directory tree according to the given path and returns a pointer to the most deeply nested directory.
@@ -259,7 +270,7 @@ ramfs_err_t ramfs_create_directory(const char *path, const char *name)
         if(*n == '/')
             return RAMFS_ERR_ILLEGAL_CHARACTER;
 
-    acquire_lock();
+    acquire_write_lock();
 
     // Get sub directory where the new directory shall be placed in
     ramfs_directory_t *parentDirectory;
@@ -267,7 +278,7 @@ ramfs_err_t ramfs_create_directory(const char *path, const char *name)
     ramfs_err_t err = get_directory(path, pathLength, &parentDirectory);
     if(err != RAMFS_ERR_OK)
     {
-        release_lock();
+        release_write_lock();
         return err;
     }
 
@@ -275,7 +286,7 @@ ramfs_err_t ramfs_create_directory(const char *path, const char *name)
     for(ramfs_directory_t *subDir = parentDirectory->firstChild; subDir; subDir = subDir->next)
         if(strcmp(subDir->name, name) == 0)
         {
-            release_lock();
+            release_write_lock();
             return RAMFS_ERR_DIRECTORY_EXISTS;
         }
 
@@ -298,7 +309,7 @@ ramfs_err_t ramfs_create_directory(const char *path, const char *name)
     ++totalEntryCount;
 
     // Done
-    release_lock();
+    release_write_lock();
     return RAMFS_ERR_OK;
 }
 
@@ -311,7 +322,7 @@ ramfs_err_t ramfs_test_directory(const char *path, const char *name)
         if(*n == '/')
             return RAMFS_ERR_ILLEGAL_CHARACTER;
 
-    acquire_lock();
+    acquire_read_lock();
 
     // Get sub directory where the new directory shall be placed in
     ramfs_directory_t *parentDirectory;
@@ -319,7 +330,7 @@ ramfs_err_t ramfs_test_directory(const char *path, const char *name)
     ramfs_err_t err = get_directory(path, pathLength, &parentDirectory);
     if(err != RAMFS_ERR_OK)
     {
-        release_lock();
+        release_read_lock();
         return err;
     }
 
@@ -327,12 +338,12 @@ ramfs_err_t ramfs_test_directory(const char *path, const char *name)
     for(ramfs_directory_t *subDir = parentDirectory->firstChild; subDir; subDir = subDir->next)
         if(strcmp(subDir->name, name) == 0)
         {
-            release_lock();
+            release_read_lock();
             return RAMFS_ERR_DIRECTORY_EXISTS;
         }
 
     // Directory does not exist yet
-    release_lock();
+    release_read_lock();
     return RAMFS_ERR_DIRECTORY_DOES_NOT_EXIST;
 }
 
@@ -379,53 +390,73 @@ static ramfs_err_t create_file(ramfs_directory_t *directory, const char *name, r
     return RAMFS_ERR_OK;
 }
 
-ramfs_err_t ramfs_open(const char *path, ramfs_fd_t *fdPtr, bool create)
+// Reserves an unused file handle. Handles are claimed atomically, so this does not need the file system lock.
+static int claim_file_handle()
 {
-    acquire_lock();
+    for(int i = 0; i < FILE_HANDLE_COUNT; ++i)
+    {
+        bool active = false;
+        if(__atomic_compare_exchange_n(&fileHandles[i].active, &active, true, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return i;
+    }
+    return RAMFS_FD_INVALID;
+}
 
+// Points the given claimed file handle to the beginning of the given file.
+static void init_file_handle(int fd, ramfs_file_t *file)
+{
+    ramfs_file_handle_t *handle = &fileHandles[fd];
+    handle->file = file;
+    handle->position = 0;
+    handle->currentBlock = file->firstBlock;
+    handle->currentBlockPosition = 0;
+    file->isOpen = true;
+}
+
+ramfs_err_t ramfs_open(const char *path, ramfs_fd_t *fdPtr, bool create)
+{
     // Check for available file handle
-    int fd = RAMFS_FD_INVALID;
-    for(int i = 0; i < FILE_HANDLE_COUNT; ++i)
-        if(!fileHandles[i].active)
-        {
-            fd = i;
-            break;
-        }
+    int fd = claim_file_handle();
     if(fd == RAMFS_FD_INVALID)
-    {
-        release_lock();
         return RAMFS_ERR_TOO_MANY_OPEN_FILES;
-    }
 
     // Get file info struct
+    // Most files exist already, so try with the shared lock first
     const char *fileNameStart; // Position of filename in path string
     ramfs_file_t *file;
     ramfs_directory_t *directory;
+    acquire_read_lock();
     ramfs_err_t err = get_file_entry(path, &fileNameStart, &file, &directory);
-    if(err == RAMFS_ERR_FILE_DOES_NOT_EXIST && create)
+    if(err == RAMFS_ERR_OK)
     {
-        // File does not exist yet, create it
-        err = create_file(directory, fileNameStart, &file);
+        init_file_handle(fd, file);
+        release_read_lock();
+        *fdPtr = fd;
+        return RAMFS_ERR_OK;
     }
-    if(err != RAMFS_ERR_OK)
+    release_read_lock();
+
+    if(err == RAMFS_ERR_FILE_DOES_NOT_EXIST && create)
     {
-        release_lock();
-        return err;
+        // File does not exist yet, create it
+        // Look it up again, someone else might have created it in the meantime
+        acquire_write_lock();
+        err = get_file_entry(path, &fileNameStart, &file, &directory);
+        if(err == RAMFS_ERR_FILE_DOES_NOT_EXIST)
+            err = create_file(directory, fileNameStart, &file);
+        if(err == RAMFS_ERR_OK)
+        {
+            init_file_handle(fd, file);
+            release_write_lock();
+            *fdPtr = fd;
+            return RAMFS_ERR_OK;
+        }
+        release_write_lock();
     }
 
-    // Initialize handle
-    ramfs_file_handle_t *handle = &fileHandles[fd];
-    handle->active = true;
-    handle->file = file;
-    handle->position = 0;
-    handle->currentBlock = file->firstBlock;
-    handle->currentBlockPosition = 0;
-    *fdPtr = fd;
-    file->isOpen = true;
-
-    // Done
-    release_lock();
-    return RAMFS_ERR_OK;
+    // Failed, give back file handle
+    __atomic_store_n(&fileHandles[fd].active, false, __ATOMIC_RELEASE);
+    return err;
 }
 
 void ramfs_close(ramfs_fd_t fd)
@@ -436,7 +467,7 @@ void ramfs_close(ramfs_fd_t fd)
 
     // Close handle
     fileHandles[fd].file->isOpen = false;
-    fileHandles[fd].active = false;
+    __atomic_store_n(&fileHandles[fd].active, false, __ATOMIC_RELEASE);
 }
 
 uint64_t ramfs_read(uint8_t *buffer, uint64_t length, ramfs_fd_t fd)
@@ -613,7 +644,7 @@ void ramfs_seek(int64_t offset, ramfs_seek_whence_t whence, ramfs_fd_t fd)
 
 ramfs_err_t ramfs_delete(const char *path)
 {
-    acquire_lock();
+    acquire_write_lock();
 
     // Get file info struct
     const char *fileNameStart; // Position of filename in path string
@@ -622,14 +653,14 @@ ramfs_err_t ramfs_delete(const char *path)
     ramfs_err_t err = get_file_entry(path, &fileNameStart, &file, &directory);
     if(err != RAMFS_ERR_OK)
     {
-        release_lock();
+        release_write_lock();
         return err;
     }
 
     // The file must not be open
     if(file->isOpen)
     {
-        release_lock();
+        release_write_lock();
         return RAMFS_ERR_FILE_ALREADY_OPEN;
     }
 
@@ -670,18 +701,21 @@ ramfs_err_t ramfs_delete(const char *path)
     free(file);
 
     // Done
-    release_lock();
+    release_write_lock();
     return RAMFS_ERR_OK;
 }
 
 int ramfs_list(const char *path, char *buffer, int bufferLength)
 {
-    acquire_lock();
+    acquire_read_lock();
 
     // Get directory info
     ramfs_directory_t *directory;
     if(get_directory(path, strlen(path), &directory) != RAMFS_ERR_OK)
+    {
+        release_read_lock();
         return 0;
+    }
 
     // Current writing position in buffer
     int bufferPos = 0;
@@ -816,6 +850,6 @@ int ramfs_list(const char *path, char *buffer, int bufferLength)
     }
 
     // Done
-    release_lock();
+    release_read_lock();
     return bufferPos;
 }
\ No newline at end of file
@@ -92,3 +92,48 @@ const char *cmdline_get(const char *key)
 
   return 0;
 }
+
+// Parses a decimal number and advances the string pointer.
+static int cmdline_parse_int(const char **str)
+{
+  int value = 0;
+  while (**str >= '0' && **str <= '9')
+  {
+    value = 10 * value + (**str - '0');
+    (*str)++;
+  }
+  return value;
+}
+
+uint64_t cmdline_get_cpu_mask(const char *key)
+{
+  const char *list = cmdline_get(key);
+  if (!list)
+    return 0;
+
+  uint64_t mask = 0;
+  while (*list)
+  {
+    if (*list < '0' || *list > '9')
+      panic("malformed core list for %s", key);
+
+    /* single core or range */
+    int first = cmdline_parse_int(&list);
+    int last = first;
+    if (*list == '-')
+    {
+      list++;
+      last = cmdline_parse_int(&list);
+    }
+
+    for (int c = first; c <= last && c < 64; c++)
+      mask |= 1ULL << c;
+
+    if (*list == ',')
+      list++;
+    else if (*list)
+      panic("malformed core list for %s", key);
+  }
+
+  return mask;
+}
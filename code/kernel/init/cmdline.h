@@ -3,8 +3,13 @@
 #define _CMDLINE_H
 
 #include <init/multiboot.h>
+#include <stdint.h>
 
 void cmdline_init(multiboot_t *multiboot);
 const char *cmdline_get(const char *key);
 
+// Parses a list of core IDs like "1,3-5" given for the given key, and returns it as bit mask (max. 64 cores).
+// Returns 0 if the key is not present.
+uint64_t cmdline_get_cpu_mask(const char *key);
+
 #endif
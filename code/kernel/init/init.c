@@ -10,6 +10,8 @@
 #include <mm/tlb.h>
 #include <bus/isa.h>
 #include <cpu/features.h>
+#include <cpu/xsave.h>
+#include <cpu/fpu.h>
 #include <cpu/gdt.h>
 #include <cpu/tss.h>
 #include <cpu/idt.h>
@@ -28,7 +30,10 @@
 #include <proc/syscall.h>
 #include <proc/module.h>
 #include <proc/idle.h>
+#include <proc/workqueue.h>
+#include <proc/reaper.h>
 #include <lock/intr.h>
+#include <lock/rcu.h>
 #include <stdlib/string.h>
 #include <stdbool.h>
 #include <vbe/vbe.h>
@@ -103,6 +108,7 @@ noreturn void init(uint32_t magic, multiboot_t *multiboot)
 
 	/* scan CPU features */
 	cpu_features_init();
+	string_init();
 	enable1gPages = cpu_feature_supported(FEATURE_1G_PAGE);
 	enable2mPages = true;
 
@@ -122,6 +128,10 @@ noreturn void init(uint32_t magic, multiboot_t *multiboot)
 	trace_puts("Setting up the heap...\n");
 	heap_init();
 
+	// Select XSAVE variant and determine the size of the vector state area
+	xsave_init();
+	kernel_fpu_init();
+
 	// Output heap state
 	//trace_puts("Heap alloc test...\n");
 	heap_trace();
@@ -175,6 +185,7 @@ noreturn void init(uint32_t magic, multiboot_t *multiboot)
 	}
 
 	/* route IPIs */
+	rcu_init();
 	panic_init();
 	fault_init();
 	tlb_init();
@@ -182,6 +193,12 @@ noreturn void init(uint32_t magic, multiboot_t *multiboot)
 	/* set up idle process, this must be done before we are in SMP mode */
 	idle_init();
 	
+	// Start thread which frees dead threads and processes
+	reaper_init();
+	
+	// Start per-CPU worker threads for deferred work
+	workqueue_init();
+	
 	// Set interrupt stack pointer for bootstrap processor
     tss_set_rsp0(cpu_get()->idle_thread->rsp);
 	
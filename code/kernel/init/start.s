@@ -14,6 +14,7 @@ EFER_LM equ 0x100
 EFER_NX equ 0x800
 
 ; CR0 bitmasks
+CR0_WP equ 0x10000
 CR0_PAGING equ 0x80000000
 
 ; CR4 bitmasks
@@ -196,9 +197,9 @@ start:
 	mov eax, boot_pml4
 	mov cr3, eax
 
-	; enable paging
+	; enable paging, and honour read-only pages in kernel mode, so copy_to_user() cannot write to them
 	mov eax, cr0
-	or eax, CR0_PAGING
+	or eax, (CR0_PAGING + CR0_WP)
 	mov cr0, eax
 
 	; leave compatibility mode
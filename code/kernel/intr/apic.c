@@ -3,6 +3,9 @@
 #include <time/apic.h>
 #include <time/pit.h>
 #include <cpu/msr.h>
+#include <cpu/tsc.h>
+#include <cpu/cpuid.h>
+#include <cpu/pause.h>
 #include <cpu/state.h>
 #include <intr/common.h>
 #include <lock/spinlock.h>
@@ -11,11 +14,11 @@
 #include <mm/mmio.h>
 #include <smp/cpu.h>
 #include <trace/trace.h>
-#include <lock/raw_spinlock.h>
 
 #define MSR_X2APIC_MMIO 0x800
 
 /* common registers */
+#define APIC_ID         0x02
 #define APIC_TPR        0x08
 #define APIC_EOI        0x0B
 #define APIC_SVR        0x0F
@@ -105,24 +108,51 @@ void apic_write(size_t reg, uint64_t val)
     apic_mmio[reg * 4] = val;
 }
 
-static void apic_timer_calibrate(void)
+// Timer frequencies determined by the BSP, which are shared with the APs.
+static uint32_t apic_ticks_per_ms_calibrated = 0;
+static uint64_t tsc_ticks_per_ms_calibrated = 0;
+
+// Determines the APIC timer and TSC frequencies from CPUID leaf 0x15, if the core crystal clock frequency is reported.
+// The APIC timer runs at the crystal clock in this case.
+static bool apic_timer_frequency_cpuid(void)
 {
-  // Use the PIT timer to measure amount of ticks the APIC timer counts in 10ms
-  cpu_t *cpu = cpu_get();
+  uint32_t maxLeaf, denominator, numerator, crystalHz, tmp;
+  cpu_id_special(0x00, 0x00, &maxLeaf, &tmp, &tmp, &tmp);
+  if (maxLeaf < 0x15)
+    return false;
 
-  // Use interrupt-free spinlock to avoid blocking the PIT delay interrupt
-  static raw_spinlock_t apic_calibrate_lock = RAW_SPINLOCK_UNLOCKED;
-  raw_spinlock_lock(&apic_calibrate_lock);
+  cpu_id_special(0x15, 0x00, &denominator, &numerator, &crystalHz, &tmp);
+  if (denominator == 0 || numerator == 0 || crystalHz == 0)
+    return false;
 
-  apic_write(APIC_LVT_TIMER, LVT_MASKED);
-  apic_write(APIC_TIMER_ICR, 0xFFFFFFFF);
-  apic_write(APIC_TIMER_DCR, DCR_16);
-  pit_mdelay(10);
-  uint32_t ticks = 0xFFFFFFFF - apic_read(APIC_TIMER_CCR);
+  apic_ticks_per_ms_calibrated = crystalHz / 1000;
+  tsc_ticks_per_ms_calibrated = (uint64_t) crystalHz * numerator / denominator / 1000;
+  return true;
+}
+
+static void apic_timer_calibrate(void)
+{
+  cpu_t *cpu = cpu_get();
 
-  cpu->apic_ticks_per_ms = ticks * 16 / 10;
+  // The frequencies are the same on all cores, so only the BSP determines them; this keeps the APs from serializing
+  // on the PIT during boot
+  if (cpu->bsp && !apic_timer_frequency_cpuid())
+  {
+    // Use the PIT timer to measure amount of ticks the APIC timer and the TSC count in 10ms
+    apic_write(APIC_LVT_TIMER, LVT_MASKED);
+    apic_write(APIC_TIMER_ICR, 0xFFFFFFFF);
+    apic_write(APIC_TIMER_DCR, DCR_16);
+    uint64_t tscStart = tsc_read();
+    pit_mdelay(10);
+    uint32_t ticks = 0xFFFFFFFF - apic_read(APIC_TIMER_CCR);
+    uint64_t tscEnd = tsc_read();
+
+    apic_ticks_per_ms_calibrated = ticks * 16 / 10;
+    tsc_ticks_per_ms_calibrated = (tscEnd - tscStart) / 10;
+  }
 
-  raw_spinlock_unlock(&apic_calibrate_lock);
+  cpu->apic_ticks_per_ms = apic_ticks_per_ms_calibrated;
+  cpu->tsc_ticks_per_ms = tsc_ticks_per_ms_calibrated;
 }
 
 void apic_timer_install_handler(intr_handler_t handler)
@@ -139,6 +169,11 @@ void apic_monotonic(int ms)
   apic_write(APIC_TIMER_DCR, DCR_16);
 }
 
+void apic_timer_stop(void)
+{
+  apic_write(APIC_LVT_TIMER, LVT_MASKED);
+}
+
 bool xapic_init(uintptr_t addr)
 {
   apic_phy_addr = addr;
@@ -202,6 +237,18 @@ void apic_ack(void)
   apic_write(APIC_EOI, 0);
 }
 
+cpu_lapic_id_t apic_get_id(void)
+{
+  // APs call this before their APIC is switched to x2APIC mode, so use CPUID there, which reports the full x2APIC ID
+  if (apic_mode == MODE_X2APIC)
+  {
+    uint32_t id, tmp;
+    cpu_id_special(0x0B, 0x00, &tmp, &tmp, &tmp, &id);
+    return id;
+  }
+  return apic_mmio[APIC_ID * 4] >> 24;
+}
+
 static void apic_ipi(uint64_t icr)
 {
   if (apic_mode == MODE_X2APIC)
@@ -211,6 +258,10 @@ static void apic_ipi(uint64_t icr)
   }
   else
   {
+    // Wait until a previous IPI was sent, else back-to-back IPIs (e.g. when starting the APs) might get lost
+    while (apic_read(XAPIC_ICRL) & ICR_DELIVS)
+      pause_once();
+
     /* write the high (must be first!) and low parts of the ICR */
     apic_write(XAPIC_ICRH, (icr >> 32) & 0xFFFFFFFF);
     apic_write(XAPIC_ICRL, icr & 0xFFFFFFFF);
@@ -13,6 +13,9 @@ void x2apic_init(void);          /* init in x2APIC mode using MSRs */
 /* enable this CPU's APIC */
 void apic_init(void);
 
+// Returns the local APIC ID of the current CPU.
+cpu_lapic_id_t apic_get_id(void);
+
 /* acknowledge an interrupt */
 void apic_ack(void);
 
@@ -88,6 +88,8 @@
 #define NOT_INTR 0xFA
 
 /* IPIs */
+#define IPI_RCU     0xF8
+#define IPI_RESCHED 0xF9
 #define IPI_PANIC 0xFB
 #define IPI_TLB   0xFC
 
@@ -4,6 +4,7 @@
 #include <intr/route.h>
 #include <panic/panic.h>
 #include <mm/common.h>
+#include <mm/uaccess.h>
 #include <proc/thread.h>
 #include <trace/trace.h>
 #include <smp/cpu.h>
@@ -69,6 +70,10 @@ void fault_handle(cpu_state_t *state)
 	{
 		case FAULT_PAGE_FAULT:
 		{
+			// Access to user memory on behalf of a system call?
+			if((state->cs & 3) == 0 && uaccess_handle_fault(state))
+				return;
+			
 			// User space?
 			if(state->rip <= VM_USER_END)
 			{
@@ -3,8 +3,11 @@
 #include <intr/apic.h>
 #include <intr/ioapic.h>
 #include <intr/pic.h>
-#include <lock/rwlock.h>
+#include <lock/spinlock.h>
+#include <lock/rcu.h>
+#include <cpu/flags.h>
 #include <smp/mode.h>
+#include <proc/sched.h>
 #include <util/container.h>
 #include <util/list.h>
 #include <panic/panic.h>
@@ -12,14 +15,17 @@
 #include <stdlib/stdlib.h>
 #include <trace/trace.h>
 
-typedef struct intr_handler_node
+// Handlers of an interrupt vector. A published table is never modified, updates replace the whole table (RCU), so
+// interrupt dispatch does not need any lock.
+typedef struct
 {
-  intr_handler_t handler;
-  list_node_t node;
-} intr_handler_pair_t;
+  int count;
+  intr_handler_t handlers[];
+} intr_handler_table_t;
 
-static rwlock_t intr_route_lock = RWLOCK_UNLOCKED;
-static list_t intr_handlers[INTERRUPTS];
+/* serializes updates of the handler tables and the I/O APIC routing */
+static spinlock_t intr_route_lock = SPIN_UNLOCKED;
+static intr_handler_table_t *intr_handlers[INTERRUPTS];
 
 void intr_dispatch(cpu_state_t *state)
 {
@@ -37,53 +43,89 @@ void intr_dispatch(cpu_state_t *state)
   }
 
   /* if there is no handler panic (this is for debugging purposes) */
-  rw_rlock(&intr_route_lock);
-  list_t *handler_list = &intr_handlers[state->id];
-  if (handler_list->size == 0)
+  // Interrupt handlers are RCU read-side sections, the table stays valid until we are done
+  intr_handler_table_t *table = __atomic_load_n(&intr_handlers[intr], __ATOMIC_ACQUIRE);
+  if (!table)
     trace_printf("WARNING: Unhandled interrupt %d at %0#18x\n", state->id, state->rip);
-
-  /* call all the handlers */
-  list_for_each(handler_list, node)
+  else
   {
-    intr_handler_pair_t *pair = container_of(node, intr_handler_pair_t, node);
-
-    intr_handler_t handler = pair->handler;
-    (*handler)(state);
+    /* call all the handlers */
+    for (int i = 0; i < table->count; ++i)
+      table->handlers[i](state);
   }
-  rw_runlock(&intr_route_lock);
+
+  // The interrupted code cannot be in a read-side section if it had interrupts enabled
+  if (state->rflags & FLAGS_IF)
+    rcu_quiescent_state();
+
+  /* switch to a thread woken up by a handler, if it takes precedence */
+  sched_irq_exit(state);
 }
 
-static bool _intr_route_intr(intr_t intr, intr_handler_t handler)
+// Publishes a copy of the handler table of the given interrupt with the given handler added. The replaced table is
+// returned in *retired, it must be passed to intr_retire_table() after the route lock was released.
+static bool _intr_route_intr(intr_t intr, intr_handler_t handler, intr_handler_table_t **retired)
 {
-  /* allocate the handler pair */
-  intr_handler_pair_t *pair = malloc(sizeof(*pair));
-  if (!pair)
+  intr_handler_table_t *old = intr_handlers[intr];
+  int count = old ? old->count : 0;
+
+  intr_handler_table_t *table = malloc(sizeof(*table) + (count + 1) * sizeof(intr_handler_t));
+  if (!table)
     return false;
 
-  /* fill it out */
-  pair->handler = handler;
+  table->count = count + 1;
+  for (int i = 0; i < count; ++i)
+    table->handlers[i] = old->handlers[i];
+  table->handlers[count] = handler;
 
-  /* adds it to the handler list */
-  list_add_tail(&intr_handlers[intr], &pair->node);
+  __atomic_store_n(&intr_handlers[intr], table, __ATOMIC_RELEASE);
+  *retired = old;
   return true;
 }
 
-static void _intr_unroute_intr(intr_t intr, intr_handler_t handler)
+// Publishes a copy of the handler table of the given interrupt with the given handler removed (see _intr_route_intr()).
+static void _intr_unroute_intr(intr_t intr, intr_handler_t handler, intr_handler_table_t **retired)
 {
-  /* find the handler pair */
-  list_for_each(&intr_handlers[intr], node)
+  intr_handler_table_t *old = intr_handlers[intr];
+  if (!old)
+    return;
+
+  /* find the handler */
+  int index = -1;
+  for (int i = 0; i < old->count && index < 0; ++i)
+    if (old->handlers[i] == handler)
+      index = i;
+  if (index < 0)
+    return;
+
+  intr_handler_table_t *table = 0;
+  if (old->count > 1)
   {
-    intr_handler_pair_t *pair = container_of(node, intr_handler_pair_t, node);
-    if (pair->handler == handler)
+    table = malloc(sizeof(*table) + (old->count - 1) * sizeof(intr_handler_t));
+    if (!table)
     {
-      /* unlink it from the list */
-      list_remove(&intr_handlers[intr], &pair->node);
-
-      /* free it */
-      free(pair);
+      trace_printf("WARNING: Could not unroute handler of interrupt %d\n", intr);
       return;
     }
+
+    table->count = 0;
+    for (int i = 0; i < old->count; ++i)
+      if (i != index)
+        table->handlers[table->count++] = old->handlers[i];
   }
+
+  __atomic_store_n(&intr_handlers[intr], table, __ATOMIC_RELEASE);
+  *retired = old;
+}
+
+// Frees the given replaced handler table, once no core can be dispatching through it anymore.
+static void intr_retire_table(intr_handler_table_t *table)
+{
+  if (!table)
+    return;
+
+  rcu_synchronize();
+  free(table);
 }
 
 bool _intr_route_irq(irq_tuple_t *tuple, intr_t intr)
@@ -143,39 +185,44 @@ void _intr_unroute_irq(irq_tuple_t *tuple)
 
 bool intr_route_intr(intr_t intr, intr_handler_t handler)
 {
-  rw_wlock(&intr_route_lock);
-  bool ok = _intr_route_intr(intr, handler);
-  rw_wunlock(&intr_route_lock);
+  intr_handler_table_t *retired = 0;
+  spin_lock(&intr_route_lock);
+  bool ok = _intr_route_intr(intr, handler, &retired);
+  spin_unlock(&intr_route_lock);
+  intr_retire_table(retired);
   return ok;
 }
 
 void intr_unroute_intr(intr_t intr, intr_handler_t handler)
 {
-  rw_wlock(&intr_route_lock);
-  _intr_unroute_intr(intr, handler);
-  rw_wunlock(&intr_route_lock);
+  intr_handler_table_t *retired = 0;
+  spin_lock(&intr_route_lock);
+  _intr_unroute_intr(intr, handler, &retired);
+  spin_unlock(&intr_route_lock);
+  intr_retire_table(retired);
 }
 
 bool intr_route_irq_to(irq_tuple_t *tuple, intr_t intr)
 {
-  rw_wlock(&intr_route_lock);
+  spin_lock(&intr_route_lock);
   bool ok = _intr_route_irq(tuple, intr);
-  rw_wunlock(&intr_route_lock);
+  spin_unlock(&intr_route_lock);
   return ok;
 }
 
 void intr_unroute_irq_to(irq_tuple_t *tuple, intr_t intr)
 {
-  rw_wlock(&intr_route_lock);
+  spin_lock(&intr_route_lock);
   _intr_unroute_irq(tuple);
-  rw_wunlock(&intr_route_lock);
+  spin_unlock(&intr_route_lock);
 }
 
 bool intr_route_irq(irq_tuple_t *tuple, intr_handler_t handler)
 {
   intr_t intr = IRQ0 + tuple->irq % IRQS;
+  intr_handler_table_t *retired = 0;
 
-  rw_wlock(&intr_route_lock);
+  spin_lock(&intr_route_lock);
 
   if (smp_mode == MODE_UP)
   {
@@ -187,29 +234,31 @@ bool intr_route_irq(irq_tuple_t *tuple, intr_handler_t handler)
     bool ok = _intr_route_irq(tuple, intr);
     if (!ok)
     {
-      rw_wunlock(&intr_route_lock);
+      spin_unlock(&intr_route_lock);
       return false;
     }
   }
 
-  if (!_intr_route_intr(intr, handler))
+  if (!_intr_route_intr(intr, handler, &retired))
   {
     _intr_unroute_irq(tuple);
-    rw_wunlock(&intr_route_lock);
+    spin_unlock(&intr_route_lock);
     return false;
   }
 
-  rw_wunlock(&intr_route_lock);
+  spin_unlock(&intr_route_lock);
+  intr_retire_table(retired);
   return true;
 }
 
 void intr_unroute_irq(irq_tuple_t *tuple, intr_handler_t handler)
 {
   intr_t intr = IRQ0 + tuple->irq % IRQS;
+  intr_handler_table_t *retired = 0;
 
-  rw_wlock(&intr_route_lock);
+  spin_lock(&intr_route_lock);
 
-  _intr_unroute_intr(intr, handler);
+  _intr_unroute_intr(intr, handler, &retired);
 
   if (smp_mode == MODE_UP)
   {
@@ -221,5 +270,6 @@ void intr_unroute_irq(irq_tuple_t *tuple, intr_handler_t handler)
     _intr_unroute_irq(tuple);
   }
 
-  rw_wunlock(&intr_route_lock);
+  spin_unlock(&intr_route_lock);
+  intr_retire_table(retired);
 }
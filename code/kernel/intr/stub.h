@@ -62,6 +62,8 @@ void irq22(void);
 void irq23(void);
 
 void ipi_route(void);
+void ipi_rcu(void);
+void ipi_resched(void);
 void ipi_panic(void);
 void ipi_tlb(void);
 void lvt_timer(void);
@@ -26,6 +26,20 @@ irq%1:
   jmp intr_stub
 %endmacro
 
+; RCU IPI entry code
+[global ipi_rcu]
+ipi_rcu:
+  push 0
+  push 0xF8
+  jmp intr_stub
+
+; reschedule IPI entry code
+[global ipi_resched]
+ipi_resched:
+  push 0
+  push 0xF9
+  jmp intr_stub
+
 ; panic IPI entry code
 [global ipi_panic]
 ipi_panic:
@@ -88,9 +102,11 @@ intr_stub:
   push rbx
   push rax
 
-  ; check if we are switching from user mode to supervisor mode
-  mov rax, [rsp + 152]
-  and rax, 0x3000
+  ; check if we are switching from user mode to supervisor mode (RPL of the
+  ; interrupted CS selector; system calls run with the user's IOPL, so RFLAGS
+  ; cannot be used for this)
+  mov rax, [rsp + 144]
+  and rax, 0x3
   jz .supervisor_enter
 
   ; restore the kernel's GS base if we are going from user to supervisor mode
@@ -111,8 +127,8 @@ intr_stub:
   dec qword [gs:8]
 
   ; check if we are switching from supervisor to user mode
-  mov rax, [rsp + 152]
-  and rax, 0x3000
+  mov rax, [rsp + 144]
+  and rax, 0x3
   jz .supervisor_exit
 
   ; switch back to the user's GS base if we are going from supervisor to user mode
@@ -71,19 +71,22 @@ static void _handle_key_press(cpu_state_t *UNUSED_state)
 	// Send key press message
 	if(pressed)
 	{
-		// Create message
-		bool shiftModifier = pressedKeys[VKEY_LSHIFT] || pressedKeys[VKEY_RSHIFT];
-		msg_header_t *keypressMsg = msg_create_keypress(keyCode, shiftModifier);
+		// Create message, it is copied into the receiver's message ring
+		msg_key_press_t keypressMsg;
+		keypressMsg.header.type = MSG_KEY_PRESS;
+		keypressMsg.header.size = sizeof(msg_key_press_t);
+		keypressMsg.shiftModifier = pressedKeys[VKEY_LSHIFT] || pressedKeys[VKEY_RSHIFT];
+		keypressMsg.keyCode = keyCode;
 
 		// Send Fx keys always to the UI process
 		if(VKEY_F1 <= keyCode && keyCode <= VKEY_F12)
 		{
 			// Key not pressed yet?
 			if(!pressedKeys[keyCode])
-				msg_send(MSG_DEST_UI_PROCESS, keypressMsg);
+				msg_send(MSG_DEST_UI_PROCESS, &keypressMsg.header);
 		}
 		else
-			msg_send(MSG_DEST_VISIBLE_PROCESS, keypressMsg);
+			msg_send(MSG_DEST_VISIBLE_PROCESS, &keypressMsg.header);
 	}
 	
 	// Update key state
@@ -6,10 +6,15 @@
 
 void intr_lock(void)
 {
+  /*
+   * mask interrupts before looking up the CPU, else the thread might be
+   * preempted and moved to another core in between. if the count is already
+   * non-zero, interrupts are masked anyway
+   */
+  intr_disable();
   cpu_t *cpu = cpu_get();
   assert(cpu->intr_mask_count != UINT64_MAX);
-  if (cpu->intr_mask_count++ == 0)
-    intr_disable();
+  cpu->intr_mask_count++;
 }
 
 void intr_unlock(void)
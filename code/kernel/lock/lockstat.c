@@ -0,0 +1,260 @@
+
+#include <lock/lockstat.h>
+#include <cpu/tsc.h>
+#include <fs/ramfs.h>
+#include <trace/stacktrace.h>
+#include <trace/trace.h>
+#include <stdlib/stdlib.h>
+#include <stdlib/string.h>
+
+#ifdef LOCKSTAT
+
+// Statistics of one call site.
+typedef struct
+{
+	uint64_t rip[LOCKSTAT_SITE_DEPTH];
+	uint64_t acquisitions;
+	uint64_t spinCycles;
+} lockstat_site_t;
+
+// Table entry of one lock. Only the lock field is written by non-holders.
+typedef struct
+{
+	// Address of the lock, 0 if the entry is unused.
+	uintptr_t lock;
+
+	// Time stamp of the current acquisition.
+	uint64_t acquiredAt;
+
+	uint64_t acquisitions;
+	uint64_t contended;
+	uint64_t spinCycles;
+	uint64_t spinCyclesMax;
+	uint64_t holdCycles;
+	uint64_t holdCyclesMax;
+	lockstat_site_t sites[LOCKSTAT_SITES];
+} lockstat_entry_t;
+
+// Open addressing hash table of all tracked locks.
+static lockstat_entry_t lockstatTable[LOCKSTAT_MAX_LOCKS];
+
+// Number of acquisitions of locks which did not fit into the table.
+static uint64_t lockstatUntracked = 0;
+
+// Returns the table entry of the given lock. If the lock is not tracked yet and insert is set, a free entry is claimed.
+// Returns 0 if the lock is not found or the table is full.
+static lockstat_entry_t *lockstat_find(spinlock_t *lock, bool insert)
+{
+	uintptr_t key = (uintptr_t)lock;
+	uint32_t hash = (uint32_t)(((key >> 3) * 0x9E3779B97F4A7C15ULL) >> 32);
+	for(int i = 0; i < LOCKSTAT_MAX_LOCKS; ++i)
+	{
+		lockstat_entry_t *entry = &lockstatTable[(hash + i) % LOCKSTAT_MAX_LOCKS];
+		uintptr_t current = __atomic_load_n(&entry->lock, __ATOMIC_ACQUIRE);
+		if(current == key)
+			return entry;
+		if(current != 0)
+			continue;
+
+		// Free entries terminate the probe sequence, as entries are never removed
+		if(!insert)
+			return 0;
+		if(__atomic_compare_exchange_n(&entry->lock, &current, key, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) || current == key)
+			return entry;
+	}
+	return 0;
+}
+
+// Counts an acquisition through the given call site. Only a few sites are kept per lock, so this uses the "space saving"
+// heuristic: An unknown site replaces the one with the fewest acquisitions and inherits its count. Frequent sites thus
+// stay in the table, but their counts may be overestimated by the count of the replaced site.
+static void lockstat_record_site(lockstat_entry_t *entry, uint64_t *rip, uint64_t spinCycles)
+{
+	lockstat_site_t *least = &entry->sites[0];
+	for(int s = 0; s < LOCKSTAT_SITES; ++s)
+	{
+		lockstat_site_t *site = &entry->sites[s];
+		if(memcmp(site->rip, rip, sizeof(site->rip)) == 0)
+		{
+			++site->acquisitions;
+			site->spinCycles += spinCycles;
+			return;
+		}
+		if(site->acquisitions < least->acquisitions)
+			least = site;
+	}
+
+	memcpy(least->rip, rip, sizeof(least->rip));
+	++least->acquisitions;
+	least->spinCycles = spinCycles;
+}
+
+void lockstat_acquired(spinlock_t *lock, bool contended, uint64_t spinCycles, uint64_t *frame, uint64_t caller)
+{
+	lockstat_entry_t *entry = lockstat_find(lock, true);
+	if(!entry)
+	{
+		__atomic_fetch_add(&lockstatUntracked, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	// We are the holder now, so the entry can be updated without further synchronization
+	++entry->acquisitions;
+	if(contended)
+		++entry->contended;
+	entry->spinCycles += spinCycles;
+	if(spinCycles > entry->spinCyclesMax)
+		entry->spinCyclesMax = spinCycles;
+
+	// Identify call site
+	uint64_t rip[LOCKSTAT_SITE_DEPTH] = { 0 };
+	if(stacktrace_collect(frame, rip, LOCKSTAT_SITE_DEPTH) == 0)
+		rip[0] = caller;
+	lockstat_record_site(entry, rip, spinCycles);
+
+	entry->acquiredAt = tsc_read();
+}
+
+void lockstat_released(spinlock_t *lock)
+{
+	lockstat_entry_t *entry = lockstat_find(lock, false);
+	if(!entry)
+		return;
+
+	// The lock is held with masked interrupts or disabled preemption, so both time stamps are from the same core
+	uint64_t holdCycles = tsc_read() - entry->acquiredAt;
+	entry->holdCycles += holdCycles;
+	if(holdCycles > entry->holdCyclesMax)
+		entry->holdCyclesMax = holdCycles;
+}
+
+// Copies the given string, truncating it if necessary.
+static void lockstat_copy_name(char *dest, const char *name)
+{
+	if(name)
+		strncpy(dest, name, LOCKSTAT_NAME_LENGTH - 1);
+	dest[LOCKSTAT_NAME_LENGTH - 1] = '\0';
+}
+
+// Fills the exported statistics of the given entry. The lock might be in use, so the values are not necessarily
+// consistent with each other.
+static void lockstat_fill_info(lockstat_entry_t *entry, lockstat_info_t *info)
+{
+	memclr(info, sizeof(lockstat_info_t));
+	info->lock = entry->lock;
+	lockstat_copy_name(info->name, stacktrace_lookup_object(entry->lock));
+	info->acquisitions = entry->acquisitions;
+	info->contended = entry->contended;
+	info->spinCycles = entry->spinCycles;
+	info->spinCyclesMax = entry->spinCyclesMax;
+	info->holdCycles = entry->holdCycles;
+	info->holdCyclesMax = entry->holdCyclesMax;
+
+	// Copy call sites, sorted by acquisition count
+	int siteCount = 0;
+	for(int s = 0; s < LOCKSTAT_SITES; ++s)
+	{
+		lockstat_site_t site = entry->sites[s];
+		if(site.acquisitions == 0)
+			continue;
+
+		int pos = siteCount++;
+		while(pos > 0 && info->sites[pos - 1].acquisitions < site.acquisitions)
+		{
+			info->sites[pos] = info->sites[pos - 1];
+			--pos;
+		}
+
+		lockstat_site_info_t *siteInfo = &info->sites[pos];
+		memclr(siteInfo, sizeof(lockstat_site_info_t));
+		for(int d = 0; d < LOCKSTAT_SITE_DEPTH; ++d)
+		{
+			siteInfo->rip[d] = site.rip[d];
+			if(site.rip[d])
+				lockstat_copy_name(siteInfo->names[d], stacktrace_lookup_sym(site.rip[d]));
+		}
+		siteInfo->acquisitions = site.acquisitions;
+		siteInfo->spinCycles = site.spinCycles;
+	}
+}
+
+int lockstat_get(lockstat_info_t *infos, int maxCount, uint64_t *untrackedAcquisitions)
+{
+	*untrackedAcquisitions = __atomic_load_n(&lockstatUntracked, __ATOMIC_RELAXED);
+	if(maxCount <= 0)
+		return 0;
+
+	// Select the locks with the highest spin time
+	lockstat_entry_t **top = malloc(maxCount * sizeof(lockstat_entry_t *));
+	if(!top)
+		return 0;
+	int count = 0;
+	for(int e = 0; e < LOCKSTAT_MAX_LOCKS; ++e)
+	{
+		lockstat_entry_t *entry = &lockstatTable[e];
+		if(__atomic_load_n(&entry->lock, __ATOMIC_ACQUIRE) == 0)
+			continue;
+
+		int pos = count < maxCount ? count++ : maxCount;
+		while(pos > 0 && top[pos - 1]->spinCycles < entry->spinCycles)
+		{
+			if(pos < maxCount)
+				top[pos] = top[pos - 1];
+			--pos;
+		}
+		if(pos < maxCount)
+			top[pos] = entry;
+	}
+
+	for(int i = 0; i < count; ++i)
+		lockstat_fill_info(top[i], &infos[i]);
+	free(top);
+	return count;
+}
+
+void lockstat_dump(const char *filePath)
+{
+	ramfs_fd_t fd;
+	if(ramfs_open(filePath, &fd, true) != RAMFS_ERR_OK)
+	{
+		trace_printf("Error opening lock statistics output file.\n");
+		return;
+	}
+
+	// Count tracked locks first, the table may grow while writing, so the count is fixed here
+	uint32_t count = 0;
+	for(int e = 0; e < LOCKSTAT_MAX_LOCKS; ++e)
+		if(__atomic_load_n(&lockstatTable[e].lock, __ATOMIC_ACQUIRE) != 0)
+			++count;
+	ramfs_write((uint8_t *)&count, sizeof(count), fd);
+
+	// Write entries one at a time, the ramfs lock itself is tracked
+	uint32_t written = 0;
+	lockstat_info_t info;
+	for(int e = 0; e < LOCKSTAT_MAX_LOCKS && written < count; ++e)
+	{
+		if(__atomic_load_n(&lockstatTable[e].lock, __ATOMIC_ACQUIRE) == 0)
+			continue;
+		lockstat_fill_info(&lockstatTable[e], &info);
+		ramfs_write((uint8_t *)&info, sizeof(info), fd);
+		++written;
+	}
+
+	ramfs_close(fd);
+	trace_printf("Lock statistics dump successful (%d locks).\n", count);
+}
+
+#else
+
+int lockstat_get(lockstat_info_t *infos, int maxCount, uint64_t *untrackedAcquisitions)
+{
+	*untrackedAcquisitions = 0;
+	return 0;
+}
+
+void lockstat_dump(const char *filePath)
+{
+	trace_printf("Lock statistics are not available, build the kernel with LOCKSTAT=1.\n");
+}
+
+#endif
@@ -0,0 +1,81 @@
+
+#ifndef _LOCK_LOCKSTAT_H
+#define _LOCK_LOCKSTAT_H
+
+#include <lock/spinlock.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Lock contention profiling for spinlock_t, enabled by building the kernel with LOCKSTAT=1 (defines LOCKSTAT).
+//
+// Statistics are kept in a fixed-size table keyed by the lock address, so spinlock_t itself does not change its size.
+// Locks which are freed and whose memory is reused for another lock share an entry. The entry of a lock is only
+// updated by the lock holder, so apart from claiming a table slot no additional synchronization is needed.
+// Call sites are identified by the first LOCKSTAT_SITE_DEPTH return addresses above spin_lock() and friends; as this
+// relies on frame pointers, only the direct caller is recorded in optimized builds.
+
+// Number of locks that can be tracked.
+#define LOCKSTAT_MAX_LOCKS 512
+
+// Number of call sites tracked per lock, and number of stack frames identifying a call site.
+#define LOCKSTAT_SITES 4
+#define LOCKSTAT_SITE_DEPTH 2
+
+// Maximum length of lock and function names, including terminating 0.
+#define LOCKSTAT_NAME_LENGTH 32
+
+// Statistics of one call site of a lock.
+typedef struct
+{
+	// Return addresses and the names of the containing functions, innermost first.
+	uint64_t rip[LOCKSTAT_SITE_DEPTH];
+	char names[LOCKSTAT_SITE_DEPTH][LOCKSTAT_NAME_LENGTH];
+
+	// Acquisitions through this call site (approximate, see lockstat.c), and the time spent waiting there.
+	uint64_t acquisitions;
+	uint64_t spinCycles;
+} lockstat_site_info_t;
+
+// Statistics of one lock. All times are in TSC ticks.
+typedef struct
+{
+	// Address of the lock, and the name of the global variable if the lock is one (else empty).
+	uint64_t lock;
+	char name[LOCKSTAT_NAME_LENGTH];
+
+	// Total number of acquisitions, and the number of acquisitions where the lock was held by someone else.
+	uint64_t acquisitions;
+	uint64_t contended;
+
+	// Time spent waiting for the lock.
+	uint64_t spinCycles;
+	uint64_t spinCyclesMax;
+
+	// Time the lock was held.
+	uint64_t holdCycles;
+	uint64_t holdCyclesMax;
+
+	// Call sites with the most acquisitions, sorted descending. Unused entries have zero acquisitions.
+	lockstat_site_info_t sites[LOCKSTAT_SITES];
+} lockstat_info_t;
+
+#ifdef LOCKSTAT
+// Records an acquisition of the given lock. Must be called by the new holder. frame is the frame pointer of the
+// spin_lock() variant called by the user, caller its return address.
+void lockstat_acquired(spinlock_t *lock, bool contended, uint64_t spinCycles, uint64_t *frame, uint64_t caller);
+
+// Records the release of the given lock. Must be called by the holder before releasing it.
+void lockstat_released(spinlock_t *lock);
+#endif
+
+// Copies the statistics of the locks with the highest total spin time into the given buffer, sorted descending.
+// Returns the number of entries written, 0 if lock statistics are disabled. untrackedAcquisitions receives the number of
+// acquisitions of locks which did not fit into the table.
+int lockstat_get(lockstat_info_t *infos, int maxCount, uint64_t *untrackedAcquisitions);
+
+// Writes the statistics of all tracked locks into the given ramfs file. Format:
+//     uint32_t count;
+//     lockstat_info_t infos[count];
+void lockstat_dump(const char *filePath);
+
+#endif
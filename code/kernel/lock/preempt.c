@@ -0,0 +1,14 @@
+
+#include <lock/preempt.h>
+#include <proc/sched.h>
+#include <smp/cpu.h>
+
+void preempt_enable(void)
+{
+  preempt_enable_no_resched();
+
+  // Do the switch the scheduler skipped while preemption was disabled; not possible with interrupts masked
+  cpu_t *cpu = cpu_get();
+  if (cpu->preempt_count == 0 && cpu->needResched && cpu->intr_mask_count == 0)
+    sched_yield();
+}
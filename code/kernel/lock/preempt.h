@@ -0,0 +1,15 @@
+
+#ifndef _LOCK_PREEMPT_H
+#define _LOCK_PREEMPT_H
+
+// Disables preemption of the current thread: Interrupts are still handled, but the scheduler does not switch to another
+// thread until preemption is enabled again. Calls may be nested. The thread must not block or yield meanwhile.
+void preempt_disable(void);
+
+// Enables preemption again, and switches to a waiting thread if a reschedule was requested in between.
+void preempt_enable(void);
+
+// Enables preemption again without checking for a pending reschedule.
+void preempt_enable_no_resched(void);
+
+#endif
@@ -0,0 +1,12 @@
+; Preemption counter of the current CPU (cpu_t::preempt_count, fourth group of 8 bytes).
+; It is updated with a single GS-relative instruction, so the thread cannot be migrated between reading and writing it.
+
+[global preempt_disable]
+preempt_disable:
+  inc qword [gs:24]
+  ret
+
+[global preempt_enable_no_resched]
+preempt_enable_no_resched:
+  dec qword [gs:24]
+  ret
@@ -2,6 +2,8 @@
 
 /*
 Interrupt-free spin lock. This does not disable interrupts on lock, so be careful not to cause deadlocks!
+Since system calls and kernel threads are preemptible, the holder may be switched out; only use this with interrupts
+masked, or if contention on the same core is impossible.
 */
 
 /* INCLUDES */
@@ -0,0 +1,95 @@
+
+#include <lock/rcu.h>
+#include <lock/intr.h>
+#include <cpu/pause.h>
+#include <cpu/tsc.h>
+#include <intr/apic.h>
+#include <intr/common.h>
+#include <intr/route.h>
+#include <smp/cpu.h>
+#include <util/container.h>
+#include <panic/panic.h>
+#include <trace/kstat.h>
+
+// Time after which a core that did not pass a quiescent state is sent an IPI (two scheduler ticks).
+#define RCU_KICK_DELAY_MS 20
+
+// Number of grace periods waited for, and their durations in TSC ticks.
+KSTAT_COUNTER(rcuSyncs, "rcu.syncs");
+KSTAT_HISTOGRAM(rcuSyncTicks, "rcu.sync_ticks");
+
+// Handles an RCU IPI. Nothing to do here, the quiescent state is reported when returning from the interrupt.
+static void rcu_handle_ipi(cpu_state_t *state)
+{
+}
+
+void rcu_init(void)
+{
+	rcu_cpu_online();
+	if(!intr_route_intr(IPI_RCU, &rcu_handle_ipi))
+		panic("failed to route RCU IPI");
+	
+	kstat_register(&rcuSyncs);
+	kstat_register(&rcuSyncTicks);
+}
+
+void rcu_cpu_online(void)
+{
+	__atomic_store_n(&cpu_get()->rcuOnline, true, __ATOMIC_SEQ_CST);
+}
+
+void rcu_read_lock(void)
+{
+	intr_lock();
+}
+
+void rcu_read_unlock(void)
+{
+	intr_unlock();
+}
+
+void rcu_quiescent_state(void)
+{
+	// Order all preceding reads of protected data before the counter update
+	cpu_t *cpu = cpu_get();
+	__atomic_store_n(&cpu->rcuQsCount, cpu->rcuQsCount + 1, __ATOMIC_RELEASE);
+}
+
+void rcu_synchronize(void)
+{
+	// Make sure the preceding unpublishing is visible before the counters are sampled
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	
+	uint64_t start = tsc_read();
+	
+	// The calling core is outside of any read-side section; it might be switched to another core while waiting, but
+	// then passes a quiescent state on the way
+	cpu_t *self = cpu_get();
+	list_for_each(&cpu_list, node)
+	{
+		cpu_t *cpu = container_of(node, cpu_t, node);
+		if(cpu == self || !__atomic_load_n(&cpu->rcuOnline, __ATOMIC_SEQ_CST))
+			continue;
+		
+		// Waiting with interrupts disabled could dead-lock with a core that waits for this one (e.g. TLB shootdowns)
+		if(self->intr_mask_count != 0)
+			panic("rcu_synchronize() called with interrupts disabled");
+		
+		// Wait for the core's quiescent state counter to change
+		uint64_t snapshot = __atomic_load_n(&cpu->rcuQsCount, __ATOMIC_ACQUIRE);
+		uint64_t kickTime = tsc_read() + self->tsc_ticks_per_ms * RCU_KICK_DELAY_MS;
+		bool kicked = false;
+		while(__atomic_load_n(&cpu->rcuQsCount, __ATOMIC_ACQUIRE) == snapshot)
+		{
+			if(!kicked && tsc_read() >= kickTime)
+			{
+				apic_ipi_fixed(cpu->lapic_id, IPI_RCU);
+				kicked = true;
+			}
+			pause_once();
+		}
+	}
+	
+	kstat_inc(&rcuSyncs);
+	kstat_record(&rcuSyncTicks, tsc_read() - start);
+}
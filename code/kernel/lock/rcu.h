@@ -0,0 +1,32 @@
+
+#ifndef _LOCK_RCU_H
+#define _LOCK_RCU_H
+
+// Lightweight read-copy-update: Readers access shared data without taking locks or writing shared cache lines.
+// Writers publish a modified copy and free the old version after a grace period, i.e. once every online core passed
+// a quiescent state, where it cannot hold references obtained before the update anymore.
+//
+// Read-side sections must not block or yield, thus interrupts are masked while in them. Interrupt handlers are
+// read-side sections implicitly. A core passes a quiescent state when returning from an interrupt into code with
+// interrupts enabled (e.g. at each scheduler tick), and when it switches threads voluntarily.
+
+// Sets up the RCU IPI and marks the boot core as online.
+void rcu_init(void);
+
+// Marks the current core as online, so writers wait for its quiescent states. Must be called before the core enables
+// interrupts.
+void rcu_cpu_online(void);
+
+// Begins/ends a read-side section outside of interrupt handlers. Sections may be nested.
+void rcu_read_lock(void);
+void rcu_read_unlock(void);
+
+// Reports a quiescent state of the current core. Must not be called inside a read-side section.
+void rcu_quiescent_state(void);
+
+// Waits until all read-side sections that were active when this function was called have ended, so data which was
+// unpublished before can be freed. Cores which do not pass a quiescent state in time (e.g. isolated cores with stopped
+// timer) are woken by an IPI. Must be called with interrupts enabled, unless no other core is online yet.
+void rcu_synchronize(void);
+
+#endif
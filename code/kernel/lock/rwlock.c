@@ -1,52 +1,152 @@
 
 #include <lock/rwlock.h>
 #include <lock/intr.h>
-#include <limits.h>
+#include <lock/preempt.h>
+#include <cpu/pause.h>
+#include <smp/cpu.h>
+#include <stdlib/assert.h>
 
-void rw_rlock(rwlock_t *lock)
+#define RW_READERS_MASK   0xFFFFFFFFULL
+#define RW_WRITER         (1ULL << 32)
+#define RW_WRITER_WAITING (1ULL << 33)
+
+static void rw_acquire_read(rwlock_t *lock)
 {
-  bool acquired = false;
-  do
+  for (;;)
   {
-    spin_lock(&lock->lock);
-    if (!lock->writing && lock->read_permits != INT_MAX)
-    {
-      lock->read_permits++;
-      acquired = true;
-      intr_lock();
-    }
-    spin_unlock(&lock->lock);
-  } while (!acquired);
+    /* only readers may hold the lock, and no writer may be waiting */
+    uint64_t value = __atomic_load_n(&lock->state, __ATOMIC_RELAXED);
+    if (!(value & ~RW_READERS_MASK) && __atomic_compare_exchange_n(&lock->state, &value, value + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return;
+    pause_once();
+  }
+}
+
+static void rw_release_read(rwlock_t *lock)
+{
+  uint64_t value = __atomic_fetch_sub(&lock->state, 1, __ATOMIC_RELEASE);
+  assert(value & RW_READERS_MASK);
+}
+
+static void rw_acquire_write(rwlock_t *lock)
+{
+  /* announce ourselves first, this keeps new readers out */
+  __atomic_fetch_add(&lock->state, RW_WRITER_WAITING, __ATOMIC_RELAXED);
+  for (;;)
+  {
+    uint64_t value = __atomic_load_n(&lock->state, __ATOMIC_RELAXED);
+    if (!(value & (RW_READERS_MASK | RW_WRITER)) && __atomic_compare_exchange_n(&lock->state, &value, value - RW_WRITER_WAITING + RW_WRITER, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return;
+    pause_once();
+  }
+}
+
+static void rw_release_write(rwlock_t *lock)
+{
+  uint64_t value = __atomic_fetch_sub(&lock->state, RW_WRITER, __ATOMIC_RELEASE);
+  assert(value & RW_WRITER);
+}
+
+void rw_rlock(rwlock_t *lock)
+{
+  intr_lock();
+  rw_acquire_read(lock);
 }
 
 void rw_runlock(rwlock_t *lock)
 {
-  spin_lock(&lock->lock);
-  lock->read_permits--;
+  rw_release_read(lock);
   intr_unlock();
-  spin_unlock(&lock->lock);
 }
 
 void rw_wlock(rwlock_t *lock)
 {
-  bool acquired = false;
-  do
-  {
-    spin_lock(&lock->lock);
-    if (!lock->writing && lock->read_permits == 0)
-    {
-      lock->writing = true;
-      acquired = true;
-      intr_lock();
-    }
-    spin_unlock(&lock->lock);
-  } while (!acquired);
+  intr_lock();
+  rw_acquire_write(lock);
 }
 
 void rw_wunlock(rwlock_t *lock)
 {
-  spin_lock(&lock->lock);
-  lock->writing = false;
+  rw_release_write(lock);
+  intr_unlock();
+}
+
+void rw_rlock_plain(rwlock_t *lock)
+{
+  preempt_disable();
+  rw_acquire_read(lock);
+}
+
+void rw_runlock_plain(rwlock_t *lock)
+{
+  rw_release_read(lock);
+  preempt_enable();
+}
+
+void rw_wlock_plain(rwlock_t *lock)
+{
+  preempt_disable();
+  rw_acquire_write(lock);
+}
+
+void rw_wunlock_plain(rwlock_t *lock)
+{
+  rw_release_write(lock);
+  preempt_enable();
+}
+
+/* the reader counter of the current core; interrupts are masked, so we stay on this core */
+static rwlock_percpu_slot_t *rw_percpu_slot(rwlock_percpu_t *lock)
+{
+  return &lock->readers[cpu_get()->coreId % RWLOCK_PERCPU_SLOTS];
+}
+
+void rw_percpu_rlock(rwlock_percpu_t *lock)
+{
+  intr_lock();
+  rwlock_percpu_slot_t *slot = rw_percpu_slot(lock);
+  for (;;)
+  {
+    /*
+     * count ourselves first and check for writers afterwards - the writer does
+     * it the other way round, so at least one of both sees the other
+     */
+    __atomic_fetch_add(&slot->count, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&lock->writers, __ATOMIC_SEQ_CST))
+      return;
+
+    /* back off until the writers are done */
+    __atomic_fetch_sub(&slot->count, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&lock->writers, __ATOMIC_RELAXED))
+      pause_once();
+  }
+}
+
+void rw_percpu_runlock(rwlock_percpu_t *lock)
+{
+  uint64_t value = __atomic_fetch_sub(&rw_percpu_slot(lock)->count, 1, __ATOMIC_RELEASE);
+  assert(value);
+  intr_unlock();
+}
+
+void rw_percpu_wlock(rwlock_percpu_t *lock)
+{
+  /* an interrupt handler taking the read lock on this core would wait for us forever */
+  intr_lock();
+  __atomic_fetch_add(&lock->writers, 1, __ATOMIC_SEQ_CST);
+  spin_lock(&lock->writer_lock);
+
+  /* wait for the readers which got in before us */
+  for (int i = 0; i < RWLOCK_PERCPU_SLOTS; i++)
+  {
+    while (__atomic_load_n(&lock->readers[i].count, __ATOMIC_SEQ_CST))
+      pause_once();
+  }
+}
+
+void rw_percpu_wunlock(rwlock_percpu_t *lock)
+{
+  __atomic_fetch_sub(&lock->writers, 1, __ATOMIC_RELEASE);
+  spin_unlock(&lock->writer_lock);
   intr_unlock();
-  spin_unlock(&lock->lock);
 }
@@ -4,51 +4,78 @@
 
 #include <lock/spinlock.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-#define RWLOCK_UNLOCKED { .read_permits = 0, .writing = false, .lock = SPIN_UNLOCKED }
+#define RWLOCK_UNLOCKED { .state = 0 }
+#define RWLOCK_PERCPU_UNLOCKED { .writers = 0, .writer_lock = SPIN_UNLOCKED }
 
-typedef struct
-{
-  /* The number of threads which have acquired the lock in read-only mode. */
-  int read_permits;
-
-  /* A flag indicating if this lock has been acquired in read-write mode. */
-  bool writing;
-
-  /*
-   * The spinlock that allows atomic operations to be performed on the above
-   * fields.
-   */
-  spinlock_t lock;
-} rwlock_t;
+/* number of reader counters of a rwlock_percpu_t, cores share counters modulo this */
+#define RWLOCK_PERCPU_SLOTS 16
 
 /*
- * Acquires the given read-write lock in read-only mode. If the lock is
- * unlocked, or if the lock has already been acquired for reading, it is
- * acquired immediately.
+ * Reader/writer spin lock in a single atomic word: the lower 32 bits count the
+ * readers holding the lock, bit 32 is set while a writer holds it, and the
+ * remaining bits count the writers waiting for it.
  *
- * Otherwise, this code will block by spinning until the write lock is
- * released, then acquire the read lock.
+ * Writers are preferred: as soon as a writer waits, new readers spin until it
+ * has released the lock again, so writers cannot starve. Spinning readers and
+ * writers only read the lock word until it looks available, the cache line is
+ * not bounced by failing atomic writes.
  *
- * Once acquired, interrupts are also disabled, so this lock is safe to be
- * used inside an interrupt handler.
+ * As a consequence, the read side is not re-entrant: a thread acquiring the
+ * read lock a second time deadlocks if a writer arrived in between.
  *
- * Obtaining the lock in read-only mode is re-entrant, unlike write-only mode.
+ * Like spinlock_t, the rw_*lock() functions mask interrupts while the lock is
+ * held and may be used by interrupt handlers, the rw_*lock_plain() functions
+ * only disable preemption. The same lock must always be used with the same
+ * variant.
  */
-void rw_rlock(rwlock_t *lock);
+typedef struct
+{
+  uint64_t state;
+} rwlock_t;
 
-/* Releases the read lock. */
+void rw_rlock(rwlock_t *lock);
 void rw_runlock(rwlock_t *lock);
+void rw_wlock(rwlock_t *lock);
+void rw_wunlock(rwlock_t *lock);
+
+void rw_rlock_plain(rwlock_t *lock);
+void rw_runlock_plain(rwlock_t *lock);
+void rw_wlock_plain(rwlock_t *lock);
+void rw_wunlock_plain(rwlock_t *lock);
+
+/* a reader counter on its own cache line */
+typedef struct
+{
+  uint64_t count;
+} __attribute__((__aligned__(64))) rwlock_percpu_slot_t;
 
 /*
- * Acquires the given read-write lock in read-write mode. This code blocks by
- * spinning until the lock is not locked in either read-only nor read-write
- * mode, and then acquires the lock. Interrupts are disabled upon the lock
- * being acquired, as described above.
+ * Reader/writer lock for read-mostly data: each core counts its readers in its
+ * own cache line, so concurrent readers on different cores do not write to a
+ * shared word. Writers are serialized by a spin lock and wait until all reader
+ * counters have drained, which makes the write side considerably more
+ * expensive than with rwlock_t.
+ *
+ * Writers are preferred and the read side is not re-entrant, as with
+ * rwlock_t. Interrupts are masked while the lock is held in either mode.
  */
-void rw_wlock(rwlock_t *lock);
+typedef struct
+{
+  /* readers per core slot */
+  rwlock_percpu_slot_t readers[RWLOCK_PERCPU_SLOTS];
 
-/* Releases the write lock. */
-void rw_wunlock(rwlock_t *lock);
+  /* number of writers waiting for or holding the lock, new readers back off while non-zero */
+  uint64_t writers;
+
+  /* serializes writers */
+  spinlock_t writer_lock;
+} rwlock_percpu_t;
+
+void rw_percpu_rlock(rwlock_percpu_t *lock);
+void rw_percpu_runlock(rwlock_percpu_t *lock);
+void rw_percpu_wlock(rwlock_percpu_t *lock);
+void rw_percpu_wunlock(rwlock_percpu_t *lock);
 
 #endif
@@ -2,24 +2,83 @@
 #include <lock/spinlock.h>
 #include <cpu/pause.h>
 #include <lock/intr.h>
+#include <lock/preempt.h>
+#include <lock/lockstat.h>
+#include <cpu/tsc.h>
 #include <stdlib/assert.h>
 
-void spin_lock(spinlock_t *lock)
+// Increment of the "next ticket" part of the lock.
+#define SPIN_TICKET_NEXT (1ULL << 32)
+
+// Frame pointer and return address of the calling spin_lock() variant, identifying the call site for lock statistics.
+#define SPIN_CALLER (uint64_t *) __builtin_frame_address(0), (uint64_t) __builtin_return_address(0)
+
+// Returns a pointer to the "currently served" part of the given lock.
+static uint32_t *spin_owner(spinlock_t *lock)
 {
-  for (;;)
-  {
-    if (spin_try_lock(lock))
-      break;
+  return (uint32_t *) lock;
+}
 
+// Draws a ticket and waits until it is served.
+static void spin_acquire(spinlock_t *lock, uint64_t *frame, uint64_t caller)
+{
+#ifdef LOCKSTAT
+  uint64_t start = tsc_read();
+  bool contended = false;
+#endif
+
+  uint32_t ticket = __atomic_fetch_add(lock, SPIN_TICKET_NEXT, __ATOMIC_RELAXED) >> 32;
+  while (__atomic_load_n(spin_owner(lock), __ATOMIC_ACQUIRE) != ticket)
+  {
+#ifdef LOCKSTAT
+    contended = true;
+#endif
     pause_once();
   }
+
+#ifdef LOCKSTAT
+  lockstat_acquired(lock, contended, tsc_read() - start, frame, caller);
+#endif
+}
+
+// Draws a ticket only if it would be served immediately.
+static bool spin_try_acquire(spinlock_t *lock, uint64_t *frame, uint64_t caller)
+{
+  uint64_t value = __atomic_load_n(lock, __ATOMIC_RELAXED);
+  if ((uint32_t) value != (uint32_t) (value >> 32))
+    return false;
+  if (!__atomic_compare_exchange_n(lock, &value, value + SPIN_TICKET_NEXT, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    return false;
+
+#ifdef LOCKSTAT
+  lockstat_acquired(lock, false, 0, frame, caller);
+#endif
+  return true;
+}
+
+// Serves the next ticket. Only the holder writes this part of the lock.
+static void spin_release(spinlock_t *lock)
+{
+  uint64_t value = __atomic_load_n(lock, __ATOMIC_RELAXED);
+  assert((uint32_t) value != (uint32_t) (value >> 32));
+#ifdef LOCKSTAT
+  lockstat_released(lock);
+#endif
+  __atomic_store_n(spin_owner(lock), (uint32_t) value + 1, __ATOMIC_RELEASE);
+}
+
+void spin_lock(spinlock_t *lock)
+{
+  /* mask interrupts before drawing a ticket, a handler on this core waiting for the same lock would never be served */
+  intr_lock();
+  spin_acquire(lock, SPIN_CALLER);
 }
 
 bool spin_try_lock(spinlock_t *lock)
 {
   intr_lock();
 
-  if (__sync_bool_compare_and_swap(lock, SPIN_UNLOCKED, SPIN_LOCKED))
+  if (spin_try_acquire(lock, SPIN_CALLER))
     return true;
 
   intr_unlock();
@@ -28,6 +87,36 @@ bool spin_try_lock(spinlock_t *lock)
 
 void spin_unlock(spinlock_t *lock)
 {
-  assert(__sync_bool_compare_and_swap(lock, SPIN_LOCKED, SPIN_UNLOCKED));
+  spin_release(lock);
   intr_unlock();
 }
+
+void spin_lock_plain(spinlock_t *lock)
+{
+  preempt_disable();
+  spin_acquire(lock, SPIN_CALLER);
+}
+
+bool spin_try_lock_plain(spinlock_t *lock)
+{
+  preempt_disable();
+
+  if (spin_try_acquire(lock, SPIN_CALLER))
+    return true;
+
+  preempt_enable();
+  return false;
+}
+
+void spin_unlock_plain(spinlock_t *lock)
+{
+  spin_release(lock);
+  preempt_enable();
+}
+
+void spin_preempt_point(spinlock_t *lock)
+{
+  /* interrupts are only unmasked if this is the outermost lock */
+  spin_unlock(lock);
+  spin_lock(lock);
+}
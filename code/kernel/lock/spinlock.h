@@ -6,12 +6,28 @@
 #include <stdint.h>
 
 #define SPIN_UNLOCKED 0
-#define SPIN_LOCKED   1
 
+// Ticket spin lock: The upper 32 bits hold the next ticket to be handed out, the lower 32 bits the ticket currently
+// being served. Waiters are served in FIFO order and only read the lock while spinning, so contended locks stay fair
+// and the cache line is not bounced by failing atomic writes.
+//
+// spin_lock() is interrupt-safe: Interrupts are masked on the current core while the lock is held, so it may be shared
+// with interrupt handlers. As preemption is triggered by interrupts, a lock holder is never switched out.
+// spin_lock_plain() only disables preemption and leaves interrupts enabled; use it for locks which are never acquired
+// by interrupt handlers. The same lock must always be used with the same variant.
+// Use raw_spinlock_t only for locks which are never acquired with interrupts enabled.
 typedef uint64_t spinlock_t;
 
 void spin_lock(spinlock_t *lock);
 bool spin_try_lock(spinlock_t *lock);
 void spin_unlock(spinlock_t *lock);
 
+void spin_lock_plain(spinlock_t *lock);
+bool spin_try_lock_plain(spinlock_t *lock);
+void spin_unlock_plain(spinlock_t *lock);
+
+// Preemption point for long loops holding the given lock: Briefly releases it, so pending interrupts are handled and the
+// current thread may be switched out. The protected data may have changed afterwards.
+void spin_preempt_point(spinlock_t *lock);
+
 #endif
@@ -0,0 +1,156 @@
+
+#include <lock/torture.h>
+#include <lock/spinlock.h>
+#include <lock/intr.h>
+#include <cpu/pause.h>
+#include <cpu/tsc.h>
+#include <proc/kthread.h>
+#include <proc/sched.h>
+#include <smp/cpu.h>
+#include <util/container.h>
+#include <trace/trace.h>
+
+// State of the current run; only one run is done at a time.
+static int tortureRunning = 0;
+static lock_torture_type_t tortureType;
+static int tortureIterations;
+static int tortureThreads;
+static int tortureReady;
+static int tortureDone;
+
+// The tested locks and the data protected by them.
+static uint64_t tortureTasLock;
+static spinlock_t tortureTicketLock;
+static uint64_t tortureCounter;
+static uint64_t tortureAcquireCycles;
+static uint64_t tortureMaxAcquireCycles;
+static uint64_t tortureCycles;
+
+// Test-and-set lock as spin_lock() was implemented before: Interrupts are only masked while trying to acquire.
+static void tas_lock(uint64_t *lock)
+{
+	for(;;)
+	{
+		intr_lock();
+		if(__sync_bool_compare_and_swap(lock, 0, 1))
+			return;
+		intr_unlock();
+		pause_once();
+	}
+}
+
+static void tas_unlock(uint64_t *lock)
+{
+	__sync_bool_compare_and_swap(lock, 1, 0);
+	intr_unlock();
+}
+
+// Kernel thread function of the torture test.
+static void lock_torture_thread(void *arg)
+{
+	// Start all threads at the same time to get maximum contention
+	__atomic_fetch_add(&tortureReady, 1, __ATOMIC_SEQ_CST);
+	while(__atomic_load_n(&tortureReady, __ATOMIC_SEQ_CST) < tortureThreads)
+		pause_once();
+	
+	uint64_t start = tsc_read();
+	for(int i = 0; i < tortureIterations; ++i)
+	{
+		uint64_t acquireStart = tsc_read();
+		switch(tortureType)
+		{
+			case LOCK_TORTURE_TAS:
+				tas_lock(&tortureTasLock);
+				break;
+			case LOCK_TORTURE_TICKET:
+				spin_lock(&tortureTicketLock);
+				break;
+			default:
+				spin_lock_plain(&tortureTicketLock);
+				break;
+		}
+		uint64_t acquireCycles = tsc_read() - acquireStart;
+		
+		// Critical section; non-atomic updates show missing mutual exclusion
+		++tortureCounter;
+		tortureAcquireCycles += acquireCycles;
+		if(acquireCycles > tortureMaxAcquireCycles)
+			tortureMaxAcquireCycles = acquireCycles;
+		
+		switch(tortureType)
+		{
+			case LOCK_TORTURE_TAS:
+				tas_unlock(&tortureTasLock);
+				break;
+			case LOCK_TORTURE_TICKET:
+				spin_unlock(&tortureTicketLock);
+				break;
+			default:
+				spin_unlock_plain(&tortureTicketLock);
+				break;
+		}
+	}
+	__atomic_fetch_add(&tortureCycles, tsc_read() - start, __ATOMIC_SEQ_CST);
+	
+	__atomic_fetch_add(&tortureDone, 1, __ATOMIC_SEQ_CST);
+}
+
+// Runs the torture test for the given lock type.
+static void lock_torture_run_type(lock_torture_type_t type, int iterations, lock_torture_result_t *result)
+{
+	tortureType = type;
+	tortureIterations = iterations;
+	tortureThreads = 0;
+	tortureReady = 0;
+	tortureDone = 0;
+	tortureTasLock = 0;
+	tortureTicketLock = SPIN_UNLOCKED;
+	tortureCounter = 0;
+	tortureAcquireCycles = 0;
+	tortureMaxAcquireCycles = 0;
+	tortureCycles = 0;
+	
+	// Create one thread per core, then start them
+	thread_t *threads[cpuCount];
+	list_for_each(&cpu_list, node)
+	{
+		cpu_t *cpu = container_of(node, cpu_t, node);
+		thread_t *thread = kthread_create("lock torture", &lock_torture_thread, 0, cpu->coreId);
+		if(thread)
+			threads[tortureThreads++] = thread;
+		else
+			trace_printf("Could not create lock torture thread for core #%d\n", cpu->coreId);
+	}
+	for(int t = 0; t < tortureThreads; ++t)
+		thread_resume(threads[t]);
+	
+	// Wait for completion; the threads are freed by the reaper
+	while(__atomic_load_n(&tortureDone, __ATOMIC_SEQ_CST) < tortureThreads)
+		sched_yield();
+	
+	uint64_t operations = (uint64_t)tortureThreads * iterations;
+	result->type = type;
+	result->threads = tortureThreads;
+	result->iterations = iterations;
+	result->avgAcquireCycles = (operations ? tortureAcquireCycles / operations : 0);
+	result->maxAcquireCycles = tortureMaxAcquireCycles;
+	result->avgCycles = (operations ? tortureCycles / operations : 0);
+	result->ok = (tortureCounter == operations);
+}
+
+int lock_torture_run(int iterations, lock_torture_result_t *results, int maxCount)
+{
+	if(iterations <= 0)
+		return 0;
+	
+	// Only one run at a time; the run yields, so this cannot be a spin lock
+	if(!__sync_bool_compare_and_swap(&tortureRunning, 0, 1))
+		return 0;
+	
+	int count = 0;
+	for(int t = 0; t < LOCK_TORTURE_TYPE_COUNT && count < maxCount; ++t)
+		lock_torture_run_type((lock_torture_type_t)t, iterations, &results[count++]);
+	
+	__atomic_store_n(&tortureRunning, 0, __ATOMIC_RELEASE);
+	return count;
+}
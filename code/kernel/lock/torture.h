@@ -0,0 +1,47 @@
+
+#ifndef _LOCK_TORTURE_H
+#define _LOCK_TORTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Lock implementations compared by the lock torture test.
+typedef enum
+{
+	// Test-and-set lock with masked interrupts, as used for spinlock_t before ticket locks.
+	LOCK_TORTURE_TAS = 0,
+	
+	// Ticket lock with masked interrupts (spin_lock()).
+	LOCK_TORTURE_TICKET = 1,
+	
+	// Ticket lock with disabled preemption (spin_lock_plain()).
+	LOCK_TORTURE_TICKET_PLAIN = 2,
+	
+	LOCK_TORTURE_TYPE_COUNT
+} lock_torture_type_t;
+
+// Result of a lock torture run for one lock type.
+typedef struct
+{
+	int type;
+	
+	// Number of threads (one per core) and acquisitions per thread.
+	int threads;
+	int iterations;
+	
+	// Average and maximum time between requesting and getting the lock, in TSC ticks.
+	uint64_t avgAcquireCycles;
+	uint64_t maxAcquireCycles;
+	
+	// Average time of an entire lock/unlock pair including the critical section, in TSC ticks.
+	uint64_t avgCycles;
+	
+	// Determines whether the counter protected by the lock has the expected value, i.e. mutual exclusion held.
+	bool ok;
+} lock_torture_result_t;
+
+// Runs a kernel thread on each core which repeatedly acquires a shared lock, increments a counter and releases it again,
+// for each lock type. The calling thread yields until the test is done. Returns the number of results written.
+int lock_torture_run(int iterations, lock_torture_result_t *results, int maxCount);
+
+#endif
@@ -11,6 +11,7 @@
 #include <stdlib/stdlib.h>
 #include <stdbool.h>
 #include <fs/ramfs.h>
+#include <trace/kstat.h>
 
 // Pointer to the PMM PML1 (loops once in PML4).
 #define PMM_PML1_ADDRESS 0xFFFFFF7F7F7FF000
@@ -68,6 +69,10 @@ static uint64_t *pmmPml1Table = (uint64_t *)PMM_PML1_ADDRESS;
 // The PMM is not thread safe -> lock to avoid inconstencies.
 static spinlock_t pmmLock = SPIN_UNLOCKED;
 
+// Number of frame allocations and frees, regardless of their size.
+KSTAT_COUNTER(pmmAllocs, "pmm.allocs");
+KSTAT_COUNTER(pmmFrees, "pmm.frees");
+
 // Determines whether the reserved stack pages list has already been initialized.
 static bool stackPageListInitialized = false;
 
@@ -950,6 +955,9 @@ void pmm_init(list_t *map)
     }
     
     _pmm_debug();
+    
+    kstat_register(&pmmAllocs);
+    kstat_register(&pmmFrees);
 }
 
 uintptr_t pmm_alloc(void)
@@ -973,6 +981,7 @@ uintptr_t pmm_allocsz(int size, int zone)
     int allocZone;
     uintptr_t addr = _pmm_alloc(size, zone, zone, &allocZone);
     spin_unlock(&pmmLock);
+    kstat_inc(&pmmAllocs);
     return addr;
 }
 
@@ -986,6 +995,7 @@ void pmm_frees(int size, uintptr_t addr)
     spin_lock(&pmmLock);
     _pmm_free(size, get_zone(size, addr), addr);
     spin_unlock(&pmmLock);
+    kstat_inc(&pmmFrees);
 }
 
 uintptr_t pmm_alloc_contiguous(int size, int count)
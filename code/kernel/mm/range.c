@@ -55,14 +55,14 @@ bool range_alloc(uintptr_t addr_start, size_t len, vm_acc_t flags)
 		uintptr_t frame = pmm_alloc();
 		if(!frame)
 		{
-			range_free(addr_start, len);
+			range_free(addr_start, addr - addr_start);
 			return false;
 		}
 
 		if(!vmm_map(addr, frame, flags))
 		{
 			pmm_free(frame);
-			range_free(addr_start, len);
+			range_free(addr_start, addr - addr_start);
 			return false;
 		}
 
@@ -1,17 +1,20 @@
 
 #include <mm/seg.h>
+#include <mm/vmm.h>
 #include <mm/align.h>
 #include <mm/common.h>
 #include <mm/range.h>
+#include <mm/pmm.h>
 #include <proc/proc.h>
 #include <util/container.h>
 #include <trace/trace.h>
 #include <stdlib/assert.h>
 #include <stdlib/stdlib.h>
 
-static bool _seg_alloc_at(seg_t *segments, void *ptr, size_t size, vm_acc_t flags)
+// Reserves the given address range, splitting the enclosing free block as needed. Returns the reserved block (state
+// SEG_BUSY) or 0. The segment lock must be held.
+static seg_block_t *_seg_reserve_at(seg_t *segments, uintptr_t addr, size_t size)
 {
-	uintptr_t addr = (uintptr_t)ptr;
 	assert((size % FRAME_SIZE) == 0);
 
 	list_for_each(&segments->block_list, node)
@@ -19,11 +22,10 @@ static bool _seg_alloc_at(seg_t *segments, void *ptr, size_t size, vm_acc_t flag
 		seg_block_t *block = container_of(node, seg_block_t, node);
 		if(addr >= block->start && (addr + size - 1) <= block->end)
 		{
-			seg_block_t *left_block = 0, *right_block = 0;
+			if(block->state != SEG_FREE)
+				return 0;
 
-			/* allocate underlying page frames and map the region into memory */
-			if(!range_alloc(addr, size, flags))
-				return false;
+			seg_block_t *left_block = 0, *right_block = 0;
 
 			/* determine if left and right parts of the block can be split away */
 			bool left_split = addr != block->start;
@@ -34,10 +36,7 @@ static bool _seg_alloc_at(seg_t *segments, void *ptr, size_t size, vm_acc_t flag
 			{
 				left_block = malloc(sizeof(*left_block));
 				if(!left_block)
-				{
-					range_free(addr, size);
-					return false;
-				}
+					return 0;
 			}
 
 			/* allocate block node for the right side */
@@ -46,10 +45,9 @@ static bool _seg_alloc_at(seg_t *segments, void *ptr, size_t size, vm_acc_t flag
 				right_block = malloc(sizeof(*right_block));
 				if(!right_block)
 				{
-					range_free(addr, size);
 					if(left_split)
 						free(left_block);
-					return false;
+					return 0;
 				}
 			}
 
@@ -75,105 +73,93 @@ static bool _seg_alloc_at(seg_t *segments, void *ptr, size_t size, vm_acc_t flag
 				list_insert_after(&segments->block_list, &block->node, &right_block->node);
 			}
 
-			/* mark this block as allocated */
-			block->state = SEG_ALLOCATED;
-			block->flags = flags;
-			return true;
+			/* mark this block as reserved */
+			block->state = SEG_BUSY;
+			return block;
 		}
 	}
 
-	return false;
+	return 0;
 }
 
-static void *_seg_alloc(seg_t *segments, size_t size, vm_acc_t flags)
+// Reserves a range of the given size and alignment in the first fitting free block. Returns the reserved block
+// (state SEG_BUSY) or 0. The segment lock must be held.
+static seg_block_t *_seg_reserve_aligned(seg_t *segments, size_t size, size_t alignment)
 {
 	assert((size % FRAME_SIZE) == 0);
 
 	list_for_each(&segments->block_list, node)
 	{
 		seg_block_t *block = container_of(node, seg_block_t, node);
-		size_t block_size = block->end - block->start + 1;
-		if(block->state == SEG_FREE && block_size >= size)
-		{
-			uintptr_t addr = (uintptr_t)block->start;
-
-			/* allocate underlying page frames and map the region into memory */
-			if(!range_alloc(addr, size, flags))
-				return 0;
-
-			/* split the right part of the block away */
-			if(block_size != size)
-			{
-				seg_block_t *right_block = malloc(sizeof(*block));
-				if(!right_block)
-				{
-					range_free(addr, size);
-					return 0;
-				}
-
-				right_block->start = addr + size;
-				right_block->end = block->end;
-				right_block->state = SEG_FREE;
-				block->end = addr + size - 1;
-
-				list_insert_after(&segments->block_list, &block->node, &right_block->node);
-			}
-
-			/* mark this block as allocated and return a pointer to it */
-			block->state = SEG_ALLOCATED;
-			block->flags = flags;
-			return (void *) block->start;
-		}
+		uintptr_t start = (block->start + alignment - 1) & ~(alignment - 1);
+		if(block->state == SEG_FREE && start <= block->end && block->end - start + 1 >= size)
+			return _seg_reserve_at(segments, start, size);
 	}
 
 	return 0;
 }
 
-static void _seg_free(seg_t *segments, void *ptr)
+// Reserves a range of the given size in the first fitting free block. Returns the reserved block (state SEG_BUSY)
+// or 0. The segment lock must be held.
+static seg_block_t *_seg_reserve(seg_t *segments, size_t size)
 {
-	uintptr_t addr = (uintptr_t)ptr;
+	return _seg_reserve_aligned(segments, size, FRAME_SIZE);
+}
 
-	list_for_each(&segments->block_list, node)
+// Marks the given block as free and merges it with its free neighbours. The segment lock must be held.
+static void _seg_release(seg_t *segments, seg_block_t *block)
+{
+	/* unmark this block as being allocated */
+	block->state = SEG_FREE;
+
+	/* try to merge with the left block */
+	if(block->node.prev)
 	{
-		seg_block_t *block = container_of(node, seg_block_t, node);
-		if(block->state != SEG_FREE && block->start == addr)
+		seg_block_t *left_block = container_of(block->node.prev, seg_block_t, node);
+		if(left_block->state == SEG_FREE)
 		{
-			/* free the underlying page frames and unmap the virtual memory */
-			size_t block_size = block->end - block->start + 1;
-			range_free(addr, block_size);
-
-			/* unmark this block as being allocated */
-			block->state = SEG_FREE;
+			block->start = left_block->start;
 
-			/* try to merge with the left block */
-			if(block->node.prev)
-			{
-				seg_block_t *left_block = container_of(block->node.prev, seg_block_t, node);
-				if(left_block->state == SEG_FREE)
-				{
-					block->start = left_block->start;
+			list_remove(&segments->block_list, &left_block->node);
+			free(left_block);
+		}
+	}
 
-					list_remove(&segments->block_list, &left_block->node);
-					free(left_block);
-				}
-			}
+	/* try to merge with the right block */
+	if(block->node.next)
+	{
+		seg_block_t *right_block = container_of(block->node.next, seg_block_t, node);
+		if(right_block->state == SEG_FREE)
+		{
+			block->end = right_block->end;
 
-			/* try to merge with the right block */
-			if(block->node.next)
-			{
-				seg_block_t *right_block = container_of(block->node.next, seg_block_t, node);
-				if(right_block->state == SEG_FREE)
-				{
-					block->end = right_block->end;
+			list_remove(&segments->block_list, &right_block->node);
+			free(right_block);
+		}
+	}
+}
 
-					list_remove(&segments->block_list, &right_block->node);
-					free(right_block);
-				}
-			}
+// Allocates and maps the page frames of the given reserved block. Returns the block's start address, or 0 on failure.
+// The segment lock must not be held: Mapping large blocks takes long, and the reservation already protects the range,
+// so interrupts stay enabled in between.
+static void *seg_map_block(seg_t *segments, seg_block_t *block, vm_acc_t flags)
+{
+	uintptr_t addr = block->start;
+	size_t size = block->end - block->start + 1;
+	bool ok = range_alloc(addr, size, flags);
 
-			return;
-		}
+	spin_lock(&segments->lock);
+	if(ok)
+	{
+		/* mark this block as allocated */
+		block->state = SEG_ALLOCATED;
+		block->flags = flags;
 	}
+	else
+		_seg_release(segments, block);
+	spin_unlock(&segments->lock);
+
+	return ok ? (void *)addr : 0;
 }
 
 // Returns the segment data of the current process.
@@ -186,6 +172,25 @@ static seg_t *seg_get(void)
 	return &proc->segments;
 }
 
+// Finds the block with the given state starting at the given address and marks it as busy. Returns 0 if there is none.
+static seg_block_t *seg_claim_block(seg_t *segments, uintptr_t addr, seg_state_t state)
+{
+	seg_block_t *block = 0;
+	spin_lock(&segments->lock);
+	list_for_each(&segments->block_list, node)
+	{
+		seg_block_t *current = container_of(node, seg_block_t, node);
+		if(current->state == state && current->start == addr)
+		{
+			current->state = SEG_BUSY;
+			block = current;
+			break;
+		}
+	}
+	spin_unlock(&segments->lock);
+	return block;
+}
+
 // Initializes the given process segment data with one large, free segment.
 bool seg_init(seg_t *segments)
 {
@@ -208,28 +213,31 @@ bool seg_init(seg_t *segments)
 	return true;
 }
 
-// Frees all segments of the current process.
-void seg_destroy(void)
+// Frees all segments of the given process, whose address space must be loaded and not be in use by any other CPU.
+void seg_destroy(seg_t *segments)
 {
-	seg_t *segments = seg_get();
-
 	/* lock the seg */
 	spin_lock(&segments->lock);
 
-	/* iterate through every block in this seg */
+	/* unmap shared blocks first, their frames belong to someone else */
 	list_for_each(&segments->block_list, node)
 	{
 		seg_block_t *block = container_of(node, seg_block_t, node);
+		if(block->state == SEG_SHARED)
+			vmm_unmap_range(block->start, block->end - block->start + 1);
+	}
 
-		/*
-		 * free the virtual and physical memory used by the block, if it is
-		 * allocated
-		 */
-		if(block->state != SEG_FREE)
-		{
-			size_t block_size = block->end - block->start + 1;
-			range_free((uintptr_t)block->start, block_size);
-		}
+	/*
+	 * free the virtual and physical memory used by all allocated blocks at once,
+	 * as the entire user space belongs to segments. This avoids unmapping and
+	 * invalidating each page separately
+	 */
+	vmm_destroy_user_space();
+
+	/* iterate through every block in this seg */
+	list_for_each(&segments->block_list, node)
+	{
+		seg_block_t *block = container_of(node, seg_block_t, node);
 
 		/*
 		 * remove the block from the list and free the memory the kernel uses to
@@ -258,10 +266,12 @@ bool seg_alloc_at(void *ptr, size_t size, vm_acc_t flags)
 		return false;
 
 	spin_lock(&segments->lock);
-	bool ok = _seg_alloc_at(segments, ptr, size, flags);
+	seg_block_t *block = _seg_reserve_at(segments, (uintptr_t)ptr, size);
 	spin_unlock(&segments->lock);
+	if(!block)
+		return false;
 
-	return ok;
+	return seg_map_block(segments, block, flags) != 0;
 }
 
 // Allocates a new segment with the given access flags and size.
@@ -272,21 +282,209 @@ void *seg_alloc(size_t size, vm_acc_t flags)
 		return 0;
 
 	spin_lock(&segments->lock);
-	void *ptr = _seg_alloc(segments, size, flags);
+	seg_block_t *block = _seg_reserve(segments, size);
 	spin_unlock(&segments->lock);
+	if(!block)
+		return 0;
 
-	return ptr;
+	return seg_map_block(segments, block, flags);
 }
 
 void seg_free(void *ptr)
 {
 	seg_t *segments = seg_get();
-	if(segments)
+	if(!segments)
+		return;
+
+	/* find the block and mark it as busy, so it is neither freed twice nor reused while it is unmapped */
+	seg_block_t *block = seg_claim_block(segments, (uintptr_t)ptr, SEG_ALLOCATED);
+	if(!block)
+		return;
+
+	/* free the underlying page frames and unmap the virtual memory, without blocking interrupts */
+	range_free(block->start, block->end - block->start + 1);
+
+	spin_lock(&segments->lock);
+	_seg_release(segments, block);
+	spin_unlock(&segments->lock);
+}
+
+void *seg_map_shared(void *kernelAddr, size_t size, vm_acc_t flags)
+{
+	seg_t *segments = seg_get();
+	if(!segments)
+		return 0;
+
+	size = PAGE_ALIGN(size);
+	spin_lock(&segments->lock);
+	seg_block_t *block = _seg_reserve(segments, size);
+	spin_unlock(&segments->lock);
+	if(!block)
+		return 0;
+
+	/* map the kernel's frames page by page, they need not be physically contiguous */
+	bool ok = true;
+	for(size_t off = 0; off < size; off += FRAME_SIZE)
+	{
+		if(!vmm_map(block->start + off, vmm_virt_to_phys((uintptr_t)kernelAddr + off), flags))
+		{
+			vmm_unmap_range(block->start, off);
+			ok = false;
+			break;
+		}
+	}
+
+	spin_lock(&segments->lock);
+	if(ok)
+	{
+		block->state = SEG_SHARED;
+		block->flags = flags;
+	}
+	else
+		_seg_release(segments, block);
+	spin_unlock(&segments->lock);
+
+	return ok ? (void *)block->start : 0;
+}
+
+void seg_unmap_shared(void *ptr)
+{
+	seg_t *segments = seg_get();
+	if(!segments)
+		return;
+
+	seg_block_t *block = seg_claim_block(segments, (uintptr_t)ptr, SEG_SHARED);
+	if(!block)
+		return;
+
+	/* the frames belong to the kernel, only remove the mapping */
+	vmm_unmap_range(block->start, block->end - block->start + 1);
+
+	spin_lock(&segments->lock);
+	_seg_release(segments, block);
+	spin_unlock(&segments->lock);
+}
+
+// Returns the size in bytes of the given page size type.
+static size_t seg_page_bytes(int pageSize)
+{
+	if(pageSize == SIZE_1G)
+		return FRAME_SIZE_1G;
+	if(pageSize == SIZE_2M)
+		return FRAME_SIZE_2M;
+	return FRAME_SIZE;
+}
+
+seg_frames_t *seg_detach(void *ptr)
+{
+	seg_t *segments = seg_get();
+	if(!segments)
+		return 0;
+
+	seg_block_t *block = seg_claim_block(segments, (uintptr_t)ptr, SEG_ALLOCATED);
+	if(!block)
+		return 0;
+
+	/* count the pages, the block may be backed by huge pages */
+	int count = 0;
+	size_t alignment = FRAME_SIZE;
+	for(uintptr_t addr = block->start; addr < block->end;)
+	{
+		size_t bytes = seg_page_bytes(vmm_size(addr));
+		if(bytes > alignment)
+			alignment = bytes;
+		addr += bytes;
+		++count;
+	}
+
+	seg_frames_t *frames = malloc(sizeof(seg_frames_t) + count * sizeof(seg_frame_t));
+	if(!frames)
 	{
 		spin_lock(&segments->lock);
-		_seg_free(segments, ptr);
+		block->state = SEG_ALLOCATED;
 		spin_unlock(&segments->lock);
+		return 0;
+	}
+	frames->size = block->end - block->start + 1;
+	frames->alignment = alignment;
+	frames->flags = block->flags;
+	frames->count = count;
+
+	/* unmap the pages without freeing them */
+	uintptr_t addr = block->start;
+	for(int i = 0; i < count; ++i)
+	{
+		frames->frames[i].pageSize = vmm_size(addr);
+		frames->frames[i].phys = vmm_unmaps(addr, frames->frames[i].pageSize);
+		addr += seg_page_bytes(frames->frames[i].pageSize);
+	}
+
+	spin_lock(&segments->lock);
+	_seg_release(segments, block);
+	spin_unlock(&segments->lock);
+	return frames;
+}
+
+void *seg_attach(seg_frames_t *frames)
+{
+	seg_t *segments = seg_get();
+	if(!segments)
+		return 0;
+
+	/* huge pages need a suitably aligned range */
+	spin_lock(&segments->lock);
+	seg_block_t *block = _seg_reserve_aligned(segments, frames->size, frames->alignment);
+	spin_unlock(&segments->lock);
+	if(!block)
+		return 0;
+
+	bool ok = true;
+	uintptr_t addr = block->start;
+	for(int i = 0; i < frames->count; ++i)
+	{
+		if(!vmm_maps(addr, frames->frames[i].phys, frames->flags, frames->frames[i].pageSize))
+		{
+			/* undo the mappings, the frames stay with the descriptor */
+			for(uintptr_t undo = block->start; undo < addr;)
+			{
+				int pageSize = vmm_size(undo);
+				vmm_unmaps(undo, pageSize);
+				undo += seg_page_bytes(pageSize);
+			}
+			ok = false;
+			break;
+		}
+		addr += seg_page_bytes(frames->frames[i].pageSize);
+	}
+
+	spin_lock(&segments->lock);
+	if(ok)
+	{
+		/* the block now owns the frames, like any other allocated one */
+		block->state = SEG_ALLOCATED;
+		block->flags = frames->flags;
+	}
+	else
+		_seg_release(segments, block);
+	spin_unlock(&segments->lock);
+
+	if(!ok)
+		return 0;
+	void *result = (void *)block->start;
+	free(frames);
+	return result;
+}
+
+void seg_frames_free(seg_frames_t *frames)
+{
+	for(int i = 0; i < frames->count; ++i)
+	{
+		if(frames->frames[i].pageSize == SIZE_4K)
+			pmm_free(frames->frames[i].phys);
+		else
+			pmm_frees(frames->frames[i].pageSize, frames->frames[i].phys);
 	}
+	free(frames);
 }
 
 void seg_trace(void)
@@ -300,9 +498,9 @@ void seg_trace(void)
 		list_for_each(&segments->block_list, node)
 		{
 			seg_block_t *block = container_of(node, seg_block_t, node);
-			const char *state = block->state == SEG_ALLOCATED ? "allocated " : "free";
+			const char *state = block->state == SEG_ALLOCATED ? "allocated " : (block->state == SEG_SHARED ? "shared " : (block->state == SEG_BUSY ? "busy" : "free"));
 			const char *r = "", *w = "", *x = "";
-			if(block->state == SEG_ALLOCATED)
+			if(block->state == SEG_ALLOCATED || block->state == SEG_SHARED)
 			{
 				r = block->flags & VM_R ? "r" : "-";
 				w = block->flags & VM_W ? "w" : "-";
@@ -7,11 +7,14 @@
 #include <util/list.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum
 {
   SEG_FREE,
-  SEG_ALLOCATED
+  SEG_ALLOCATED,
+  SEG_BUSY, /* being mapped or unmapped, without holding the lock */
+  SEG_SHARED /* maps kernel-owned frames, cannot be freed by the process */
 } seg_state_t;
 
 typedef struct seg_block
@@ -30,10 +33,45 @@ typedef struct
 } seg_t;
 
 bool seg_init(seg_t *segments);
-void seg_destroy(void);
+void seg_destroy(seg_t *segments);
 bool seg_alloc_at(void *ptr, size_t size, vm_acc_t flags);
 void *seg_alloc(size_t size, vm_acc_t flags);
 void seg_free(void *ptr);
+
+// Maps the given kernel memory into the current process. The frames are not freed when the process is destroyed, and
+// the mapping cannot be removed by seg_free(), only by seg_unmap_shared().
+void *seg_map_shared(void *kernelAddr, size_t size, vm_acc_t flags);
+void seg_unmap_shared(void *ptr);
+
+// A page frame of a detached segment.
+typedef struct
+{
+  uintptr_t phys;
+  int pageSize; /* SIZE_4K, SIZE_2M or SIZE_1G */
+} seg_frame_t;
+
+// The page frames of a segment which was removed from its process without freeing its memory, e.g. to pass it to
+// another process.
+typedef struct
+{
+  size_t size;
+  size_t alignment; /* largest page size used */
+  vm_acc_t flags;
+  int count;
+  seg_frame_t frames[];
+} seg_frames_t;
+
+// Removes the allocated segment starting at the given address from the current process and returns its frames, or 0
+// if there is no such segment.
+seg_frames_t *seg_detach(void *ptr);
+
+// Maps the given detached frames as a new allocated segment into the current process. On success, the descriptor is
+// freed and the segment owns the frames; else 0 is returned and the caller still owns them.
+void *seg_attach(seg_frames_t *frames);
+
+// Frees the given detached frames and their descriptor.
+void seg_frames_free(seg_frames_t *frames);
+
 void seg_trace(void);
 
 #endif
@@ -13,6 +13,8 @@
 #include <stddef.h>
 #include <util/container.h>
 #include <trace/trace.h>
+#include <mm/common.h>
+#include <trace/kstat.h>
 
 #define TLB_OP_QUEUE_SIZE 16
 
@@ -50,9 +52,15 @@ static void tlb_handle_ops(void)
 	spin_unlock(&tlbQueueLock);
 }
 
+// Number of committed TLB transactions, and of shootdown IPIs handled.
+KSTAT_COUNTER(tlbShootdowns, "tlb.shootdowns");
+KSTAT_COUNTER(tlbIpis, "tlb.ipis");
+
 // Interrupt service routine for the TLB IPI.
 static void tlb_handle_ipi(cpu_state_t *state)
 {
+	kstat_inc(&tlbIpis);
+	
 	// Handle this CPU's TLB queue
 	tlb_handle_ops();
 }
@@ -62,6 +70,9 @@ void tlb_init(void)
 	// Install TLB IPI interrupt
 	if(!intr_route_intr(IPI_TLB, &tlb_handle_ipi))
 		panic("failed to route TLB shootdown IPI");
+	
+	kstat_register(&tlbShootdowns);
+	kstat_register(&tlbIpis);
 }
 
 void tlb_transaction_init(void)
@@ -72,12 +83,26 @@ void tlb_transaction_init(void)
 
 void tlb_transaction_queue_invlpg(uintptr_t addr)
 {
+	// User space addresses belong to the address space of the current process
+	proc_t *proc = cpu_get()->proc;
+	bool userAddress = (addr <= VM_USER_END);
+	
+	// The skip check below reads cpu->proc of other cores, which proc_switch() sets before loading CR3. Make sure the
+	// page table update is visible before, else a core switching to the process right now could still fill its TLB
+	// from the old entry, while we already see the old process and skip it
+	if(userAddress)
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	
 	// Run through CPUs and add invalidate operations to their queues
 	list_for_each(&cpu_list, cpuNode)
 	{
 		// Get current CPU
 		cpu_t *cpu = container_of(cpuNode, cpu_t, node);
 		
+		// Isolated CPUs are skipped if they run another address space; switching the address space flushes the TLB anyway
+		if(cpu->isolated && userAddress && cpu->proc != proc)
+			continue;
+		
 		// Queue full? => Just replace everything with a flush operation
 		if(cpu->tlbOperationQueueLength == TLB_OP_QUEUE_SIZE)
 		{
@@ -104,11 +129,31 @@ void tlb_transaction_commit(void)
 {
 	// TLB transaction done, release lock
 	spin_unlock(&tlbQueueLock);
+	kstat_inc(&tlbShootdowns);
 	
 	// Handle queue on CPU doing the TLB transaction
 	tlb_handle_ops();
 
 	// Notify other CPUs to handle their TLB queues
 	if(smp_mode == MODE_SMP)
-		apic_ipi_all_exc_self(IPI_TLB);
+	{
+		// Broadcast, unless there are isolated CPUs which should not be disturbed
+		bool isolatedPresent = false;
+		list_for_each(&cpu_list, cpuNode)
+			if(container_of(cpuNode, cpu_t, node)->isolated)
+				isolatedPresent = true;
+		if(!isolatedPresent)
+			apic_ipi_all_exc_self(IPI_TLB);
+		else
+		{
+			// Only notify CPUs with pending operations
+			cpu_t *self = cpu_get();
+			list_for_each(&cpu_list, cpuNode)
+			{
+				cpu_t *cpu = container_of(cpuNode, cpu_t, node);
+				if(cpu != self && cpu->tlbOperationQueueLength > 0)
+					apic_ipi_fixed(cpu->lapic_id, IPI_TLB);
+			}
+		}
+	}
 }
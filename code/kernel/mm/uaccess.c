@@ -0,0 +1,62 @@
+
+#include <mm/uaccess.h>
+#include <mm/common.h>
+#include <mm/validate.h>
+
+// Entry of the fixup table: If the instruction at rip faults, execution continues at fixup.
+typedef struct
+{
+	uintptr_t rip;
+	uintptr_t fixup;
+} uaccess_fixup_t;
+
+// Bounds of the fixup table, defined by the linker script.
+extern uaccess_fixup_t _uaccess_fixup_start[];
+extern uaccess_fixup_t _uaccess_fixup_end[];
+
+// Copies len bytes, returns the number of bytes which could not be copied.
+uint64_t uaccess_copy(void *dest, const void *src, size_t len);
+
+// Copies a zero-terminated string of at most size bytes. Returns its length, size if it does not fit, or -1 on fault.
+int64_t uaccess_strncpy(char *dest, const char *src, size_t size);
+
+bool copy_from_user(void *dest, const void *userSrc, size_t len)
+{
+	if(!valid_buffer(userSrc, len))
+		return false;
+	return uaccess_copy(dest, userSrc, len) == 0;
+}
+
+bool copy_to_user(void *userDest, const void *src, size_t len)
+{
+	if(!valid_buffer(userDest, len))
+		return false;
+	return uaccess_copy(userDest, src, len) == 0;
+}
+
+int64_t strncpy_from_user(char *dest, const char *userSrc, size_t size)
+{
+	if(size == 0 || (uintptr_t)userSrc > VM_USER_END)
+		return -1;
+
+	// Do not read beyond the end of user space
+	if(size > VM_USER_END - (uintptr_t)userSrc + 1)
+		size = VM_USER_END - (uintptr_t)userSrc + 1;
+	int64_t length = uaccess_strncpy(dest, userSrc, size);
+	if(length < 0 || (size_t)length >= size)
+		return -1;
+	return length;
+}
+
+bool uaccess_handle_fault(cpu_state_t *state)
+{
+	for(uaccess_fixup_t *entry = _uaccess_fixup_start; entry < _uaccess_fixup_end; ++entry)
+	{
+		if(entry->rip == state->rip)
+		{
+			state->rip = entry->fixup;
+			return true;
+		}
+	}
+	return false;
+}
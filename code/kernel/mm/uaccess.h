@@ -0,0 +1,33 @@
+
+#ifndef _MM_UACCESS_H
+#define _MM_UACCESS_H
+
+#include <cpu/state.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Access to user memory from system calls.
+//
+// The user range is only checked to lie below VM_USER_END; whether it is mapped (and writable, as CR0.WP is set) is
+// found out by accessing it. If an access faults, the page fault handler looks up the faulting instruction in a fixup
+// table (see uaccess.s) and continues at the associated fixup code, so the function fails instead of the kernel
+// panicking.
+// Pointers passed by user space must only be dereferenced through these functions.
+
+// Copies len bytes from user space into the given kernel buffer. Returns false if the source is invalid.
+bool copy_from_user(void *dest, const void *userSrc, size_t len);
+
+// Copies len bytes from the given kernel buffer to user space. Returns false if the destination is invalid; it may
+// have been written partially.
+bool copy_to_user(void *userDest, const void *src, size_t len);
+
+// Copies a zero-terminated string from user space into the given kernel buffer of the given size. Returns the length
+// of the string, or -1 if it is invalid or does not fit.
+int64_t strncpy_from_user(char *dest, const char *userSrc, size_t size);
+
+// Called on a page fault in kernel mode. If the fault was caused by one of the functions above, the state is modified
+// to continue at the fixup code and true is returned.
+bool uaccess_handle_fault(cpu_state_t *state);
+
+#endif
@@ -0,0 +1,77 @@
+; Copy routines for user memory (see uaccess.h). Each instruction which accesses user memory gets an entry in the
+; fixup table, so a fault continues at the routine's error exit instead of panicking.
+
+; Adds a fixup table entry: If the instruction at %1 faults, continue at %2.
+%macro fixup 2
+[section .uaccess_fixup]
+	dq %1, %2
+__SECT__
+%endmacro
+
+[extern memFastStrings]
+
+; Flags of memFastStrings, must match string.c.
+STRING_ERMS equ 0x1
+STRING_FSRM equ 0x2
+
+; Copies a block of memory.
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Source.
+;     - rdx: Length.
+; Return value:
+;     - rax: Number of bytes which were not copied (0 on success).
+; Like memcpy(), REP MOVSB is only used if the CPU has fast string operations (see mem.s).
+[global uaccess_copy]
+uaccess_copy:
+	mov rcx, rdx
+	test byte [rel memFastStrings], STRING_ERMS | STRING_FSRM
+	jnz .copy
+	shr rcx, 3
+.copy_qwords:
+	rep movsq
+	mov ecx, edx
+	and ecx, 7
+.copy:
+	rep movsb
+	xor eax, eax
+	ret
+.fault:
+	; the string instruction has updated RCX up to the faulting byte
+	mov rax, rcx
+	ret
+.fault_qwords:
+	; RCX holds the remaining qwords, the tail bytes were not copied either
+	shl rcx, 3
+	and edx, 7
+	lea rax, [rcx + rdx]
+	ret
+fixup uaccess_copy.copy_qwords, uaccess_copy.fault_qwords
+fixup uaccess_copy.copy, uaccess_copy.fault
+
+; Copies a zero-terminated string.
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Source.
+;     - rdx: Size of the destination buffer.
+; Return value:
+;     - rax: Length of the string; the size if there was no terminator within the buffer size; -1 on fault.
+[global uaccess_strncpy]
+uaccess_strncpy:
+	xor eax, eax
+.loop:
+	cmp rax, rdx
+	jae .done
+.load:
+	movzx ecx, byte [rsi + rax]
+	mov [rdi + rax], cl
+	test cl, cl
+	jz .done
+	inc rax
+	jmp .loop
+.done:
+	ret
+.fault:
+	mov rax, -1
+	ret
+fixup uaccess_strncpy.load, uaccess_strncpy.fault
@@ -241,7 +241,7 @@ static bool _vmm_touch(uintptr_t virt, int size)
 		tlb_transaction_queue_invlpg((uintptr_t)index.pml3);
 		
 		// Make sure new PML3 is empty
-		memset(index.pml3, 0, FRAME_SIZE);
+		clear_page(index.pml3);
 	}
 
 	// 1G pages only need a PML3 entry
@@ -270,7 +270,7 @@ static bool _vmm_touch(uintptr_t virt, int size)
 		tlb_transaction_queue_invlpg((uintptr_t)index.pml2);
 		
 		// Make sure new PML2 is empty
-		memset(index.pml2, 0, FRAME_SIZE);
+		clear_page(index.pml2);
 	}
 
 	// 2M pages only need a PML2 entry
@@ -298,7 +298,7 @@ static bool _vmm_touch(uintptr_t virt, int size)
 		tlb_transaction_queue_invlpg((uintptr_t)index.pml1);
 		
 		// Make sure new PML1 is empty
-		memset(index.pml1, 0, FRAME_SIZE);
+		clear_page(index.pml1);
 	}
 	
 	// All PMLs created
@@ -705,4 +705,56 @@ uint64_t vmm_modify_flags(uintptr_t virt, uint64_t flags, bool set)
 	tlb_transaction_commit();
 	vmm_unlock(virt);
 	return entry;
-}
\ No newline at end of file
+}
+
+void vmm_destroy_user_space(void)
+{
+	// Walk the user-space half of the current PML4 table and free all mapped frames and page tables
+	uint64_t *pml4 = (uint64_t *)PML4_OFFSET;
+	for(size_t pml4index = 0; pml4index < PAGE_TABLE_ENTRY_COUNT / 2; ++pml4index)
+	{
+		if(!(pml4[pml4index] & PG_PRESENT))
+			continue;
+
+		uint64_t *pml3 = (uint64_t *)(PML3_OFFSET + pml4index * FRAME_SIZE);
+		for(size_t pml3index = 0; pml3index < PAGE_TABLE_ENTRY_COUNT; ++pml3index)
+		{
+			uint64_t pml3entry = pml3[pml3index];
+			if(!(pml3entry & PG_PRESENT))
+				continue;
+			if(pml3entry & PG_BIG)
+			{
+				pmm_frees(SIZE_1G, pml3entry & PG_ADDR_MASK);
+				continue;
+			}
+
+			uint64_t *pml2 = (uint64_t *)(PML2_OFFSET + pml4index * FRAME_SIZE_2M + pml3index * FRAME_SIZE);
+			for(size_t pml2index = 0; pml2index < PAGE_TABLE_ENTRY_COUNT; ++pml2index)
+			{
+				uint64_t pml2entry = pml2[pml2index];
+				if(!(pml2entry & PG_PRESENT))
+					continue;
+				if(pml2entry & PG_BIG)
+				{
+					pmm_frees(SIZE_2M, pml2entry & PG_ADDR_MASK);
+					continue;
+				}
+
+				uint64_t *pml1 = (uint64_t *)(PML1_OFFSET + pml4index * FRAME_SIZE_1G + pml3index * FRAME_SIZE_2M + pml2index * FRAME_SIZE);
+				for(size_t pml1index = 0; pml1index < PAGE_TABLE_ENTRY_COUNT; ++pml1index)
+					if(pml1[pml1index] & PG_PRESENT)
+						pmm_free(pml1[pml1index] & PG_ADDR_MASK);
+
+				// PML1 table
+				pmm_free(pml2entry & PG_ADDR_MASK);
+			}
+
+			// PML2 table
+			pmm_free(pml3entry & PG_ADDR_MASK);
+		}
+
+		// PML3 table
+		pmm_free(pml4[pml4index] & PG_ADDR_MASK);
+		pml4[pml4index] = 0;
+	}
+}
@@ -28,4 +28,9 @@ uint64_t vmm_virt_to_phys(uintptr_t virt);
 
 uint64_t vmm_modify_flags(uintptr_t virt, uint64_t flags, bool set);
 
+// Frees all user-space mappings, their frames and page tables in the current address space.
+// No TLB invalidations are done, so the address space must not be in use by any other CPU, and the caller needs to
+// switch to another address space afterwards.
+void vmm_destroy_user_space(void);
+
 #endif
@@ -11,6 +11,9 @@ Intel 8254x (e1000) ethernet driver.
 #include <stdlib/string.h>
 #include <mm/heap.h>
 #include <cpu/pause.h>
+#include <lock/spinlock.h>
+#include <proc/workqueue.h>
+#include <proc/events.h>
 
 // Maximum Transmission Unit (this value is slightly arbitrary, it matches the value used in the user-space LWIP wrapper).
 #define E1000_MTU 1522
@@ -115,6 +118,13 @@ static received_packet_t *receivedPacketsQueueEnd;
 // Start node of the received packets buffer list.
 static received_packet_t *receivedPacketsBufferListStart;
 
+// Lock for the list of received packets. Only taken in thread context, so it leaves interrupts enabled.
+static spinlock_t receiveLock = SPIN_UNLOCKED;
+
+// Deferred processing of received packets, queued by the interrupt handler.
+static work_t receiveWork;
+static void e1000_receive(work_t *work);
+
 
 // Reads the given device register using MMIO.
 static uint32_t e1000_read(e1000_register_t reg)
@@ -278,6 +288,9 @@ void e1000_init(pci_cfgspace_header_0_t *deviceCfgSpaceHeader)
 	//rctl |= 0x00000018; // UPE+MPE (Promiscuous mode)           -> for testing only!
 	e1000_write(E1000_REG_RCTL, rctl);
 	
+	// Received packets are copied outside of interrupt context
+	work_init(&receiveWork, &e1000_receive);
+	
 	// Pre-allocate some buffers for the received packets list
 	receivedPacketsQueueStart = 0;
 	receivedPacketsQueueEnd = 0;
@@ -340,10 +353,13 @@ void e1000_send(uint8_t *packet, int packetLength)
 	//trace_printf("Passing packet to device done.\n");
 }
 
-// Processes one received packet.
+// Processes all received packets. Runs in the worker thread, deferred by the receive interrupt.
 // TODO use ITR (interrupt throttling register) to fire interrupts for multiple packets at once (less interrupts)
-static void e1000_receive()
+static void e1000_receive(work_t *work)
 {
+	spin_lock_plain(&receiveLock);
+	bool received = false;
+	
 	// Receive multiple packets
 	for(int p = 0; p < RX_DESC_COUNT; ++p)
 	{
@@ -396,6 +412,7 @@ static void e1000_receive()
 					receivedPacketsQueueEnd->next = bufferEntry;
 				receivedPacketsQueueEnd = bufferEntry;
 				bufferEntry->next = 0;
+				received = true;
 			}
 			
 			// Reset status
@@ -408,13 +425,24 @@ static void e1000_receive()
 		else
 			break; // No more received packets
 	}
+	
+	spin_unlock_plain(&receiveLock);
+	
+	// Wake up threads waiting for packets
+	if(received)
+		events_notify();
 }
 
 int e1000_next_received_packet(uint8_t *packetBuffer)
 {
+	spin_lock_plain(&receiveLock);
+	
 	// Any packet available?
 	if(!receivedPacketsQueueStart)
+	{
+		spin_unlock_plain(&receiveLock);
 		return 0;
+	}
 	
 	// Remove packet buffer entry from queue
 	received_packet_t *bufferEntry = receivedPacketsQueueStart;
@@ -431,9 +459,15 @@ int e1000_next_received_packet(uint8_t *packetBuffer)
 	receivedPacketsBufferListStart = bufferEntry;
 	
 	// Done
+	spin_unlock_plain(&receiveLock);
 	return packetLength;
 }
 
+bool e1000_has_received_packet(void)
+{
+	return __atomic_load_n(&receivedPacketsQueueStart, __ATOMIC_ACQUIRE) != 0;
+}
+
 bool e1000_handle_interrupt(cpu_state_t *state)
 {
 	// Read interrupt cause register
@@ -445,8 +479,8 @@ bool e1000_handle_interrupt(cpu_state_t *state)
 	//trace_printf("Intel8254x interrupt! ICR: %08x\n", icr);
 	if(icr & E1000_ICR_RXT0)
 	{
-		// Receive timer expired, handle received packets
-		e1000_receive();
+		// Receive timer expired, handle received packets in the worker thread
+		work_queue(&receiveWork);
 	}
 	return true;
 }
\ No newline at end of file
@@ -11,7 +11,9 @@ Intel e1000e (I217/I218/I219) ethernet driver.
 #include <stdlib/string.h>
 #include <mm/heap.h>
 #include <cpu/pause.h>
-#include <lock/raw_spinlock.h>
+#include <lock/spinlock.h>
+#include <proc/workqueue.h>
+#include <proc/events.h>
 
 // Maximum Transmission Unit (this value is slightly arbitrary, it matches the value used in the user-space LWIP wrapper).
 #define E1000E_MTU 1522
@@ -119,8 +121,12 @@ static received_packet_t *receivedPacketsBufferListStart;
 // Determines whether initialization is done.
 static bool initialized = false;
 
-// Lock for the list of received packets.
-static raw_spinlock_t receiveLock = RAW_SPINLOCK_UNLOCKED;
+// Lock for the list of received packets. Only taken in thread context, so it leaves interrupts enabled.
+static spinlock_t receiveLock = SPIN_UNLOCKED;
+
+// Deferred processing of received packets, queued by the interrupt handler.
+static work_t receiveWork;
+static void e1000e_receive(work_t *work);
 
 
 // Reads the given device register using MMIO.
@@ -343,6 +349,9 @@ void e1000e_init(pci_cfgspace_header_0_t *deviceCfgSpaceHeader)
 
 	
 	
+	// Received packets are copied outside of interrupt context
+	work_init(&receiveWork, &e1000e_receive);
+	
 	// Pre-allocate some buffers for the received packets list
 	receivedPacketsQueueStart = 0;
 	receivedPacketsQueueEnd = 0;
@@ -535,11 +544,12 @@ void e1000e_send(uint8_t *packet, int packetLength)
 	//debug_regs();
 }
 
-// Processes one received packet.
+// Processes all received packets. Runs in the worker thread, deferred by the receive interrupt.
 // TODO use ITR (interrupt throttling register) to fire interrupts for multiple packets at once (less interrupts)
-static void e1000e_receive()
+static void e1000e_receive(work_t *work)
 {
-	raw_spinlock_lock(&receiveLock);
+	spin_lock_plain(&receiveLock);
+	bool received = false;
 	
 	// Receive multiple packets
 	for(int p = 0; p < RX_DESC_COUNT; ++p)
@@ -593,6 +603,7 @@ static void e1000e_receive()
 					receivedPacketsQueueEnd->next = bufferEntry;
 				receivedPacketsQueueEnd = bufferEntry;
 				bufferEntry->next = 0;
+				received = true;
 			}
 			
 			// Reset status
@@ -606,16 +617,23 @@ static void e1000e_receive()
 			break; // No more received packets
 	}
 	
-	raw_spinlock_unlock(&receiveLock);
+	spin_unlock_plain(&receiveLock);
+	
+	// Wake up threads waiting for packets
+	if(received)
+		events_notify();
 }
 
 int e1000e_next_received_packet(uint8_t *packetBuffer)
 {
+	spin_lock_plain(&receiveLock);
+	
 	// Any packet available?
 	if(!receivedPacketsQueueStart)
+	{
+		spin_unlock_plain(&receiveLock);
 		return 0;
-	
-	raw_spinlock_lock(&receiveLock);
+	}
 	
 	// Remove packet buffer entry from queue
 	received_packet_t *bufferEntry = receivedPacketsQueueStart;
@@ -632,10 +650,15 @@ int e1000e_next_received_packet(uint8_t *packetBuffer)
 	receivedPacketsBufferListStart = bufferEntry;
 	
 	// Done
-	raw_spinlock_unlock(&receiveLock);
+	spin_unlock_plain(&receiveLock);
 	return packetLength;
 }
 
+bool e1000e_has_received_packet(void)
+{
+	return __atomic_load_n(&receivedPacketsQueueStart, __ATOMIC_ACQUIRE) != 0;
+}
+
 bool e1000e_handle_interrupt(cpu_state_t *state)
 {
 	// Ensure initialization is done
@@ -654,8 +677,8 @@ bool e1000e_handle_interrupt(cpu_state_t *state)
 	//trace_printf("Intel e1000e interrupt! ICR: %08x\n", icr);
 	if(icr & E1000_ICR_RXT0)
 	{
-		// Receive timer expired, handle received packets
-		e1000e_receive();
+		// Receive timer expired, handle received packets in the worker thread
+		work_queue(&receiveWork);
 	}
 	else if(icr == 0x00000002) // TODO only for debugging - needed?
 		e1000e_write(E1000_REG_ICR, 0x00000002);
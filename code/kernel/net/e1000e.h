@@ -19,6 +19,9 @@ void e1000e_send(uint8_t *packet, int packetLength);
 // If there is no packet present, 0 is returned.
 int e1000e_next_received_packet(uint8_t *packetBuffer);
 
+// Determines whether a received packet is pending.
+bool e1000e_has_received_packet(void);
+
 // Checks whether this device caused a PCI interrupt and handles it.
 // If the interrupt was caused by another device, false is returned.
 bool e1000e_handle_interrupt(cpu_state_t *state);
\ No newline at end of file
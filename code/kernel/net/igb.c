@@ -11,7 +11,9 @@ Intel igb (I210/I211) ethernet driver.
 #include <stdlib/string.h>
 #include <mm/heap.h>
 #include <cpu/pause.h>
-#include <lock/raw_spinlock.h>
+#include <lock/spinlock.h>
+#include <proc/workqueue.h>
+#include <proc/events.h>
 #include <time/pit.h>
 
 // Maximum Transmission Unit (this value is slightly arbitrary, it matches the value used in the user-space LWIP wrapper).
@@ -120,8 +122,12 @@ static received_packet_t *receivedPacketsBufferListStart;
 // Determines whether initialization is done.
 static bool initialized = false;
 
-// Lock for the list of received packets.
-static raw_spinlock_t receiveLock = RAW_SPINLOCK_UNLOCKED;
+// Lock for the list of received packets. Only taken in thread context, so it leaves interrupts enabled.
+static spinlock_t receiveLock = SPIN_UNLOCKED;
+
+// Deferred processing of received packets, queued by the interrupt handler.
+static work_t receiveWork;
+static void igb_receive(work_t *work);
 
 
 // Helper function for debugging. TODO remove
@@ -334,6 +340,9 @@ void igb_init(pci_cfgspace_header_0_t *deviceCfgSpaceHeader)
 
 	
 	
+	// Received packets are copied outside of interrupt context
+	work_init(&receiveWork, &igb_receive);
+	
 	// Pre-allocate some buffers for the received packets list
 	receivedPacketsQueueStart = 0;
 	receivedPacketsQueueEnd = 0;
@@ -530,11 +539,12 @@ void igb_send(uint8_t *packet, int packetLength)
 	//debug_regs();
 }
 
-// Processes one received packet.
+// Processes all received packets. Runs in the worker thread, deferred by the receive interrupt.
 // TODO use ITR (interrupt throttling register) to fire interrupts for multiple packets at once (less interrupts)
-static void igb_receive()
+static void igb_receive(work_t *work)
 {
-	raw_spinlock_lock(&receiveLock);
+	spin_lock_plain(&receiveLock);
+	bool received = false;
 	
 	// Receive multiple packets
 	for(int p = 0; p < RX_DESC_COUNT; ++p)
@@ -588,6 +598,7 @@ static void igb_receive()
 					receivedPacketsQueueEnd->next = bufferEntry;
 				receivedPacketsQueueEnd = bufferEntry;
 				bufferEntry->next = 0;
+				received = true;
 			}
 			
 			// Reset status
@@ -601,16 +612,23 @@ static void igb_receive()
 			break; // No more received packets
 	}
 	
-	raw_spinlock_unlock(&receiveLock);
+	spin_unlock_plain(&receiveLock);
+	
+	// Wake up threads waiting for packets
+	if(received)
+		events_notify();
 }
 
 int igb_next_received_packet(uint8_t *packetBuffer)
 {
+	spin_lock_plain(&receiveLock);
+	
 	// Any packet available?
 	if(!receivedPacketsQueueStart)
+	{
+		spin_unlock_plain(&receiveLock);
 		return 0;
-	
-	raw_spinlock_lock(&receiveLock);
+	}
 	
 	// Remove packet buffer entry from queue
 	received_packet_t *bufferEntry = receivedPacketsQueueStart;
@@ -627,10 +645,15 @@ int igb_next_received_packet(uint8_t *packetBuffer)
 	receivedPacketsBufferListStart = bufferEntry;
 	
 	// Done
-	raw_spinlock_unlock(&receiveLock);
+	spin_unlock_plain(&receiveLock);
 	return packetLength;
 }
 
+bool igb_has_received_packet(void)
+{
+	return __atomic_load_n(&receivedPacketsQueueStart, __ATOMIC_ACQUIRE) != 0;
+}
+
 bool igb_handle_interrupt(cpu_state_t *state)
 {
 	// Ensure initialization is done
@@ -649,8 +672,8 @@ bool igb_handle_interrupt(cpu_state_t *state)
 	//trace_printf("Intel igb interrupt! ICR: %08x\n", icr);
 	if(icr & 0x00000080)
 	{
-		// Receive timer expired, handle received packets
-		igb_receive();
+		// Receive timer expired, handle received packets in the worker thread
+		work_queue(&receiveWork);
 	}
 	else if(icr == 0x00000002) // TODO only for debugging - needed?
 		igb_write(IGB_REG_ICR, 0x00000002);
@@ -26,6 +26,9 @@ static void (*netdev_send)(uint8_t *packet, int packetLength) = 0;
 // Pointer to the network device receive function.
 static int (*netdev_next_received_packet)(uint8_t *packetBuffer) = 0;
 
+// Pointer to the network device receive queue check function.
+static bool (*netdev_has_received_packet)(void) = 0;
+
 // Pointer to the network device interrupt handling function.
 static bool (*netdev_handle_interrupt)(cpu_state_t *state) = 0;
 
@@ -62,6 +65,7 @@ void net_init(pci_cfgspace_header_0_t *deviceCfgSpaceHeader)
 			netdev_get_mac_address = &e1000_get_mac_address;
 			netdev_send = &e1000_send;
 			netdev_next_received_packet = &e1000_next_received_packet;
+			netdev_has_received_packet = &e1000_has_received_packet;
 			netdev_handle_interrupt = &e1000_handle_interrupt;
 			found = true;
 		}
@@ -72,6 +76,7 @@ void net_init(pci_cfgspace_header_0_t *deviceCfgSpaceHeader)
 			netdev_get_mac_address = &e1000e_get_mac_address;
 			netdev_send = &e1000e_send;
 			netdev_next_received_packet = &e1000e_next_received_packet;
+			netdev_has_received_packet = &e1000e_has_received_packet;
 			netdev_handle_interrupt = &e1000e_handle_interrupt;
 			found = true;
 		}
@@ -82,6 +87,7 @@ void net_init(pci_cfgspace_header_0_t *deviceCfgSpaceHeader)
 			netdev_get_mac_address = &igb_get_mac_address;
 			netdev_send = &igb_send;
 			netdev_next_received_packet = &igb_next_received_packet;
+			netdev_has_received_packet = &igb_has_received_packet;
 			netdev_handle_interrupt = &igb_handle_interrupt;
 			found = true;
 		}
@@ -120,6 +126,14 @@ int net_next_received_packet(uint8_t *packetBuffer)
 	return netdev_next_received_packet(packetBuffer);
 }
 
+bool net_has_received_packet(void)
+{
+	// Without device, there are no packets
+	if(!netdev_has_received_packet)
+		return false;
+	return netdev_has_received_packet();
+}
+
 bool net_handle_interrupt(cpu_state_t *state)
 {
 	// Call device function, if it exists
@@ -20,6 +20,9 @@ void net_send(uint8_t *packet, int packetLength);
 // If there is no packet present, 0 is returned.
 int net_next_received_packet(uint8_t *packetBuffer);
 
+// Determines whether a received packet is pending. Returns false if there is no network device.
+bool net_has_received_packet(void);
+
 // Checks whether this device caused a PCI interrupt and handles it.
 // If the interrupt was caused by another device, false is returned.
 bool net_handle_interrupt(cpu_state_t *state);
\ No newline at end of file
@@ -0,0 +1,485 @@
+
+#include <proc/channel.h>
+#include <proc/events.h>
+#include <proc/proc.h>
+#include <proc/wait.h>
+#include <mm/heap.h>
+#include <mm/seg.h>
+#include <lock/spinlock.h>
+#include <util/container.h>
+#include <util/list.h>
+#include <stdlib/stdlib.h>
+#include <stdlib/string.h>
+
+// A memory grant waiting to be accepted.
+typedef struct
+{
+	list_node_t node;
+	seg_frames_t *frames;
+} channel_grant_t;
+
+typedef struct channel
+{
+	// Node in the list of named channels. The channel is removed from the list when it is connected or its creator
+	// closes it, so the name can be reused.
+	list_node_t node;
+	bool listed;
+	char name[CHANNEL_NAME_LENGTH];
+
+	// Both rings; endpoint i receives from rings[i] and sends into rings[1 - i].
+	channel_ring_t *rings;
+
+	// Determines whether the endpoints are open.
+	bool open[2];
+
+	// Number of system calls currently using the channel through either endpoint. The channel is freed when both
+	// endpoints are closed and no call is in progress anymore.
+	int busy[2];
+
+	// Pending memory grants per receiving endpoint, and their count (read without the lock by waiting threads).
+	list_t grants[2];
+	int grantCount[2];
+
+	// Protects the fields above.
+	spinlock_t lock;
+
+	// Threads waiting for events of this channel.
+	wait_queue_t waiters;
+} channel_t;
+
+// Named channels which can be connected to.
+static list_t channelList = LIST_EMPTY;
+static spinlock_t channelListLock = SPIN_UNLOCKED;
+
+// Frees the given channel and its pending grants. The channel must be unused.
+static void channel_free(channel_t *channel)
+{
+	for(int e = 0; e < 2; ++e)
+	{
+		list_for_each(&channel->grants[e], node)
+		{
+			channel_grant_t *grant = container_of(node, channel_grant_t, node);
+			seg_frames_free(grant->frames);
+			free(grant);
+		}
+	}
+	heap_free(channel->rings);
+	free(channel);
+}
+
+// Determines whether the given channel is unused. The channel lock must be held.
+static bool channel_unused(channel_t *channel)
+{
+	return !channel->open[0] && !channel->open[1] && channel->busy[0] == 0 && channel->busy[1] == 0;
+}
+
+// Stores a new handle of the current process for the given endpoint and maps the rings. Returns the handle or -1.
+static int channel_add_handle(channel_t *channel, int endpoint, channel_info_t *info)
+{
+	proc_t *proc = proc_get();
+	channel_ring_t *userRings = seg_map_shared(channel->rings, 2 * sizeof(channel_ring_t), VM_R | VM_W);
+	if(!userRings)
+		return -1;
+
+	int handle = -1;
+	spin_lock(&proc->channelLock);
+	for(int h = 0; h < CHANNEL_MAX_HANDLES; ++h)
+	{
+		if(!proc->channels[h].channel)
+		{
+			proc->channels[h].channel = channel;
+			proc->channels[h].endpoint = endpoint;
+			proc->channels[h].userRings = userRings;
+			handle = h;
+			break;
+		}
+	}
+	spin_unlock(&proc->channelLock);
+
+	if(handle < 0)
+	{
+		seg_unmap_shared(userRings);
+		return -1;
+	}
+
+	info->receiveRing = &userRings[endpoint];
+	info->sendRing = &userRings[1 - endpoint];
+	return handle;
+}
+
+int channel_create(const char *name, channel_info_t *info)
+{
+	// Create channel
+	channel_t *channel = malloc(sizeof(channel_t));
+	if(!channel)
+		return -1;
+	channel->rings = heap_alloc(2 * sizeof(channel_ring_t), VM_R | VM_W);
+	if(!channel->rings)
+	{
+		free(channel);
+		return -1;
+	}
+	memclr(channel->rings, 2 * sizeof(channel_ring_t));
+	strncpy(channel->name, name, CHANNEL_NAME_LENGTH - 1);
+	channel->name[CHANNEL_NAME_LENGTH - 1] = '\0';
+	channel->listed = false;
+	channel->open[0] = true;
+	channel->open[1] = false;
+	channel->busy[0] = 0;
+	channel->busy[1] = 0;
+	for(int e = 0; e < 2; ++e)
+	{
+		list_init(&channel->grants[e]);
+		channel->grantCount[e] = 0;
+	}
+	channel->lock = SPIN_UNLOCKED;
+	wait_queue_init(&channel->waiters);
+
+	// Publish it, if the name is free
+	bool nameUsed = false;
+	spin_lock_plain(&channelListLock);
+	list_for_each(&channelList, node)
+	{
+		if(strcmp(container_of(node, channel_t, node)->name, channel->name) == 0)
+		{
+			nameUsed = true;
+			break;
+		}
+	}
+	if(!nameUsed)
+	{
+		list_add_tail(&channelList, &channel->node);
+		channel->listed = true;
+	}
+	spin_unlock_plain(&channelListLock);
+	if(nameUsed)
+	{
+		channel->open[0] = false;
+		channel_free(channel);
+		return -1;
+	}
+
+	int handle = channel_add_handle(channel, 0, info);
+	if(handle < 0)
+	{
+		// Nobody can have connected yet, as the caller did not get the handle
+		spin_lock_plain(&channelListLock);
+		list_remove(&channelList, &channel->node);
+		spin_unlock_plain(&channelListLock);
+		channel->open[0] = false;
+		channel_free(channel);
+	}
+	return handle;
+}
+
+int channel_connect(const char *name, channel_info_t *info)
+{
+	// Find the channel and take the second endpoint
+	channel_t *channel = 0;
+	spin_lock_plain(&channelListLock);
+	list_for_each(&channelList, node)
+	{
+		channel_t *current = container_of(node, channel_t, node);
+		if(strncmp(current->name, name, CHANNEL_NAME_LENGTH - 1) == 0)
+		{
+			channel = current;
+			spin_lock_plain(&channel->lock);
+			channel->open[1] = true;
+			++channel->busy[1];
+			spin_unlock_plain(&channel->lock);
+			list_remove(&channelList, &channel->node);
+			channel->listed = false;
+			break;
+		}
+	}
+	spin_unlock_plain(&channelListLock);
+	if(!channel)
+		return -1;
+
+	int handle = channel_add_handle(channel, 1, info);
+
+	// Tell the creator about the connection (or failure). This is done with the lock held, as the channel may be freed
+	// by the other side as soon as it is released
+	spin_lock_plain(&channel->lock);
+	--channel->busy[1];
+	if(handle < 0)
+		channel->open[1] = false;
+	wait_wake_all(&channel->waiters);
+	bool unused = channel_unused(channel);
+	spin_unlock_plain(&channel->lock);
+	events_notify();
+
+	if(unused)
+		channel_free(channel);
+	return handle;
+}
+
+// Looks up the given handle of the current process and marks the channel as busy. Returns 0 if the handle is invalid.
+static channel_t *channel_get(int handle, int *endpoint)
+{
+	if(handle < 0 || handle >= CHANNEL_MAX_HANDLES)
+		return 0;
+
+	proc_t *proc = proc_get();
+	spin_lock(&proc->channelLock);
+	channel_t *channel = proc->channels[handle].channel;
+	if(channel)
+	{
+		*endpoint = proc->channels[handle].endpoint;
+		spin_lock_plain(&channel->lock);
+		++channel->busy[*endpoint];
+		spin_unlock_plain(&channel->lock);
+	}
+	spin_unlock(&proc->channelLock);
+	return channel;
+}
+
+// Ends a use of the given channel started with channel_get(), and frees it if it is unused now.
+static void channel_put(channel_t *channel, int endpoint)
+{
+	spin_lock_plain(&channel->lock);
+	--channel->busy[endpoint];
+	bool unused = channel_unused(channel);
+	spin_unlock_plain(&channel->lock);
+	if(unused)
+		channel_free(channel);
+}
+
+// Marks the given endpoint as closed and wakes up the other side. If the process is gone, its calls in progress are
+// dropped as well. Frees the channel if it is unused now.
+static void channel_close_endpoint(channel_t *channel, int endpoint, bool processDead)
+{
+	// Unpublish the name, if nobody has connected yet
+	spin_lock_plain(&channelListLock);
+	if(channel->listed)
+	{
+		list_remove(&channelList, &channel->node);
+		channel->listed = false;
+	}
+	spin_unlock_plain(&channelListLock);
+
+	spin_lock_plain(&channel->lock);
+	channel->open[endpoint] = false;
+	if(processDead)
+		channel->busy[endpoint] = 0;
+	wait_wake_all(&channel->waiters);
+	bool unused = channel_unused(channel);
+	spin_unlock_plain(&channel->lock);
+	events_notify();
+
+	if(unused)
+		channel_free(channel);
+}
+
+void channel_close(int handle)
+{
+	if(handle < 0 || handle >= CHANNEL_MAX_HANDLES)
+		return;
+
+	proc_t *proc = proc_get();
+	spin_lock(&proc->channelLock);
+	channel_handle_t entry = proc->channels[handle];
+	proc->channels[handle].channel = 0;
+	spin_unlock(&proc->channelLock);
+	if(!entry.channel)
+		return;
+
+	seg_unmap_shared(entry.userRings);
+	channel_close_endpoint(entry.channel, entry.endpoint, false);
+}
+
+void channel_close_all(proc_t *proc)
+{
+	// The rings were unmapped together with the address space
+	for(int h = 0; h < CHANNEL_MAX_HANDLES; ++h)
+	{
+		channel_handle_t entry = proc->channels[h];
+		proc->channels[h].channel = 0;
+		if(entry.channel)
+			channel_close_endpoint(entry.channel, entry.endpoint, true);
+	}
+}
+
+// Determines the events which occurred at the given endpoint. Only reads fields which are not protected by the channel
+// lock.
+static int channel_pending_events(channel_t *channel, int endpoint)
+{
+	channel_ring_t *receiveRing = &channel->rings[endpoint];
+	channel_ring_t *sendRing = &channel->rings[1 - endpoint];
+
+	int occurred = 0;
+	if(__atomic_load_n(&receiveRing->head, __ATOMIC_ACQUIRE) != __atomic_load_n(&receiveRing->tail, __ATOMIC_ACQUIRE))
+		occurred |= CHANNEL_EVENT_READABLE;
+	if(__atomic_load_n(&sendRing->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&sendRing->tail, __ATOMIC_ACQUIRE) < CHANNEL_RING_DATA_SIZE)
+		occurred |= CHANNEL_EVENT_WRITABLE;
+	if(__atomic_load_n(&channel->grantCount[endpoint], __ATOMIC_ACQUIRE) > 0)
+		occurred |= CHANNEL_EVENT_GRANT;
+
+	// The connector's side is closed before it is connected as well, so check whether the other side was used at all
+	int other = 1 - endpoint;
+	if(!__atomic_load_n(&channel->open[other], __ATOMIC_ACQUIRE) && (endpoint == 1 || !__atomic_load_n(&channel->listed, __ATOMIC_ACQUIRE)))
+		occurred |= CHANNEL_EVENT_CLOSED;
+	return occurred;
+}
+
+// Arguments of the wait condition.
+typedef struct
+{
+	channel_t *channel;
+	int endpoint;
+	int events;
+	int occurred;
+} channel_wait_args_t;
+
+// Wait condition of channel_wait(): Determines the events which occurred.
+static bool channel_check_events(void *arg)
+{
+	channel_wait_args_t *args = (channel_wait_args_t *)arg;
+	args->occurred = channel_pending_events(args->channel, args->endpoint) & args->events;
+	return args->occurred != 0;
+}
+
+int channel_wait(int handle, int events, int64_t timeoutMs)
+{
+	int endpoint;
+	channel_t *channel = channel_get(handle, &endpoint);
+	if(!channel)
+		return 0;
+
+	channel_wait_args_t args = { .channel = channel, .endpoint = endpoint, .events = events, .occurred = 0 };
+	wait_event(&channel->waiters, &channel_check_events, &args, timeoutMs);
+
+	channel_put(channel, endpoint);
+	return args.occurred;
+}
+
+void channel_wait_all_begin(proc_t *proc)
+{
+	spin_lock(&proc->channelLock);
+	++proc->channelAllWaiters;
+	spin_unlock(&proc->channelLock);
+}
+
+bool channel_check_all(proc_t *proc)
+{
+	// The handle table keeps our endpoints open, so the channels stay alive while the lock is held
+	bool ready = false;
+	spin_lock(&proc->channelLock);
+	for(int h = 0; h < CHANNEL_MAX_HANDLES; ++h)
+	{
+		channel_t *channel = proc->channels[h].channel;
+		if(!channel)
+			continue;
+
+		// Set the flag before looking at the ring, the sender does it the other way round
+		int endpoint = proc->channels[h].endpoint;
+		__atomic_store_n(&channel->rings[endpoint].receiverWaiting, 1, __ATOMIC_SEQ_CST);
+		if(channel_pending_events(channel, endpoint) & (CHANNEL_EVENT_READABLE | CHANNEL_EVENT_GRANT | CHANNEL_EVENT_CLOSED))
+			ready = true;
+	}
+	spin_unlock(&proc->channelLock);
+	return ready;
+}
+
+void channel_wait_all_end(proc_t *proc)
+{
+	// Other threads of the process may still be waiting; the last one clears the flags. As waiters set the flags under
+	// the lock as well, a thread which starts waiting afterwards sets them again.
+	spin_lock(&proc->channelLock);
+	if(--proc->channelAllWaiters == 0)
+	{
+		for(int h = 0; h < CHANNEL_MAX_HANDLES; ++h)
+		{
+			channel_t *channel = proc->channels[h].channel;
+			if(channel)
+				__atomic_store_n(&channel->rings[proc->channels[h].endpoint].receiverWaiting, 0, __ATOMIC_SEQ_CST);
+		}
+	}
+	spin_unlock(&proc->channelLock);
+}
+
+void channel_notify(int handle)
+{
+	int endpoint;
+	channel_t *channel = channel_get(handle, &endpoint);
+	if(!channel)
+		return;
+
+	wait_wake_all(&channel->waiters);
+	events_notify();
+	channel_put(channel, endpoint);
+}
+
+bool channel_grant(int handle, void *addr)
+{
+	int endpoint;
+	channel_t *channel = channel_get(handle, &endpoint);
+	if(!channel)
+		return false;
+
+	// Only grant to a connected peer, else the memory would just be dropped
+	int other = 1 - endpoint;
+	bool ok = false;
+	channel_grant_t *grant = malloc(sizeof(channel_grant_t));
+	if(grant)
+		grant->frames = 0;
+	if(grant && __atomic_load_n(&channel->open[other], __ATOMIC_ACQUIRE))
+		grant->frames = seg_detach(addr);
+	if(grant && grant->frames)
+	{
+		spin_lock_plain(&channel->lock);
+		list_add_tail(&channel->grants[other], &grant->node);
+		__atomic_fetch_add(&channel->grantCount[other], 1, __ATOMIC_RELEASE);
+		spin_unlock_plain(&channel->lock);
+		wait_wake_all(&channel->waiters);
+		events_notify();
+		ok = true;
+	}
+	else
+		free(grant);
+
+	channel_put(channel, endpoint);
+	return ok;
+}
+
+void *channel_accept_grant(int handle, uint64_t *size)
+{
+	int endpoint;
+	channel_t *channel = channel_get(handle, &endpoint);
+	if(!channel)
+		return 0;
+
+	// Take the oldest grant
+	channel_grant_t *grant = 0;
+	spin_lock_plain(&channel->lock);
+	if(channel->grants[endpoint].head)
+	{
+		grant = container_of(channel->grants[endpoint].head, channel_grant_t, node);
+		list_remove(&channel->grants[endpoint], &grant->node);
+		__atomic_fetch_sub(&channel->grantCount[endpoint], 1, __ATOMIC_RELAXED);
+	}
+	spin_unlock_plain(&channel->lock);
+
+	void *addr = 0;
+	if(grant)
+	{
+		uint64_t grantSize = grant->frames->size;
+		addr = seg_attach(grant->frames);
+		if(addr)
+		{
+			*size = grantSize;
+			free(grant);
+		}
+		else
+		{
+			// Out of address space, put it back
+			spin_lock_plain(&channel->lock);
+			list_add_head(&channel->grants[endpoint], &grant->node);
+			__atomic_fetch_add(&channel->grantCount[endpoint], 1, __ATOMIC_RELEASE);
+			spin_unlock_plain(&channel->lock);
+		}
+	}
+
+	channel_put(channel, endpoint);
+	return addr;
+}
@@ -0,0 +1,117 @@
+
+#ifndef _PROC_CHANNEL_H
+#define _PROC_CHANNEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Named bidirectional channels between two processes.
+//
+// A channel has two byte rings, one per direction, which are mapped read-write into both processes. Data is exchanged
+// in user space without system calls: The sender copies data into its send ring and advances the head, the receiver
+// copies it out and advances the tail. Each ring thus has exactly one writer per position, so a channel endpoint must
+// only be used by one sending and one receiving thread at a time.
+// The kernel is only involved for blocking: A side which waits in sys_channel_wait() sets its waiting flag in the ring
+// first, and the other side calls sys_channel_notify() after changing the ring if it sees the flag set.
+//
+// Large payloads are passed by granting memory: A segment allocated with sys_heap_alloc() is removed from the sender
+// and mapped into the receiver, without copying.
+
+// Maximum channel name length, including terminating 0.
+#define CHANNEL_NAME_LENGTH 32
+
+// Size of the data area of a ring.
+#define CHANNEL_RING_DATA_SIZE (64 * 1024)
+
+// Number of channel handles per process.
+#define CHANNEL_MAX_HANDLES 16
+
+// Events reported by channel_wait().
+#define CHANNEL_EVENT_READABLE 0x1 /* the receive ring is not empty */
+#define CHANNEL_EVENT_WRITABLE 0x2 /* the send ring is not full */
+#define CHANNEL_EVENT_GRANT    0x4 /* a memory grant is pending */
+#define CHANNEL_EVENT_CLOSED   0x8 /* the other side has closed the channel */
+
+// A ring, as seen by both processes.
+typedef struct
+{
+	// Number of bytes written so far. Only written by the sending side.
+	uint64_t head __attribute__((aligned(64)));
+
+	// Number of bytes read so far. Only written by the receiving side.
+	uint64_t tail __attribute__((aligned(64)));
+
+	// Set by the respective side before waiting for new data or free space.
+	uint32_t receiverWaiting __attribute__((aligned(64)));
+	uint32_t senderWaiting;
+
+	// Data, indexed by the positions modulo CHANNEL_RING_DATA_SIZE.
+	uint8_t data[CHANNEL_RING_DATA_SIZE] __attribute__((aligned(4096)));
+} channel_ring_t;
+
+// User space addresses of the rings of a channel endpoint.
+typedef struct
+{
+	channel_ring_t *sendRing;
+	channel_ring_t *receiveRing;
+} channel_info_t;
+
+struct channel;
+struct proc;
+
+// Entry of a process' channel handle table.
+typedef struct
+{
+	// Channel, or 0 if the handle is unused.
+	struct channel *channel;
+
+	// Endpoint of the process (0: creator, 1: connector).
+	int endpoint;
+
+	// User space mapping of the rings.
+	channel_ring_t *userRings;
+} channel_handle_t;
+
+// Creates a new channel with the given name and maps its rings into the current process. Returns the handle, or -1 if
+// the name is in use or no handle is free.
+int channel_create(const char *name, channel_info_t *info);
+
+// Connects to the channel with the given name and maps its rings into the current process. Returns the handle, or -1
+// if there is no such channel or it is already connected.
+int channel_connect(const char *name, channel_info_t *info);
+
+// Closes the given handle of the current process and unmaps the rings.
+void channel_close(int handle);
+
+// Waits up to the given amount of milliseconds (negative: forever) for one of the given events. Returns the events
+// which occurred, or 0 on timeout or invalid handle.
+int channel_wait(int handle, int events, int64_t timeoutMs);
+
+// Wakes up the threads waiting for the given channel.
+void channel_notify(int handle);
+
+// Moves the memory segment starting at the given address to the other side of the channel. Returns false if there is
+// no such segment or the other side is not connected.
+bool channel_grant(int handle, void *addr);
+
+// Maps the oldest memory grant sent to the current process into its address space. Returns the address and stores
+// the size, or returns 0 if there is no grant.
+void *channel_accept_grant(int handle, uint64_t *size);
+
+// Registers a thread of the given process which waits for all its channels in sys_wait_events(). Must be followed by
+// channel_wait_all_end().
+void channel_wait_all_begin(struct proc *proc);
+
+// Determines whether any channel of the given process is readable, has a pending memory grant or was closed by the
+// other side. Sets the receiverWaiting flags of all receive rings before, so the other sides call sys_channel_notify()
+// after sending while the process waits in sys_wait_events(). Does not block and may be used as a wait condition.
+bool channel_check_all(struct proc *proc);
+
+// Ends a wait started with channel_wait_all_begin(). Clears the receiverWaiting flags if no other thread of the
+// process is waiting anymore.
+void channel_wait_all_end(struct proc *proc);
+
+// Closes all handles of the given process, whose threads and address space must already be destroyed.
+void channel_close_all(struct proc *proc);
+
+#endif
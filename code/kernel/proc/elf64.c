@@ -1,6 +1,9 @@
 
 #include <proc/elf64.h>
+#include <cpu/cr.h>
+#include <lock/intr.h>
 #include <mm/align.h>
+#include <mm/common.h>
 #include <mm/seg.h>
 #include <stdlib/string.h>
 #include <trace/trace.h>
@@ -40,13 +43,54 @@ static bool elf64_ehdr_valid(elf64_ehdr_t *ehdr)
   return true;
 }
 
+/* checks the PT_TLS header, its image must be contained in a loaded segment */
+static bool elf64_tls_valid(elf64_phdr_t *phdrs, size_t phnum, elf64_phdr_t *tls)
+{
+  if (tls->p_filesz > tls->p_memsz)
+    return false;
+
+  /* the thread pointer is aligned by placing the block in a fresh page */
+  if (tls->p_align > FRAME_SIZE || (tls->p_align & (tls->p_align - 1)))
+    return false;
+
+  if (tls->p_filesz == 0)
+    return true;
+
+  for (size_t i = 0; i < phnum; i++)
+  {
+    elf64_phdr_t *phdr = &phdrs[i];
+    if (phdr->p_type == PT_LOAD && tls->p_vaddr >= phdr->p_vaddr && tls->p_vaddr + tls->p_filesz >= tls->p_vaddr
+        && tls->p_vaddr + tls->p_filesz <= phdr->p_vaddr + phdr->p_memsz)
+      return true;
+  }
+  return false;
+}
+
 #include <panic/panic.h>
-bool elf64_load(elf64_ehdr_t *elf, size_t size)
+bool elf64_load(elf64_ehdr_t *elf, size_t size, elf64_tls_t *tls)
 {
   if (!elf64_ehdr_valid(elf))
     return false;
 
   elf64_phdr_t *phdrs = (elf64_phdr_t *) ((uintptr_t) elf + elf->e_phoff);
+
+  /* find the TLS template first, so nothing needs to be rolled back if it is invalid */
+  memclr(tls, sizeof(*tls));
+  for (size_t j = 0; j < elf->e_phnum; j++)
+  {
+    elf64_phdr_t *phdr = &phdrs[j];
+    if (phdr->p_type != PT_TLS)
+      continue;
+
+    if (!elf64_tls_valid(phdrs, elf->e_phnum, phdr))
+      return false;
+
+    tls->image = phdr->p_vaddr;
+    tls->filesz = phdr->p_filesz;
+    tls->memsz = phdr->p_memsz;
+    tls->align = phdr->p_align ? phdr->p_align : 1;
+  }
+
   size_t i;
   for (i = 0; i < elf->e_phnum; i++)
   {
@@ -75,12 +119,28 @@ bool elf64_load(elf64_ehdr_t *elf, size_t size)
     if (!seg_alloc_at((void *) seg_addr, seg_len, flags))
       goto rollback;
 	
+    // Read-only segments are already mapped as such, so write protection is disabled while filling them. Interrupts
+    // are masked, so CR0 is restored before anything else runs on this core
+    uint64_t cr0 = 0;
+    if (!(flags & VM_W))
+    {
+      intr_lock();
+      cr0 = cr0_read();
+      cr0_write(cr0 & ~CR0_WP);
+    }
+
     // Copy sections from the ELF file into segment memory
     uintptr_t file_addr = (uintptr_t) elf + phdr->p_offset;
     memcpy((void *) phdr->p_vaddr, (void *) file_addr, phdr->p_filesz);
 
     /* reset any remaining memory in the section */
     memclr((void *) (phdr->p_vaddr + phdr->p_filesz), phdr->p_memsz - phdr->p_filesz);
+
+    if (!(flags & VM_W))
+    {
+      cr0_write(cr0);
+      intr_unlock();
+    }
   }
   
   return true;
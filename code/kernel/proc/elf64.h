@@ -55,6 +55,7 @@
 #define PT_NOTE    4
 #define PT_SHLIB   5
 #define PT_PHDR    6
+#define PT_TLS     7
 
 /* phdr flags */
 #define PF_X 0x1
@@ -149,6 +150,22 @@ typedef struct
   elf64_xword_t st_size;
 } __attribute__((__packed__)) elf64_sym_t;
 
-bool elf64_load(elf64_ehdr_t *elf, size_t size);
+/* thread-local storage template of a loaded executable */
+typedef struct
+{
+  /* address of the initialization image, and its size */
+  uintptr_t image;
+  size_t filesz;
+
+  /* size and alignment of a TLS block; memsz is 0 if there is no PT_TLS header */
+  size_t memsz;
+  size_t align;
+} elf64_tls_t;
+
+/*
+ * loads the given executable into the current address space, and stores its
+ * TLS template (see thread_create()) into the given structure
+ */
+bool elf64_load(elf64_ehdr_t *elf, size_t size, elf64_tls_t *tls);
 
 #endif
@@ -0,0 +1,54 @@
+
+#include <proc/events.h>
+#include <proc/channel.h>
+#include <proc/proc.h>
+#include <proc/wait.h>
+#include <net/net.h>
+
+// Threads waiting in events_wait().
+static wait_queue_t eventWaiters = WAIT_QUEUE_INIT;
+
+void events_notify(void)
+{
+	wait_wake_all(&eventWaiters);
+}
+
+// Arguments of the wait condition.
+typedef struct
+{
+	proc_t *proc;
+	uint32_t mask;
+	uint32_t ready;
+} events_wait_args_t;
+
+// Wait condition of events_wait(): Determines the ready sources.
+static bool events_check(void *arg)
+{
+	events_wait_args_t *args = (events_wait_args_t *)arg;
+	uint32_t ready = 0;
+	if((args->mask & EVENT_MESSAGE) && msg_ring_peek(args->proc->messageRing) != MSG_INVALID)
+		ready |= EVENT_MESSAGE;
+	if((args->mask & EVENT_NET_RECEIVE) && net_has_received_packet())
+		ready |= EVENT_NET_RECEIVE;
+	if((args->mask & EVENT_CHANNEL) && channel_check_all(args->proc))
+		ready |= EVENT_CHANNEL;
+
+	args->ready = ready;
+	return ready != 0;
+}
+
+uint32_t events_wait(uint32_t mask, int64_t timeoutMs)
+{
+	events_wait_args_t args = { .proc = proc_get(), .mask = mask, .ready = 0 };
+	if(mask & EVENT_CHANNEL)
+		channel_wait_all_begin(args.proc);
+	wait_event(&eventWaiters, &events_check, &args, timeoutMs);
+
+	// The other sides need not notify us anymore, unless another thread of the process still waits
+	if(mask & EVENT_CHANNEL)
+		channel_wait_all_end(args.proc);
+
+	if(args.ready == 0)
+		return mask & EVENT_TIMEOUT;
+	return args.ready;
+}
@@ -0,0 +1,27 @@
+
+#ifndef _PROC_EVENTS_H
+#define _PROC_EVENTS_H
+
+#include <stdint.h>
+
+// Waiting for several event sources at once.
+//
+// All threads blocking in events_wait() share one wait queue, which is woken up by every source whenever it becomes
+// ready; each thread then checks its own sources again. This keeps the sources independent of the waiters, at the
+// price of spurious wakeups when several processes wait at the same time.
+
+// Event sources for events_wait().
+#define EVENT_MESSAGE     0x1 /* the message ring of the process is not empty */
+#define EVENT_NET_RECEIVE 0x2 /* a received network packet is pending */
+#define EVENT_CHANNEL     0x4 /* a channel of the process is readable, has a pending grant or was closed */
+#define EVENT_TIMEOUT     0x8 /* the timeout has passed */
+
+// Wakes up the waiting threads after an event source became ready. May be called by interrupt handlers, but not with
+// a channel lock held.
+void events_notify(void);
+
+// Waits up to the given amount of milliseconds (negative: forever) until one of the given event sources of the current
+// process is ready. Returns the ready sources; if none is ready, returns EVENT_TIMEOUT if it was requested, else 0.
+uint32_t events_wait(uint32_t mask, int64_t timeoutMs);
+
+#endif
@@ -1,7 +1,10 @@
 
 #include <proc/idle.h>
 #include <proc/proc.h>
-#include <cpu/halt.h>
+#include <proc/sched.h>
+#include <cpu/mwait.h>
+#include <cpu/cpuid.h>
+#include <cpu/features.h>
 #include <smp/cpu.h>
 #include <cpu/gdt.h>
 #include <cpu/cr.h>
@@ -9,9 +12,54 @@
 #include <util/container.h>
 #include <panic/panic.h>
 #include <stdlib/string.h>
+#include <stdlib/stdnoreturn.h>
+#include <init/cmdline.h>
+#include <trace/trace.h>
 
 static proc_t *idle_proc;
 
+// MWAIT hint used by idle cores.
+static uint32_t idleMwaitHint = MWAIT_HINT_C1;
+
+// Returns the MWAIT hint for the deepest C-state enumerated by CPUID, or C1 if there is no enumeration.
+static uint32_t idle_deepest_mwait_hint(void)
+{
+	uint32_t ecx, edx, tmp;
+	cpu_id(CPUID_MWAIT, &tmp, &tmp, &ecx, &edx);
+	if(!(ecx & CPUID_MWAIT_ECX_EMX))
+		return MWAIT_HINT_C1;
+	
+	// EDX holds the number of sub-states of C0 to C7 in 4-bit fields; hint 0x00 corresponds to C1
+	for(int c = 7; c >= 1; --c)
+	{
+		uint32_t subStates = (edx >> (4 * c)) & 0xF;
+		if(subStates)
+			return ((c - 1) << 4) | (subStates - 1);
+	}
+	return MWAIT_HINT_C1;
+}
+
+// Main function of the idle threads.
+// Sleeps until the scheduler flags a newly runnable thread for this core, and then switches to it right away
+// instead of waiting for the next timer tick.
+static noreturn void idle_run(void)
+{
+	// Idle threads never migrate
+	cpu_t *cpu = cpu_get();
+	while(true)
+	{
+		if(cpu->needResched)
+			sched_yield();
+		else if(cpu->idleMwait)
+		{
+			// Isolated cores are used for measurements, so they favor wake-up latency over power savings
+			mwait_idle(&cpu->needResched, cpu->isolated ? MWAIT_HINT_C1 : idleMwaitHint);
+		}
+		else
+			halt_idle(&cpu->needResched);
+	}
+}
+
 void idle_init(void)
 {
 	/*
@@ -29,6 +77,18 @@ void idle_init(void)
 		panic("couldn't create idle process");
 
 	proc_switch(idle_proc);
+	
+	// Select idle mechanism: "idle=halt" disables MWAIT, "idle=c1" restricts it to the shallowest C-state
+	const char *idleMode = cmdline_get("idle");
+	bool useMwait = cpu_feature_supported(FEATURE_MWAIT) && !(idleMode && strcmp(idleMode, "halt") == 0);
+	if(useMwait)
+	{
+		if(!(idleMode && strcmp(idleMode, "c1") == 0))
+			idleMwaitHint = idle_deepest_mwait_hint();
+		trace_printf("Idle cores use MWAIT with hint %0#4x\n", idleMwaitHint);
+	}
+	else
+		trace_puts("Idle cores use HLT\n");
 
 	list_for_each(&cpu_list, node)
 	{
@@ -41,11 +101,17 @@ void idle_init(void)
 		if (!thread)
 			panic("couldn't create idle thread");
 
-		thread->rip = (uint64_t) &halt_forever;
-		proc_thread_add(idle_proc, thread);
+		thread->rip = (uint64_t) &idle_run;
 
 		cpu->idle_thread = thread;
+		cpu->needResched = false;
+		cpu->idleMwait = useMwait;
 	}
 
 	cr3_write(old_pml4_table);
 }
+
+proc_t *idle_get_proc(void)
+{
+	return idle_proc;
+}
@@ -2,6 +2,11 @@
 #ifndef _PROC_IDLE_H
 #define _PROC_IDLE_H
 
+#include <proc/proc.h>
+
 void idle_init(void);
 
+// Returns the idle process, which also hosts kernel threads.
+proc_t *idle_get_proc(void);
+
 #endif
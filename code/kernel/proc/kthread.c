@@ -0,0 +1,35 @@
+#include <proc/kthread.h>
+#include <proc/idle.h>
+#include <proc/sched.h>
+#include <cpu/state.h>
+#include <stdbool.h>
+
+// Entry point of all kernel threads, runs the thread function and terminates the thread afterwards.
+static noreturn void kthread_start(kthread_func_t func, void *arg)
+{
+	func(arg);
+	kthread_exit();
+}
+
+thread_t *kthread_create(const char *name, kthread_func_t func, void *arg, int coreId)
+{
+	thread_t *thread = thread_create(idle_get_proc(), THREAD_KERNEL, name);
+	if(!thread)
+		return 0;
+	
+	// Pass function and argument according to the calling convention
+	thread->rip = (uint64_t)&kthread_start;
+	thread->regs[RDI] = (uint64_t)func;
+	thread->regs[RSI] = (uint64_t)arg;
+	thread->coreId = coreId;
+	return thread;
+}
+
+noreturn void kthread_exit(void)
+{
+	thread_kill(thread_get());
+	
+	// The thread is not runnable anymore, so it never returns from here; the reaper frees it once it is switched out
+	while(true)
+		sched_yield();
+}
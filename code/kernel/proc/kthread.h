@@ -0,0 +1,18 @@
+#ifndef _PROC_KTHREAD_H
+#define _PROC_KTHREAD_H
+
+#include <proc/thread.h>
+#include <stdlib/stdnoreturn.h>
+
+// Main function of a kernel thread.
+typedef void (*kthread_func_t)(void *arg);
+
+// Creates a kernel thread which runs the given function with the given argument on the given core.
+// The thread belongs to the kernel (idle) process and is created suspended, use thread_resume() to start it.
+// When the function returns, the thread terminates. Returns 0 on failure.
+thread_t *kthread_create(const char *name, kthread_func_t func, void *arg, int coreId);
+
+// Terminates the current kernel thread.
+noreturn void kthread_exit(void);
+
+#endif
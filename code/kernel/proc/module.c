@@ -35,7 +35,7 @@ static void module_load(multiboot_tag_t *tag)
 		proc_switch(proc);
 
 		// Load the ELF file
-		if (!elf64_load(elf, size))
+		if (!elf64_load(elf, size, &proc->tls))
 			panic("Couldn't load UI elf64 file");
 
 		// Make a new thread
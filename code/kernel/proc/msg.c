@@ -4,26 +4,96 @@ Message passing functionality.
 
 #include <proc/msg.h>
 #include <proc/proc.h>
-#include <stdlib/stdlib.h>
+#include <stdlib/string.h>
 
-void msg_send(msg_dest_t dest, msg_header_t *msg)
+void msg_ring_init(msg_ring_t *ring)
 {
-	// Send message
-	proc_send_message(dest, msg);
+	ring->enqueuePos = 0;
+	ring->dequeuePos = 0;
+	ring->dropped = 0;
+	for(int i = 0; i < MSG_RING_SIZE; ++i)
+		ring->slots[i].sequence = i;
 }
 
-msg_header_t *msg_create_keypress(vkey_t keyCode, bool shiftModifier)
+bool msg_ring_enqueue(msg_ring_t *ring, msg_header_t *msg)
 {
-	// Allocate message memory
-	msg_key_press_t *msg = (msg_key_press_t *)malloc(sizeof(msg_key_press_t));
-	msg->header.type = MSG_KEY_PRESS;
-	msg->header.size = sizeof(msg_key_press_t);
-	msg->shiftModifier = shiftModifier;
-	msg->keyCode = keyCode;
-	return &msg->header;
+	if(msg->size > MSG_RING_MAX_MESSAGE_SIZE)
+		return false;
+	
+	// Claim a slot
+	msg_ring_slot_t *slot;
+	uint64_t pos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+	while(true)
+	{
+		slot = &ring->slots[pos % MSG_RING_SIZE];
+		int64_t diff = (int64_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - pos);
+		if(diff == 0)
+		{
+			// The slot is free, try to move the enqueue position (pos is reloaded on failure)
+			if(__atomic_compare_exchange_n(&ring->enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}
+		else if(diff < 0)
+		{
+			// The slot still holds the message from the previous round, so the ring is full
+			__atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+			return false;
+		}
+		else
+			pos = __atomic_load_n(&ring->enqueuePos, __ATOMIC_RELAXED);
+	}
+	
+	// Fill and publish the slot
+	memcpy(slot->data, msg, msg->size);
+	__atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+	return true;
 }
 
-void msg_free(msg_header_t *msg)
+bool msg_ring_dequeue(msg_ring_t *ring, msg_header_t *buffer)
 {
-	free(msg);
-}
\ No newline at end of file
+	// Claim a slot
+	msg_ring_slot_t *slot;
+	uint64_t pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+	while(true)
+	{
+		slot = &ring->slots[pos % MSG_RING_SIZE];
+		int64_t diff = (int64_t)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - (pos + 1));
+		if(diff == 0)
+		{
+			// The slot holds a message, try to move the dequeue position (pos is reloaded on failure)
+			if(__atomic_compare_exchange_n(&ring->dequeuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}
+		else if(diff < 0)
+		{
+			// The slot was not filled yet, so the ring is empty
+			return false;
+		}
+		else
+			pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+	}
+	
+	// Copy the message and release the slot for the next round
+	// The ring is mapped into user space, so the stored size is not trusted: The whole slot is copied, and the size is
+	// clamped in the copy
+	memcpy(buffer, slot->data, MSG_RING_MAX_MESSAGE_SIZE);
+	__atomic_store_n(&slot->sequence, pos + MSG_RING_SIZE, __ATOMIC_RELEASE);
+	if(buffer->size > MSG_RING_MAX_MESSAGE_SIZE)
+		buffer->size = MSG_RING_MAX_MESSAGE_SIZE;
+	return true;
+}
+
+msg_type_t msg_ring_peek(msg_ring_t *ring)
+{
+	uint64_t pos = __atomic_load_n(&ring->dequeuePos, __ATOMIC_RELAXED);
+	msg_ring_slot_t *slot = &ring->slots[pos % MSG_RING_SIZE];
+	if(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != pos + 1)
+		return MSG_INVALID;
+	return ((msg_header_t *)slot->data)->type;
+}
+
+void msg_send(msg_dest_t dest, msg_header_t *msg)
+{
+	// Send message
+	proc_send_message(dest, msg);
+}
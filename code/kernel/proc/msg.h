@@ -46,11 +46,53 @@ typedef struct
 	vkey_t keyCode;
 } msg_key_press_t;
 
-// Sends a message to the given process.
-void msg_send(msg_dest_t dest, msg_header_t *msg);
+// Number of slots of a message ring (must be a power of two), and the maximum size of a message stored in a slot.
+#define MSG_RING_SIZE 64
+#define MSG_RING_MAX_MESSAGE_SIZE 24
 
-// Creates a new key press message.
-msg_header_t *msg_create_keypress(vkey_t keyCode, bool shiftModifier);
+// A slot of the message ring.
+typedef struct
+{
+	// Sequence number: Equals the enqueue position when the slot is free, and the enqueue position + 1 when it holds the
+	// message enqueued at that position.
+	uint64_t sequence;
+	
+	// Message data (starts with msg_header_t).
+	uint8_t data[MSG_RING_MAX_MESSAGE_SIZE];
+} msg_ring_slot_t;
+
+// Fixed-size message queue of a process, filled by any core (e.g. by interrupt handlers) and emptied by the process'
+// threads without locking (bounded MPMC queue after D. Vyukov). The ring is mapped read-only into the receiving
+// process, so it can check for pending messages without a system call; messages are dequeued by sys_wait_message().
+// The positions increase monotonically and are taken modulo MSG_RING_SIZE.
+typedef struct
+{
+	// Position of the next message to be enqueued.
+	uint64_t enqueuePos __attribute__((aligned(64)));
+	
+	// Position of the next message to be dequeued.
+	uint64_t dequeuePos __attribute__((aligned(64)));
+	
+	// Number of messages dropped because the ring was full.
+	uint64_t dropped __attribute__((aligned(64)));
+	
+	// Message slots.
+	msg_ring_slot_t slots[MSG_RING_SIZE] __attribute__((aligned(64)));
+} msg_ring_t;
+
+// Initializes an empty message ring.
+void msg_ring_init(msg_ring_t *ring);
+
+// Copies the given message into the ring. Returns false if the message is too large or the ring is full.
+bool msg_ring_enqueue(msg_ring_t *ring, msg_header_t *msg);
+
+// Removes the oldest message from the ring and copies it into the given buffer, which must provide
+// MSG_RING_MAX_MESSAGE_SIZE bytes. The size stored in the buffer does not exceed this. Returns false if the ring is
+// empty.
+bool msg_ring_dequeue(msg_ring_t *ring, msg_header_t *buffer);
+
+// Returns the type of the oldest message in the ring without removing it, or MSG_INVALID if there is none.
+msg_type_t msg_ring_peek(msg_ring_t *ring);
 
-// Frees the memory of the given message.
-void msg_free(msg_header_t *msg);
\ No newline at end of file
+// Sends a message to the given process. The message is copied, so it may reside on the stack.
+void msg_send(msg_dest_t dest, msg_header_t *msg);
\ No newline at end of file
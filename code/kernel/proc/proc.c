@@ -4,15 +4,19 @@
 #include <smp/cpu.h>
 #include <mm/pmm.h>
 #include <mm/vmm.h>
+#include <mm/heap.h>
 #include <lock/intr.h>
 #include <stdlib/stdlib.h>
 #include <vbe/vbe.h>
 #include <util/list.h>
 #include <util/container.h>
 #include <lock/spinlock.h>
+#include <lock/rwlock.h>
 #include <panic/panic.h>
 #include <trace/trace.h>
 #include <stdlib/string.h>
+#include <proc/sched.h>
+#include <proc/events.h>
 
 // The currently displayed process.
 proc_t *processDisplayed = 0;
@@ -24,7 +28,8 @@ proc_t *uiProcess = 0;
 list_t processList = LIST_EMPTY;
 
 // Lock to ensure ordered access to the process list and the currently displayed process.
-static spinlock_t processListLock = SPIN_UNLOCKED;
+// Messages are sent far more often than processes are created or displayed, so readers get per-core counters.
+static rwlock_percpu_t processListLock = RWLOCK_PERCPU_UNLOCKED;
 
 proc_t *proc_create(const char *name)
 {
@@ -35,11 +40,22 @@ proc_t *proc_create(const char *name)
 	if(!proc || !procNode)
 		return 0;
 
+	// Allocate message ring; it gets its own page, so it can be mapped into user space
+	trace_printf("proc_create: message ring\n");
+	proc->messageRing = heap_alloc(sizeof(msg_ring_t), VM_R | VM_W);
+	if(!proc->messageRing)
+	{
+		free(proc);
+		free(procNode);
+		return 0;
+	}
+
 	// Allocate PML4 table for this process
 	trace_printf("proc_create: pmm_alloc\n");
 	proc->pml4_table = pmm_alloc();
 	if(!proc->pml4_table)
 	{
+		heap_free(proc->messageRing);
 		free(proc);
 		free(procNode);
 		return 0;
@@ -50,6 +66,7 @@ proc_t *proc_create(const char *name)
 	if(!vmm_init_pml4(proc->pml4_table))
 	{
 		pmm_free(proc->pml4_table);
+		heap_free(proc->messageRing);
 		free(proc);
 		free(procNode);
 		return 0;
@@ -61,6 +78,7 @@ proc_t *proc_create(const char *name)
 	if(!seg_init(&proc->segments))
 	{
 		pmm_free(proc->pml4_table);
+		heap_free(proc->messageRing);
 		free(proc);
 		free(procNode);
 		return 0;
@@ -70,20 +88,34 @@ proc_t *proc_create(const char *name)
 	trace_printf("proc_create: vbe_create_context\n");
 	proc->vbeContext = vbe_create_context();
 
-	// Initialize empty message queue
-	trace_printf("proc_create: lists\n");
-	list_init(&proc->messageQueue);
+	// Initialize empty message ring
+	msg_ring_init(proc->messageRing);
+	proc->messageRingUser = 0;
+	proc->messageRingLock = SPIN_UNLOCKED;
+	wait_queue_init(&proc->messageWaiters);
+
+	// No channels and syscall rings yet
+	memclr(proc->channels, sizeof(proc->channels));
+	proc->channelLock = SPIN_UNLOCKED;
+	proc->channelAllWaiters = 0;
+	memclr(proc->urings, sizeof(proc->urings));
+	proc->uringLock = SPIN_UNLOCKED;
+	proc->syscallStats = 0;
+	
+	// No thread-local storage until an executable is loaded
+	memclr(&proc->tls, sizeof(proc->tls));
 
 	// Initialize empty thread list
 	list_init(&proc->thread_list);
+	proc->thread_list_lock = SPIN_UNLOCKED;
 
 	// Store it in internal list for bookkeeping
 	procNode->proc = proc;
-	spin_lock(&processListLock);
+	rw_percpu_wlock(&processListLock);
 	{
 		list_add_tail(&processList, &procNode->node);
 	}
-	spin_unlock(&processListLock);
+	rw_percpu_wunlock(&processListLock);
 	proc->processListNode = procNode;
 	
 	// Copy name
@@ -107,14 +139,14 @@ void proc_set_ui_process(proc_t *uiProc)
 
 void proc_display(int contextId)
 {
-	spin_lock(&processListLock);
+	rw_percpu_wlock(&processListLock);
 	{	
 		// Context #0 is the kernel itself
 		// Show its context, but keep the processDisplayed variable as it is, to be able to route keyboard inputs
 		if(contextId == 0)
 		{
 			vbe_show_context(0);
-			spin_unlock(&processListLock);
+			rw_percpu_wunlock(&processListLock);
 			return;
 		}
 		
@@ -134,17 +166,15 @@ void proc_display(int contextId)
 			}
 		}
 	}
-	spin_unlock(&processListLock);
+	rw_percpu_wunlock(&processListLock);
 }
 
 void proc_send_message(msg_dest_t dest, msg_header_t *msg)
 {
-	// Allocate node for storing the message
-	msg_node_t *msgNode = (msg_node_t *)malloc(sizeof(msg_node_t));
-	msgNode->msg = msg;
-	
 	// Retrieve target process
+	// The process list read lock is held until the message is queued, so the process cannot be destroyed in between
 	proc_t *destProc;
+	rw_percpu_rlock(&processListLock);
 	switch(dest)
 	{
 		case MSG_DEST_UI_PROCESS:
@@ -155,78 +185,67 @@ void proc_send_message(msg_dest_t dest, msg_header_t *msg)
 		
 		case MSG_DEST_VISIBLE_PROCESS:
 		{
-			spin_lock(&processListLock);
-			{
-				destProc = processDisplayed;
-			}
-			spin_unlock(&processListLock);
+			destProc = processDisplayed;
 			break;
 		}
 		
 		default:
 			// ???
-			return;
+			destProc = 0;
+			break;
 	}
-	if(!destProc)
-		panic("Could not find any process to send the given message to!\n");
 	
-	// Add message to queue
-	// TODO use non-interrupt lock
-	intr_lock();
-	{
-		list_add_tail(&destProc->messageQueue, &msgNode->node);
-	}
-	intr_unlock();
+	// Add message to ring and wake up waiting threads; the message is dropped if the receiving process is gone or
+	// does not keep up
+	bool enqueued = (destProc && msg_ring_enqueue(destProc->messageRing, msg));
+	if(enqueued)
+		wait_wake_all(&destProc->messageWaiters);
+	rw_percpu_runlock(&processListLock);
+	if(enqueued)
+		events_notify();
 }
 
 msg_type_t proc_peek_message(proc_t *proc)
 {
-	// Lock interrupts so we don't end up in a deadlock when e.g. a key is pressed and the handler tries to add a new message
-	msg_node_t *msgNode;
-	intr_lock();
-	{
-		msgNode = container_of(proc->messageQueue.head, msg_node_t, node);
-	}
-	intr_unlock();
-	
-	// Return message type
-	if(msgNode)
-		return msgNode->msg->type;
-	return MSG_INVALID;
+	return msg_ring_peek(proc->messageRing);
 }
 
-msg_header_t *proc_retrieve_message(proc_t *proc)
+// Wait condition of proc_wait_message(): Tries to dequeue a message.
+typedef struct
 {
-	// Lock interrupts so we don't end up in a deadlock when e.g. a key is pressed and the handler tries to add a new message
-	msg_node_t *msgNode;
-	intr_lock();
-	{
-		msgNode = container_of(proc->messageQueue.head, msg_node_t, node);
-		if(msgNode)
-			list_remove(&proc->messageQueue, &msgNode->node);
-	}
-	intr_unlock();
-	
-	// Message found?
-	if(msgNode)
-	{
-		// Retrieve message
-		msg_header_t *msg = msgNode->msg;
-		
-		// Free node memory
-		free(msgNode);
-		
-		// Done
-		return msg;
-	}
-	
-	// No message present
-	return 0;
+	msg_ring_t *ring;
+	msg_header_t *buffer;
+} proc_wait_message_args_t;
+static bool proc_try_dequeue_message(void *arg)
+{
+	proc_wait_message_args_t *args = (proc_wait_message_args_t *)arg;
+	return msg_ring_dequeue(args->ring, args->buffer);
+}
+
+msg_type_t proc_wait_message(proc_t *proc, msg_header_t *buffer, int64_t timeoutMs)
+{
+	// Dequeueing in the wait condition ensures that a message is not taken by another waiting thread in between
+	proc_wait_message_args_t args = { .ring = proc->messageRing, .buffer = buffer };
+	if(!wait_event(&proc->messageWaiters, &proc_try_dequeue_message, &args, timeoutMs))
+		return MSG_INVALID;
+	return buffer->type;
+}
+
+void *proc_map_message_ring(void)
+{
+	proc_t *proc = proc_get();
+	spin_lock_plain(&proc->messageRingLock);
+	if(!proc->messageRingUser)
+		proc->messageRingUser = seg_map_shared(proc->messageRing, sizeof(msg_ring_t), VM_R);
+	void *ringUser = proc->messageRingUser;
+	spin_unlock_plain(&proc->messageRingLock);
+	return ringUser;
 }
 
 void proc_switch(proc_t *proc)
 {
-	// Set current process and load address space
+	// Set current process and load address space. The CR3 write is serializing, so the TLB shootdown sees the new
+	// process before any translation of it is cached (see tlb_transaction_queue_invlpg())
 	cpu_t *cpu = cpu_get();
 	cpu->proc = proc;
 	cr3_write(proc->pml4_table);
@@ -234,31 +253,120 @@ void proc_switch(proc_t *proc)
 
 void proc_thread_add(proc_t *proc, thread_t *thread)
 {
+	spin_lock(&proc->thread_list_lock);
 	list_add_tail(&proc->thread_list, &thread->proc_node);
+	spin_unlock(&proc->thread_list_lock);
 }
 
-void proc_thread_remove(proc_t *proc, thread_t *thread)
+bool proc_thread_remove(proc_t *proc, thread_t *thread)
 {
+	spin_lock(&proc->thread_list_lock);
 	list_remove(&proc->thread_list, &thread->proc_node);
+	bool empty = (proc->thread_list.size == 0);
+	spin_unlock(&proc->thread_list_lock);
+	return empty;
+}
+
+void proc_exit(proc_t *proc)
+{
+	// Kill all threads, the reaper destroys the process after the last one is gone
+	spin_lock(&proc->thread_list_lock);
+	proc->state = PROC_EXITING;
+	list_for_each(&proc->thread_list, node)
+		thread_kill(container_of(node, thread_t, proc_node));
+	spin_unlock(&proc->thread_list_lock);
+}
+
+thread_t *proc_thread_find(proc_t *proc, int threadId)
+{
+	thread_t *result = 0;
+	spin_lock(&proc->thread_list_lock);
+	list_for_each(&proc->thread_list, node)
+	{
+		thread_t *thread = container_of(node, thread_t, proc_node);
+		if(thread->id == threadId)
+		{
+			// Dead threads are handed to the reaper, which only frees them if nobody holds a reference. Checking the
+			// state under the thread's lock ensures that the reaper sees our reference, if the thread dies later on
+			spin_lock(&thread->lock);
+			if(thread->state != THREAD_ZOMBIE)
+			{
+				__atomic_add_fetch(&thread->refs, 1, __ATOMIC_RELAXED);
+				result = thread;
+			}
+			spin_unlock(&thread->lock);
+			break;
+		}
+	}
+	spin_unlock(&proc->thread_list_lock);
+	return result;
+}
+
+int proc_get_thread_stats(sched_thread_stats_t *buffer, int maxCount)
+{
+	int count = 0;
+	rw_percpu_rlock(&processListLock);
+	list_for_each(&processList, procNodeIt)
+	{
+		proc_t *proc = container_of(procNodeIt, struct proc_node_t, node)->proc;
+		spin_lock(&proc->thread_list_lock);
+		list_for_each(&proc->thread_list, node)
+		{
+			if(count == maxCount)
+				break;
+			sched_thread_get_stats(container_of(node, thread_t, proc_node), &buffer[count++]);
+		}
+		spin_unlock(&proc->thread_list_lock);
+	}
+	rw_percpu_runlock(&processListLock);
+	return count;
+}
+
+int proc_get_syscall_stats(syscallstat_info_t *buffer, int maxCount)
+{
+	int count = 0;
+	rw_percpu_rlock(&processListLock);
+	list_for_each(&processList, procNodeIt)
+	{
+		proc_t *proc = container_of(procNodeIt, struct proc_node_t, node)->proc;
+		count += syscallstat_collect(proc, &buffer[count], maxCount - count);
+	}
+	rw_percpu_runlock(&processListLock);
+	return count;
+}
+
+void proc_clear_syscall_stats(void)
+{
+	rw_percpu_rlock(&processListLock);
+	list_for_each(&processList, procNodeIt)
+		syscallstat_clear(container_of(procNodeIt, struct proc_node_t, node)->proc);
+	rw_percpu_runlock(&processListLock);
 }
 
 void proc_destroy(proc_t *proc)
 {
-	// TODO: destroy threads within the process and make sure they aren't queued
+	// All threads of the process must have been destroyed at this point (see reaper.c)
 
-	// Delete process node
-	spin_lock(&processListLock);
+	// Delete process node, and make sure the process is not displayed and does not receive messages anymore
+	rw_percpu_wlock(&processListLock);
 	{
 		list_remove(&processList, &proc->processListNode->node);
+		
+		if(uiProcess == proc)
+			uiProcess = 0;
+		if(processDisplayed == proc)
+		{
+			// Fall back to UI process
+			processDisplayed = uiProcess;
+			vbe_show_context(uiProcess ? uiProcess->vbeContext : VBE_KERNEL_CONTEXT);
+		}
 	}
-	spin_unlock(&processListLock);
+	rw_percpu_wunlock(&processListLock);
 	free(proc->processListNode);
 	
-	// Make sure process is not displayed anymore
-	if(processDisplayed == proc)
-		proc_display(0);
-	// TODO delete VBE context
-
+	// Release VBE context
+	vbe_destroy_context(proc->vbeContext);
+	
 	/* lock interrupts so we can temporarily switch address spaces */
 	intr_lock();
 
@@ -267,15 +375,20 @@ void proc_destroy(proc_t *proc)
 	cr3_write(proc->pml4_table);
 
 	/* destroy the user memory segments */
-	seg_destroy();
+	seg_destroy(&proc->segments);
 
 	/* switch back to the old address space and unlock interrupts */
+	// This also flushes all user-space TLB entries of the destroyed address space
 	cr3_write(old_pml4_table);
 	intr_unlock();
 
-	// TODO: if cpu->proc == proc, change it to 0?
+	// Close remaining channels and free syscall rings, after their mappings were removed
+	channel_close_all(proc);
+	uring_destroy_all(proc);
 
-	/* free the pml4 table and process struct */
+	/* free the pml4 table, message ring, statistics and process struct */
 	pmm_free(proc->pml4_table);
+	heap_free(proc->messageRing);
+	free(proc->syscallStats);
 	free(proc);
 }
@@ -4,10 +4,16 @@
 
 #include <mm/seg.h>
 #include <proc/thread.h>
+#include <proc/sched.h>
 #include <lock/spinlock.h>
 #include <util/list.h>
 #include <stdint.h>
 #include <proc/msg.h>
+#include <proc/wait.h>
+#include <proc/channel.h>
+#include <proc/uring.h>
+#include <trace/syscallstat.h>
+#include <proc/elf64.h>
 
 // Forward declarations
 struct proc_node_t;
@@ -15,7 +21,10 @@ struct proc_node_t;
 // Possible process states.
 typedef enum
 {
-  PROC_RUNNING
+  PROC_RUNNING,
+  
+  // All threads were killed, the process is destroyed once the last one is freed.
+  PROC_EXITING
 } proc_state_t;
 
 // Process information block.
@@ -33,14 +42,42 @@ typedef struct proc
   /* list of threads in this process */
   list_t thread_list;
 
+  // Lock protecting the thread list.
+  spinlock_t thread_list_lock;
+
   /* memory segments */
   seg_t segments;
   
   // VBE context identifier.
   int vbeContext;
   
-  // Message queue (FIFO, head is the oldest message).
-  list_t messageQueue;
+  // Message ring, which is filled without locking (see msg_ring_t).
+  msg_ring_t *messageRing;
+  
+  // Read-only mapping of the message ring in user space, 0 until the process requests it. Protected by messageRingLock.
+  void *messageRingUser;
+  spinlock_t messageRingLock;
+  
+  // Threads waiting for new messages.
+  wait_queue_t messageWaiters;
+  
+  // Open channel handles, protected by channelLock. The lock is interrupt-safe, as it is taken in the wait condition
+  // of events_wait(), whose wait queue is woken up by interrupt handlers.
+  channel_handle_t channels[CHANNEL_MAX_HANDLES];
+  spinlock_t channelLock;
+  
+  // Number of threads waiting for all channels in events_wait(), protected by channelLock.
+  int channelAllWaiters;
+  
+  // Batched system call rings (see uring.h). Slots are only filled under uringLock and freed with the process.
+  struct uring_instance *urings[URING_MAX_RINGS];
+  spinlock_t uringLock;
+  
+  // System call statistics, indexed by system call number; allocated by the first profiled call (see syscallstat.h).
+  syscallstat_entry_t *syscallStats;
+  
+  // Thread-local storage template of the executable; each user thread gets a copy (see thread_create()).
+  elf64_tls_t tls;
   
   // Name of this process.
   char name[32];
@@ -59,16 +96,6 @@ struct proc_node_t
 	proc_t *proc;
 };
 
-// Defines a message list node.
-typedef struct
-{
-	// Message list node information (used for bookkeeping in proc.c).
-	struct list_node node;
-	
-	// Associated message data.
-	msg_header_t *msg;
-} msg_node_t;
-
 // Maximum name length: 31 characters.
 proc_t *proc_create(const char *name);
 
@@ -83,11 +110,17 @@ void proc_set_ui_process(proc_t *uiProc);
 // Displays the process with the given VBE context ID.
 void proc_display(int contextId);
 
-// Returns the type of the newest message, or MSG_INVALID if there is none.
+// Returns the type of the oldest message, or MSG_INVALID if there is none.
 msg_type_t proc_peek_message(proc_t *proc);
 
-// Returns the newest message for the given process, and deletes it from the message queue.
-msg_header_t *proc_retrieve_message(proc_t *proc);
+// Removes the oldest message of the given process and copies it into the given buffer, which must provide
+// MSG_RING_MAX_MESSAGE_SIZE bytes. If there is no message, waits up to the given amount of milliseconds for one
+// (0: do not wait, negative: wait forever). Returns the message type, or MSG_INVALID if no message arrived in time.
+msg_type_t proc_wait_message(proc_t *proc, msg_header_t *buffer, int64_t timeoutMs);
+
+// Maps the message ring of the current process read-only into its address space, if this was not done yet.
+// Returns the user space address of the ring, or 0 on failure.
+void *proc_map_message_ring(void);
 
 // Sends a message to the given recipient.
 // Do not use this directly! Use msg_send() instead.
@@ -103,8 +136,25 @@ void proc_send_message(msg_dest_t dest, msg_header_t *msg);
  * automatically after it is dead.
  */
 void proc_thread_add(proc_t *proc, thread_t *thread);
-void proc_thread_remove(proc_t *proc, thread_t *thread);
+bool proc_thread_remove(proc_t *proc, thread_t *thread); /* returns true if the process has no threads left */
+
+// Returns the thread with the given ID, if it belongs to the given process and is still alive; else 0.
+// The returned thread is not freed until the caller drops its reference via thread_put().
+thread_t *proc_thread_find(proc_t *proc, int threadId);
+
+// Retrieves the accounting data of up to maxCount threads of all processes. Returns the number of entries written.
+int proc_get_thread_stats(sched_thread_stats_t *buffer, int maxCount);
+
+// Copies the system call statistics of all processes into the given buffer. Returns the number of entries written.
+int proc_get_syscall_stats(syscallstat_info_t *buffer, int maxCount);
+
+// Discards the system call statistics of all processes.
+void proc_clear_syscall_stats(void);
+
+// Terminates all threads of the given process. The process is destroyed once the last thread was freed.
+void proc_exit(proc_t *proc);
 
+// Frees the given process, which must not have any threads left. Should only be called by the reaper.
 void proc_destroy(proc_t *proc);
 
 #endif
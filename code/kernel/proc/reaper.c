@@ -0,0 +1,78 @@
+
+#include <proc/reaper.h>
+#include <proc/sched.h>
+#include <proc/kthread.h>
+#include <proc/proc.h>
+#include <util/container.h>
+#include <util/list.h>
+#include <lock/spinlock.h>
+#include <panic/panic.h>
+
+// Dead threads waiting to be freed.
+static list_t zombieList = LIST_EMPTY;
+static spinlock_t zombieListLock = SPIN_UNLOCKED;
+
+// The reaper thread.
+static thread_t *reaperThread = 0;
+
+// Main function of the reaper thread.
+// Dead threads are freed off the hot path; the kernel stack of a thread can only be released after the core which
+// switched it out has left it.
+static void reaper_run(void *arg)
+{
+	while(true)
+	{
+		// Collect threads which are not in use anymore
+		list_t reapList = LIST_EMPTY;
+		bool pending = false;
+		spin_lock(&zombieListLock);
+		{
+			list_for_each(&zombieList, node)
+			{
+				thread_t *thread = container_of(node, thread_t, reap_node);
+				if(sched_thread_reapable(thread))
+				{
+					list_remove(&zombieList, node);
+					list_add_tail(&reapList, node);
+				}
+				else
+					pending = true;
+			}
+			
+			// Sleep until the next thread dies; reaper_add() wakes us up again
+			if(!pending && reapList.size == 0)
+				thread_suspend(reaperThread);
+		}
+		spin_unlock(&zombieListLock);
+		
+		// Free threads, and their processes if they do not have any threads left
+		list_for_each(&reapList, node)
+		{
+			thread_t *thread = container_of(node, thread_t, reap_node);
+			proc_t *proc = thread->proc;
+			list_remove(&reapList, node);
+			if(thread_destroy(thread))
+				proc_destroy(proc);
+		}
+		
+		// Give other threads a chance to run (or wait for pending threads to be switched out)
+		sched_yield();
+	}
+}
+
+void reaper_init(void)
+{
+	reaperThread = kthread_create("reaper", &reaper_run, 0, 0);
+	if(!reaperThread)
+		panic("couldn't create reaper thread");
+	thread_resume(reaperThread);
+}
+
+void reaper_add(thread_t *thread)
+{
+	spin_lock(&zombieListLock);
+	list_add_tail(&zombieList, &thread->reap_node);
+	spin_unlock(&zombieListLock);
+	
+	thread_resume(reaperThread);
+}
@@ -0,0 +1,14 @@
+
+#ifndef _PROC_REAPER_H
+#define _PROC_REAPER_H
+
+#include <proc/thread.h>
+
+// Starts the reaper kernel thread.
+// The reaper frees dead threads, and processes which do not have any threads left.
+void reaper_init(void);
+
+// Passes the given dead thread to the reaper.
+void reaper_add(thread_t *thread);
+
+#endif
@@ -2,6 +2,7 @@
 #include <proc/sched.h>
 #include <cpu/halt.h>
 #include <proc/proc.h>
+#include <proc/wait.h>
 #include <smp/cpu.h>
 #include <smp/mode.h>
 #include <time/apic.h>
@@ -13,11 +14,28 @@
 #include <stdbool.h>
 #include <io/keyboard.h>
 #include <cpu/xsave.h>
+#include <cpu/gdt.h>
+#include <cpu/flags.h>
+#include <cpu/tsc.h>
+#include <cpu/msr.h>
+#include <lock/intr.h>
+#include <lock/rcu.h>
+#include <intr/apic.h>
+#include <intr/common.h>
+#include <intr/route.h>
+#include <init/cmdline.h>
+#include <trace/trace.h>
 
 #define SCHED_TIMESLICE 10 /* 10ms = 100Hz */
 
-/* a list of threads that are ready to run */
-static list_t thread_queue = LIST_EMPTY;
+// Time slice lengths of the scheduling classes, in timer ticks.
+// Real-time threads run until they yield, block or are preempted by a real-time thread with higher priority.
+// Normal threads get their weight (priority) as multiple of the base slice.
+#define SCHED_SLICE_NORMAL 1
+#define SCHED_SLICE_BATCH 10
+
+/* lists of threads that are ready to run, one per scheduling class */
+static list_t thread_queues[SCHED_CLASS_COUNT] = { LIST_EMPTY, LIST_EMPTY, LIST_EMPTY };
 static spinlock_t thread_queue_lock = SPIN_UNLOCKED;
 
 // Determines whether the scheduler interrupt handler has been installed yet.
@@ -28,6 +46,18 @@ static spinlock_t interruptInstalledLock = SPIN_UNLOCKED;
 static uint64_t lastKeyboardPoll = 0;
 #define SCHED_KEYBOARD_POLL_DELAY 80
 
+static bool sched_slice_expired(cpu_t *cpu);
+static void sched_start_tick(cpu_t *cpu);
+
+// Switches away from the interrupted thread. If it has disabled preemption, the switch is deferred to preempt_enable().
+static void sched_preempt(cpu_t *cpu, cpu_state_t *state)
+{
+	if(cpu->preempt_count != 0)
+		cpu->needResched = true;
+	else
+		sched_tick(state);
+}
+
 // Handles a timer interrupt.
 static void sched_handle_interrupt(cpu_state_t *state)
 {
@@ -44,10 +74,25 @@ static void sched_handle_interrupt(cpu_state_t *state)
 			lastKeyboardPoll = cpu->elapsedMsSinceStart;
 			keyboard_poll();
 		}
+		
+		// Wake up threads whose wait has timed out
+		wait_handle_timeouts(cpu->elapsedMsSinceStart);
 	}
 
-	// Process scheduler tick
-	sched_tick(state);
+	// Process scheduler tick, if the current thread has used up its time slice or is preempted
+	if(sched_slice_expired(cpu))
+		sched_preempt(cpu, state);
+}
+
+// Handles a reschedule IPI, which is sent to halted idle cores and cores with stopped timer when a thread becomes
+// runnable for them.
+static void sched_handle_resched_ipi(cpu_state_t *state)
+{
+	cpu_t *cpu = cpu_get();
+	sched_start_tick(cpu);
+	
+	if(sched_slice_expired(cpu))
+		sched_preempt(cpu, state);
 }
 
 void sched_init(bool bsp)
@@ -58,12 +103,26 @@ void sched_init(bool bsp)
 	{
 		// Install handler
 		if(smp_mode == MODE_SMP)
+		{
 			apic_timer_install_handler(sched_handle_interrupt);
+			if(!intr_route_intr(IPI_RESCHED, &sched_handle_resched_ipi))
+				panic("failed to route reschedule IPI");
+		}
 		else
 			pit_timer_install_handler(sched_handle_interrupt);
 		interruptInstalled = true;
 	}
 	spin_unlock(&interruptInstalledLock);
+	
+	// Isolate cores given on the command line (e.g. "isolcpus=2,4-7")
+	if(bsp)
+	{
+		uint64_t isolatedMask = cmdline_get_cpu_mask("isolcpus");
+		for(int c = 0; c < 64; ++c)
+			if(isolatedMask & (1ULL << c))
+				if(!sched_set_core_isolated(c, true))
+					trace_printf("Could not isolate core #%d\n", c);
+	}
 		
 	// Start scheduler timer for this CPU
 	if(smp_mode == MODE_SMP)
@@ -72,20 +131,557 @@ void sched_init(bool bsp)
 		pit_monotonic(SCHED_TIMESLICE);
 }
 
+// Restarts the scheduler timer of the given (current) core, if it was stopped.
+static void sched_start_tick(cpu_t *cpu)
+{
+	if(!cpu->tickStopped)
+		return;
+	
+	cpu->tickStopped = false;
+	apic_monotonic(SCHED_TIMESLICE);
+}
+
+// Determines whether the given runnable thread should preempt the given running thread, since it has a higher class or
+// (within the real-time class) a higher priority.
+static bool sched_thread_preempts(thread_t *thread, thread_t *currThread)
+{
+	if(thread->sched_class != currThread->sched_class)
+		return thread->sched_class < currThread->sched_class;
+	return thread->sched_class == SCHED_CLASS_RT && thread->sched_priority > currThread->sched_priority;
+}
+
+// Notifies the given core that it should reschedule: Wakes it up if it is idle, preempts the running thread if the given
+// newly runnable thread (optional) takes precedence, or sends a reschedule IPI if its scheduler timer is stopped.
+// The scheduler lock must be held.
+static void sched_kick_core(int coreId, thread_t *thread)
+{
+	cpu_t *cpu = cpu_get_by_id(coreId);
+	if(!cpu || !cpu->thread)
+		return;
+	
+	bool sendIpi;
+	if(cpu->thread == cpu->idle_thread)
+	{
+		// Cores waiting in MWAIT are woken by the write to the monitored flag, halted ones need an interrupt
+		cpu->needResched = true;
+		sendIpi = !cpu->idleMwait;
+	}
+	else if(thread && sched_thread_preempts(thread, cpu->thread))
+	{
+		cpu->needResched = true;
+		sendIpi = true;
+	}
+	else
+		sendIpi = cpu->tickStopped;
+	
+	// The current core handles the flag when returning from the interrupt (see sched_irq_exit()), or in the idle loop
+	if(sendIpi && cpu != cpu_get())
+		apic_ipi_fixed(cpu->lapic_id, IPI_RESCHED);
+}
+
+bool sched_set_core_isolated(int coreId, bool isolated)
+{
+	// The boot core runs system threads (keyboard, network) and keeps the system time, so it cannot be isolated
+	cpu_t *cpu = cpu_get_by_id(coreId);
+	if(!cpu || cpu->bsp || smp_mode != MODE_SMP)
+		return false;
+	
+	cpu->isolated = isolated;
+	
+	// Resume ticks on cores which are not isolated anymore
+	if(!isolated)
+		sched_kick_core(coreId, 0);
+	return true;
+}
+
+// Returns the time slice length of the given thread in timer ticks, or 0 if it is unlimited.
+static int sched_slice_length(thread_t *thread)
+{
+	switch(thread->sched_class)
+	{
+		case SCHED_CLASS_RT:
+			return 0;
+		case SCHED_CLASS_NORMAL:
+			return SCHED_SLICE_NORMAL * thread->sched_priority;
+		default:
+			return SCHED_SLICE_BATCH;
+	}
+}
+
+// Adds the given thread to the queue of its scheduling class. Real-time threads are sorted by descending priority,
+// threads with equal priority are run in FIFO order. A preempted real-time thread did not give up the core by itself,
+// so it is put in front of the threads with equal priority, to continue before them.
+// The scheduler lock must be held.
+static void sched_enqueue(thread_t *thread, bool preempted)
+{
+	if(thread->sched_queued)
+		return;
+	
+	list_t *queue = &thread_queues[thread->sched_class];
+	if(thread->sched_class == SCHED_CLASS_RT)
+	{
+		// Insert before the first thread with lower (or, if preempted, equal) priority
+		list_node_t *insertBefore = 0;
+		list_for_each(queue, node)
+		{
+			int priority = container_of(node, thread_t, sched_node)->sched_priority;
+			if(priority < thread->sched_priority || (preempted && priority == thread->sched_priority))
+			{
+				insertBefore = node;
+				break;
+			}
+		}
+		if(insertBefore)
+			list_insert_before(queue, insertBefore, &thread->sched_node);
+		else
+			list_add_tail(queue, &thread->sched_node);
+	}
+	else
+		list_add_tail(queue, &thread->sched_node);
+	thread->sched_queued = true;
+	thread->stat_enqueue_time = tsc_read();
+	
+	// Idle cores and isolated cores running a single thread have their timer disabled, so they need to be notified
+	sched_kick_core(thread->coreId, thread);
+}
+
+// Removes the given thread from its queue, if it is queued.
+// The scheduler lock must be held.
+static void sched_dequeue(thread_t *thread)
+{
+	if(!thread->sched_queued)
+		return;
+	
+	list_remove(&thread_queues[thread->sched_class], &thread->sched_node);
+	thread->sched_queued = false;
+	thread->stat_wait_cycles += tsc_read() - thread->stat_enqueue_time;
+}
+
+// Removes the given queued thread from its queue to run it on the given core, gives it a new time slice and records
+// its run-queue latency.
+// The scheduler lock must be held.
+static void sched_take(cpu_t *cpu, thread_t *thread)
+{
+	uint64_t latency = tsc_read() - thread->stat_enqueue_time;
+	int bucket = (latency == 0 ? 0 : 63 - __builtin_clzll(latency));
+	if(bucket >= SCHED_LATENCY_BUCKETS)
+		bucket = SCHED_LATENCY_BUCKETS - 1;
+	++cpu->schedLatencyHistogram[bucket];
+	
+	sched_dequeue(thread);
+	thread->sched_slice_remaining = sched_slice_length(thread);
+}
+
 void sched_thread_resume(thread_t *thread)
 {
 	spin_lock(&thread_queue_lock);
-	list_add_tail(&thread_queue, &thread->sched_node);
+	sched_enqueue(thread, false);
 	spin_unlock(&thread_queue_lock);
 }
 
 void sched_thread_suspend(thread_t *thread)
 {
 	spin_lock(&thread_queue_lock);
-	list_remove(&thread_queue, &thread->sched_node);
+	sched_dequeue(thread);
+	
+	// If the thread is running on a core with stopped timer, make sure it gets switched out
+	if(thread->sched_running)
+		sched_kick_core(thread->coreId, 0);
+	spin_unlock(&thread_queue_lock);
+}
+
+bool sched_thread_reapable(thread_t *thread)
+{
+	spin_lock(&thread_queue_lock);
+	bool reapable = !thread->sched_running && __atomic_load_n(&thread->refs, __ATOMIC_ACQUIRE) == 0;
+	if(reapable && thread->sched_last_core >= 0)
+	{
+		// The core that switched the thread out might still be on its kernel stack (interrupt frame or voluntary
+		// switch), until it enters the scheduler again
+		cpu_t *cpu = cpu_get_by_id(thread->sched_last_core);
+		reapable = (cpu->schedEpoch != thread->sched_last_epoch);
+	}
+	spin_unlock(&thread_queue_lock);
+	return reapable;
+}
+
+bool sched_thread_set_class(thread_t *thread, sched_class_t schedClass, int priority)
+{
+	// Check parameters
+	if(schedClass == SCHED_CLASS_RT && (priority < SCHED_PRIORITY_RT_MIN || priority > SCHED_PRIORITY_RT_MAX))
+		return false;
+	if(schedClass == SCHED_CLASS_NORMAL && (priority < SCHED_PRIORITY_NORMAL_MIN || priority > SCHED_PRIORITY_NORMAL_MAX))
+		return false;
+	if(schedClass == SCHED_CLASS_BATCH)
+		priority = 0;
+	else if(schedClass != SCHED_CLASS_RT && schedClass != SCHED_CLASS_NORMAL)
+		return false;
+	
+	// Move thread to its new queue
+	spin_lock(&thread_queue_lock);
+	bool queued = thread->sched_queued;
+	sched_dequeue(thread);
+	thread->sched_class = schedClass;
+	thread->sched_priority = priority;
+	thread->sched_slice_remaining = sched_slice_length(thread);
+	if(queued)
+		sched_enqueue(thread, false);
+	spin_unlock(&thread_queue_lock);
+	return true;
+}
+
+void sched_thread_get_stats(thread_t *thread, sched_thread_stats_t *stats)
+{
+	spin_lock(&thread_queue_lock);
+	uint64_t now = tsc_read();
+	
+	stats->threadId = thread->id;
+	stats->coreId = thread->coreId;
+	strncpy(stats->name, thread->name, sizeof(stats->name));
+	stats->state = thread->state;
+	stats->schedClass = thread->sched_class;
+	stats->schedPriority = thread->sched_priority;
+	stats->runCycles = thread->stat_run_cycles;
+	stats->waitCycles = thread->stat_wait_cycles;
+	stats->switchesVoluntary = thread->stat_switches_voluntary;
+	stats->switchesInvoluntary = thread->stat_switches_involuntary;
+	stats->migrations = thread->stat_migrations;
+	
+	// Include the current period
+	if(thread->sched_running)
+		stats->runCycles += now - thread->stat_run_start;
+	else if(thread->sched_queued)
+		stats->waitCycles += now - thread->stat_enqueue_time;
 	spin_unlock(&thread_queue_lock);
 }
 
+bool sched_cpu_get_stats(int coreId, sched_cpu_stats_t *stats)
+{
+	cpu_t *cpu = cpu_get_by_id(coreId);
+	if(!cpu || !cpu->idle_thread)
+		return false;
+	
+	spin_lock(&thread_queue_lock);
+	stats->coreId = cpu->coreId;
+	stats->isolated = cpu->isolated;
+	stats->tscTicksPerMs = cpu->tsc_ticks_per_ms;
+	stats->timestamp = tsc_read();
+	stats->switches = cpu->schedSwitches;
+	stats->idleCycles = cpu->idle_thread->stat_run_cycles;
+	if(cpu->idle_thread->sched_running)
+		stats->idleCycles += stats->timestamp - cpu->idle_thread->stat_run_start;
+	memcpy(stats->latencyHistogram, cpu->schedLatencyHistogram, sizeof(stats->latencyHistogram));
+	spin_unlock(&thread_queue_lock);
+	return true;
+}
+
+// Saves the vector registers of the given thread, which is being switched out.
+// The save is skipped entirely if the registers are in init state; otherwise XSAVEOPT/XSAVEC/XSAVES only write
+// components that are in use.
+static void sched_save_vector_state(thread_t *thread)
+{
+	// Vector registers are not used by the kernel, thus only user-space threads have any state
+	if(!thread->xsave_state)
+		return;
+	
+	if(xsave_in_use())
+	{
+		xsave(thread->xsave_state);
+		thread->xsave_init = false;
+	}
+	else
+		thread->xsave_init = true;
+}
+
+// Loads the vector registers of the given thread, which is being switched in.
+static void sched_restore_vector_state(cpu_t *cpu, thread_t *thread)
+{
+	// Kernel threads do not touch the vector registers, so these still contain the state of the last user thread
+	if(!thread->xsave_state)
+		return;
+	
+	// If this thread was the last one to load its state on this core, the registers are still valid
+	if(cpu->xsave_owner == thread && thread->xsave_core == cpu->coreId)
+		return;
+	
+	// Load thread state; threads that never touched vector state only need the init state
+	if(!thread->xsave_init)
+		xrstor(thread->xsave_state);
+	else if(xsave_in_use())
+		xrstor_init();
+	cpu->xsave_owner = thread;
+	thread->xsave_core = cpu->coreId;
+}
+
+// Returns the next thread which can be run by the given core, and removes it from the queue.
+// Queues are checked in class order. If there is no runnable thread, the idle thread is returned.
+// The scheduler lock must be held.
+static thread_t *sched_pick_next(cpu_t *cpu)
+{
+	for(int c = 0; c < SCHED_CLASS_COUNT; ++c)
+	{
+		list_for_each(&thread_queues[c], nextThreadNode)
+		{
+			// Thread runnable by current core?
+			thread_t *nextThread = container_of(nextThreadNode, thread_t, sched_node);
+			if(nextThread->coreId != cpu->coreId)
+				continue;
+			
+			// Thread can be run, remove it from the queue and give it a new time slice
+			sched_take(cpu, nextThread);
+			return nextThread;
+		}
+	}
+	
+	// There is no new thread, switch to the idle thread
+	return cpu->idle_thread;
+}
+
+// Determines whether a queued thread of the given core should preempt the given running thread, since it has
+// a higher class or (within the real-time class) a higher priority.
+// The scheduler lock must be held.
+static bool sched_preempt_pending(cpu_t *cpu, thread_t *currThread)
+{
+	int currClass = currThread->sched_class;
+	for(int c = 0; c <= currClass; ++c)
+	{
+		list_for_each(&thread_queues[c], node)
+		{
+			thread_t *thread = container_of(node, thread_t, sched_node);
+			if(thread->coreId != cpu->coreId)
+				continue;
+			if(c < currClass)
+				return true;
+			
+			// Same class: Only real-time threads preempt, and the queue is sorted by priority
+			if(c == SCHED_CLASS_RT && thread->sched_priority > currThread->sched_priority)
+				return true;
+			break;
+		}
+	}
+	return false;
+}
+
+// Determines whether there is a queued thread for the given core.
+// The scheduler lock must be held.
+static bool sched_core_has_queued(cpu_t *cpu)
+{
+	for(int c = 0; c < SCHED_CLASS_COUNT; ++c)
+		list_for_each(&thread_queues[c], node)
+			if(container_of(node, thread_t, sched_node)->coreId == cpu->coreId)
+				return true;
+	return false;
+}
+
+// Accounts a timer tick to the current thread, and determines whether it needs to be switched out.
+// Stops the timer of isolated cores which only have a single runnable thread.
+static bool sched_slice_expired(cpu_t *cpu)
+{
+	++cpu->schedEpoch;
+	
+	thread_t *currThread = cpu->thread;
+	if(!currThread || currThread == cpu->idle_thread || currThread->state != THREAD_RUNNING)
+		return true;
+	
+	spin_lock(&thread_queue_lock);
+	bool expired;
+	if(cpu->isolated && !sched_core_has_queued(cpu))
+	{
+		// The thread runs undisturbed until another thread becomes runnable on this core (see sched_kick_core())
+		apic_timer_stop();
+		cpu->tickStopped = true;
+		expired = false;
+	}
+	else if(currThread->sched_slice_remaining > 0 && --currThread->sched_slice_remaining == 0)
+		expired = true;
+	else
+		expired = sched_preempt_pending(cpu, currThread);
+	spin_unlock(&thread_queue_lock);
+	return expired;
+}
+
+// Adds the given switched out thread to its queue, if it is runnable. See sched_enqueue() for the meaning of preempted.
+// The scheduler lock must be held.
+static void sched_requeue(thread_t *thread, bool preempted)
+{
+	if(thread && thread->state == THREAD_RUNNING)
+		sched_enqueue(thread, preempted);
+}
+
+// Charges the run time of the current thread and counts the switch. A switch is voluntary if the thread blocked or
+// exited, and involuntary if it is still runnable (preemption, expired time slice, yield).
+static void sched_account_switch(cpu_t *cpu, thread_t *currThread, thread_t *nextThread)
+{
+	uint64_t now = tsc_read();
+	if(currThread)
+	{
+		currThread->stat_run_cycles += now - currThread->stat_run_start;
+		if(currThread->state == THREAD_RUNNING)
+			++currThread->stat_switches_involuntary;
+		else
+			++currThread->stat_switches_voluntary;
+	}
+	
+	nextThread->stat_run_start = now;
+	if(nextThread->sched_last_core >= 0 && nextThread->sched_last_core != cpu->coreId)
+		++nextThread->stat_migrations;
+	++cpu->schedSwitches;
+}
+
+// Updates the CPU state which does not depend on how the register file is switched.
+static void sched_switch_common(cpu_t *cpu, thread_t *currThread, thread_t *nextThread)
+{
+	sched_account_switch(cpu, currThread, nextThread);
+	
+	/* actually swap the pointers over */
+	cpu->thread = nextThread;
+	if(currThread)
+	{
+		currThread->sched_running = false;
+		currThread->sched_last_core = cpu->coreId;
+		currThread->sched_last_epoch = cpu->schedEpoch;
+	}
+	nextThread->sched_running = true;
+	
+	// The switch might end the exclusive run of a thread on an isolated core
+	sched_start_tick(cpu);
+	
+	// Swap vector registers
+	if(currThread)
+		sched_save_vector_state(currThread);
+	sched_restore_vector_state(cpu, nextThread);
+
+	/* if we're switcing between processes, we need to switch address spaces */
+	if(!currThread || currThread->proc != nextThread->proc)
+		proc_switch(nextThread->proc); /* (this also sets cpu->proc) */
+
+	// Load the thread pointer; kernel threads do not use FS and keep the current value
+	if(!(nextThread->flags & THREAD_KERNEL) && cpu->fsBase != nextThread->fs_base)
+	{
+		msr_write(MSR_FS_BASE, nextThread->fs_base);
+		cpu->fsBase = nextThread->fs_base;
+	}
+
+	/* write new kernel stack pointer into the TSS */
+	tss_set_rsp0(nextThread->kernel_rsp);
+}
+
+void sched_switch_finish(void)
+{
+	spin_unlock(&thread_queue_lock);
+}
+
+// Switches from the current thread to the given one, without going through an interrupt frame.
+// The current thread continues once it is picked again. The scheduler lock must be held; it is released
+// by whichever code path resumes this thread.
+static void sched_switch_voluntary(cpu_t *cpu, thread_t *currThread, thread_t *nextThread)
+{
+	// Remember interrupt mask count, this is a per-CPU value which may differ for the thread resuming us
+	currThread->switch_intr_mask_count = cpu->intr_mask_count;
+	
+	sched_switch_common(cpu, currThread, nextThread);
+	
+	if(nextThread->switch_rsp)
+	{
+		// The next thread suspended itself voluntarily as well, so only the callee-saved registers need to be swapped
+		uint64_t nextRsp = nextThread->switch_rsp;
+		nextThread->switch_rsp = 0;
+		sched_switch_stack(&currThread->switch_rsp, nextRsp);
+	}
+	else
+	{
+		// The next thread was interrupted, build an interrupt frame on its kernel stack and return through it.
+		// If the thread was interrupted in kernel mode, its stack is still in use, so put the frame below.
+		uint64_t stackTop = (nextThread->cs & RPL3) ? nextThread->kernel_rsp : nextThread->rsp;
+		cpu_state_t *frame = (cpu_state_t *)((stackTop - sizeof(cpu_state_t)) & ~0xFULL);
+		memcpy(frame->regs, nextThread->regs, sizeof(frame->regs));
+		frame->rip = nextThread->rip;
+		frame->rsp = nextThread->rsp;
+		frame->rflags = nextThread->rflags;
+		frame->cs = nextThread->cs;
+		frame->ss = nextThread->ss;
+		sched_switch_frame(&currThread->switch_rsp, frame);
+	}
+	
+	// We were picked again, possibly on a different core
+	cpu = cpu_get();
+	cpu->intr_mask_count = currThread->switch_intr_mask_count;
+	spin_unlock(&thread_queue_lock);
+}
+
+// Implements sched_yield_to(); if requested, the reference to the target is dropped while the scheduler lock is still
+// held, so the reaper cannot free the target before we are done with it.
+static void sched_yield_to_common(thread_t *target, bool putTarget)
+{
+	intr_lock();
+	cpu_t *cpu = cpu_get();
+	thread_t *currThread = cpu->thread;
+
+	// Voluntary switches only happen outside of RCU read-side sections
+	rcu_quiescent_state();
+	
+	// A pending reschedule request means that the switch was deferred from an interrupt (see sched_preempt())
+	spin_lock(&thread_queue_lock);
+	++cpu->schedEpoch;
+	bool preempted = cpu->needResched;
+	cpu->needResched = false;
+	
+	// Run the target directly if it is waiting for this core, else pick the next thread as usual
+	thread_t *nextThread;
+	if(target && target != currThread && target->sched_queued && target->coreId == cpu->coreId)
+	{
+		sched_take(cpu, target);
+		nextThread = target;
+		sched_requeue(currThread, preempted);
+	}
+	else
+	{
+		sched_requeue(currThread, preempted);
+		nextThread = sched_pick_next(cpu);
+	}
+	if(putTarget)
+		thread_put(target);
+	
+	// Switch threads, if there is another one
+	if(currThread == nextThread)
+		spin_unlock(&thread_queue_lock);
+	else
+		sched_switch_voluntary(cpu, currThread, nextThread);
+	
+	intr_unlock();
+}
+
+void sched_yield_to(thread_t *target)
+{
+	sched_yield_to_common(target, false);
+}
+
+void sched_yield_to_put(thread_t *target)
+{
+	sched_yield_to_common(target, true);
+}
+
+void sched_yield(void)
+{
+	sched_yield_to(0);
+}
+
+void sched_syscall_exit(void)
+{
+	// System calls run with interrupts enabled, so we can switch voluntarily
+	if(cpu_get()->needResched)
+		sched_yield();
+}
+
+void sched_irq_exit(cpu_state_t *state)
+{
+	// Only switch if the interrupted code can be preempted; with interrupts masked or preemption disabled it might hold
+	// a lock
+	cpu_t *cpu = cpu_get();
+	if(cpu->needResched && (state->rflags & FLAGS_IF) && cpu->preempt_count == 0)
+		sched_tick(state);
+}
+
 void sched_tick(cpu_state_t *state)
 {
 	cpu_t *cpu = cpu_get();
@@ -94,61 +690,46 @@ void sched_tick(cpu_state_t *state)
 	thread_t *currThread = cpu->thread;
 
 	spin_lock(&thread_queue_lock);
+	++cpu->schedEpoch;
+	cpu->needResched = false;
 
 	/* add the current thread to the queue if it is runnable */
-	if(currThread && currThread->state == THREAD_RUNNING)
-		list_add_tail(&thread_queue, &currThread->sched_node);
+	sched_requeue(currThread, true);
 	
 	/* pick the next thread to run */
-	list_node_t *nextThreadNode = thread_queue.head;
-	thread_t *nextThread = 0;
-	while(nextThreadNode)
-	{
-		// Get thread object
-		thread_t *nextThreadCandidate = container_of(nextThreadNode, thread_t, sched_node);
-		
-		// Thread runnable by current core?
-		if(nextThreadCandidate->coreId != cpu->coreId)
-		{
-			// Check next thread
-			nextThreadNode = nextThreadNode->next;
-			continue;
-		}
-		
-		// Thread can be run, remove it from the queue
-		nextThread = nextThreadCandidate;
-		list_remove(&thread_queue, nextThreadNode);
-		break;
-	}
+	thread_t *nextThread = sched_pick_next(cpu);
 	
 	// TODO the register file copy below causes a race condition, when another core picks up execution of currThread before the whole state was copied
 	//      Temporary fix: Lock the entire scheduler step
 	//spin_unlock(&thread_queue_lock);
 
-	/* if there is no new thread, switch to the idle thread */
-	if(!nextThreadNode)
-		nextThread = cpu->idle_thread;
-
 	/* check if we're actually switching threads */
 	if(currThread != nextThread)
 	{
-		/* actually swap the pointers over */
-		cpu->thread = nextThread;
-
 		/* save the register file for the current thread */
 		if(currThread)
 		{
-			// Standard registers
 			memcpy(currThread->regs, state->regs, sizeof(state->regs));
 			currThread->rip = state->rip;
 			currThread->rsp = state->rsp;
 			currThread->rflags = state->rflags;
 			currThread->cs = state->cs;
 			currThread->ss = state->ss;
-			
-			// Vector registers
-			// These are not used by the kernel, thus they only need to be saved/restored on user-space thread switches
-			xsave(currThread->xsave_state);
+		}
+		
+		sched_switch_common(cpu, currThread, nextThread);
+
+		if(nextThread->switch_rsp)
+		{
+			// The next thread suspended itself voluntarily: Return into sched_switch_voluntary() on its kernel stack.
+			// The scheduler lock stays acquired, it is released by the resumed thread.
+			state->rip = (uint64_t)&sched_switch_stack_resume;
+			state->rsp = nextThread->switch_rsp;
+			state->rflags = 0;
+			state->cs = SLTR_KERNEL_CODE | RPL0;
+			state->ss = SLTR_KERNEL_DATA | RPL0;
+			nextThread->switch_rsp = 0;
+			return;
 		}
 
 		// Restore standard registers
@@ -158,16 +739,6 @@ void sched_tick(cpu_state_t *state)
 		state->rflags = nextThread->rflags;
 		state->cs = nextThread->cs;
 		state->ss = nextThread->ss;
-		
-		// Restore vector registers
-		xrstor(nextThread->xsave_state);
-
-		/* if we're switcing between processes, we need to switch address spaces */
-		if(!currThread || currThread->proc != nextThread->proc)
-			proc_switch(nextThread->proc); /* (this also sets cpu->proc) */
-
-		/* write new kernel stack pointer into the TSS */
-		tss_set_rsp0(nextThread->kernel_rsp);
 	}
 
 	spin_unlock(&thread_queue_lock);
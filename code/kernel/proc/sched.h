@@ -5,6 +5,44 @@
 #include <cpu/state.h>
 #include <proc/thread.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+// Number of buckets of the per-CPU run-queue latency histogram (see cpu_t::schedLatencyHistogram).
+#define SCHED_LATENCY_BUCKETS 32
+
+// Accounting snapshot of a thread. Times are given in TSC ticks and include the currently running or waiting period.
+typedef struct
+{
+	int threadId;
+	int coreId;
+	char name[32];
+	int state;
+	int schedClass;
+	int schedPriority;
+	uint64_t runCycles;
+	uint64_t waitCycles;
+	uint64_t switchesVoluntary;
+	uint64_t switchesInvoluntary;
+	uint64_t migrations;
+} sched_thread_stats_t;
+
+// Maximum number of thread accounting snapshots returned by a single query.
+#define SCHED_THREAD_STATS_MAX_COUNT 1024
+
+// Accounting snapshot of a core. Times are given in TSC ticks of that core.
+typedef struct
+{
+	int coreId;
+	bool isolated;
+	uint64_t tscTicksPerMs;
+	
+	// TSC value at which the snapshot was taken.
+	uint64_t timestamp;
+	
+	uint64_t switches;
+	uint64_t idleCycles;
+	uint64_t latencyHistogram[SCHED_LATENCY_BUCKETS];
+} sched_cpu_stats_t;
 
 // Starts the scheduler for the given core.
 // The "bsp" flag should only be set for the initial boot core.
@@ -20,6 +58,52 @@ void sched_init(bool bsp);
 void sched_thread_resume(thread_t *thread);
 void sched_thread_suspend(thread_t *thread);
 
+// Determines whether the given dead thread is not in use by any core anymore and not referenced (see
+// proc_thread_find()), so it can be freed.
+bool sched_thread_reapable(thread_t *thread);
+
+// Marks the given core as isolated or not isolated. Returns false if the core does not exist or cannot be isolated.
+bool sched_set_core_isolated(int coreId, bool isolated);
+
+// Changes the scheduling class and priority of the given thread. Returns false if the parameters are invalid.
+// The priority is ignored for SCHED_CLASS_BATCH.
+bool sched_thread_set_class(thread_t *thread, sched_class_t schedClass, int priority);
+
+// Retrieves the accounting data of the given thread.
+void sched_thread_get_stats(thread_t *thread, sched_thread_stats_t *stats);
+
+// Retrieves the accounting data of the given core. Returns false if the core does not exist.
+bool sched_cpu_get_stats(int coreId, sched_cpu_stats_t *stats);
+
 void sched_tick(cpu_state_t *state);
 
+// Called when a direct system call returns. Switches to a thread woken up by the system call, if it takes precedence
+// over the current one.
+void sched_syscall_exit(void);
+
+// Called when an interrupt handler returns. Switches to a newly runnable thread that takes precedence over the
+// interrupted one (e.g. a worker thread processing deferred work of the handler).
+void sched_irq_exit(cpu_state_t *state);
+
+// Gives up the remaining time slice of the current thread and switches to the next runnable thread.
+// The current thread stays runnable and continues when it is picked again.
+void sched_yield(void);
+
+// Like sched_yield(), but switches to the given thread, if it is runnable on the current core.
+// Else the next thread is picked as usual.
+void sched_yield_to(thread_t *target);
+
+// Like sched_yield_to(), but drops the caller's reference to the target (see proc_thread_find()) as soon as the
+// scheduler is done with it. The reference must not be held across the switch, since the calling thread might be
+// killed before it runs again.
+void sched_yield_to_put(thread_t *target);
+
+// Called by the thread switch code after switching to a new stack, releases the scheduler lock.
+void sched_switch_finish(void);
+
+// Assembly thread switch helpers (see switch.s).
+void sched_switch_stack(uint64_t *prev_rsp, uint64_t next_rsp);
+void sched_switch_frame(uint64_t *prev_rsp, cpu_state_t *frame);
+void sched_switch_stack_resume(void);
+
 #endif
@@ -0,0 +1,92 @@
+[bits 64]
+
+[extern sched_switch_finish]
+
+; void sched_switch_stack(uint64_t *prev_rsp, uint64_t next_rsp)
+;   saves the callee-saved registers of the current thread on its stack, stores
+;   the resulting stack pointer in *prev_rsp and continues the thread which
+;   saved its stack pointer in next_rsp. Used for voluntary thread switches,
+;   where the caller already preserved everything else according to the ABI.
+[global sched_switch_stack]
+sched_switch_stack:
+  ; save callee-saved registers
+  push rbp
+  push rbx
+  push r12
+  push r13
+  push r14
+  push r15
+
+  ; swap stacks
+  mov [rdi], rsp
+  mov rsp, rsi
+
+; entry point used by sched_tick() to continue a voluntarily suspended thread
+; from an interrupt frame
+[global sched_switch_stack_resume]
+sched_switch_stack_resume:
+  ; restore callee-saved registers of the next thread
+  pop r15
+  pop r14
+  pop r13
+  pop r12
+  pop rbx
+  pop rbp
+  ret
+
+; void sched_switch_frame(uint64_t *prev_rsp, cpu_state_t *frame)
+;   like sched_switch_stack(), but continues a thread which was interrupted by
+;   the scheduler tick. The frame must be 16-byte aligned and contain the
+;   thread's register file, it is returned through like an interrupt.
+[global sched_switch_frame]
+sched_switch_frame:
+  ; save callee-saved registers
+  push rbp
+  push rbx
+  push r12
+  push r13
+  push r14
+  push r15
+
+  ; switch to the interrupt frame
+  mov [rdi], rsp
+  mov rsp, rsi
+
+  ; release the scheduler lock
+  cld
+  call sched_switch_finish
+
+  ; the interrupted thread ran with interrupts enabled, so no locks were held
+  mov qword [gs:8], 0
+
+  ; check if we are switching from supervisor to user mode
+  mov rax, [rsp + 144]
+  and rax, 0x3
+  jz .supervisor_exit
+
+  ; switch back to the user's GS base if we are going from supervisor to user mode
+  swapgs
+
+.supervisor_exit:
+  ; restore the register file
+  pop rax
+  pop rbx
+  pop rcx
+  pop rdx
+  pop rsi
+  pop rdi
+  pop rbp
+  pop r8
+  pop r9
+  pop r10
+  pop r11
+  pop r12
+  pop r13
+  pop r14
+  pop r15
+
+  ; skip the error code and interrupt id
+  add rsp, 16
+
+  ; return
+  iretq
@@ -1,5 +1,9 @@
 [extern syscall_table]
 [extern syscall_table_size]
+[extern sched_syscall_exit]
+[extern syscallstatEnabled]
+[extern syscallstat_record]
+[extern syscallstat_count]
 
 ; see syscall.c for explanation of this flag
 SYSCALL_FAST equ 0x8000000000000000
@@ -17,9 +21,9 @@ syscall_stub:
 
   ; it is safe for to re-enable interrupts now, for information about the
   ; race condition see syscall.c where the SYSCALL flags mask is set
-  ; TODO check if scheduler interrupts during syscalls can break things
-  ;      currently we just increase the intr_mask_count such that interrupts aren't accidentally re-enabled during syscall handling
-  ;sti
+  ; system calls may thus be preempted like any other code running with
+  ; interrupts enabled; the interrupt mask count stays at zero
+  sti
 
   ; preserve RCX and R11, these are used by SYSCALL/SYSRET
   push rcx
@@ -29,34 +33,37 @@ syscall_stub:
   ; TODO consider making user land preserve it?
   push rbp
 
-  ; check if the syscall number is out of range
+  ; check if the syscall number is out of range; the comparison is unsigned, so
+  ; negative numbers are rejected as well
   mov r11, qword syscall_table_size
   cmp rax, [r11]
-  jge .invalid_syscall
+  jae .invalid_syscall
 
-  ; find address of syscall function
+  ; find address of syscall function, keep the number for the statistics
+  mov r12, rax
   mov r11, qword syscall_table
-  shl rax, 3
-  add r11, rax
-  mov r11, [r11]
+  mov r11, [r11 + rax * 8]
 
   ; jump to the faux interrupt code if the SYSCALL is not marked as fast
-  mov rax, SYSCALL_FAST
-  test r11, rax
-  jz .faux_intr
-  
-  ; Decrease mask count such that interrupts aren't accidentally re-enabled
-  ; Faux interrupts increase the mask count themselves!
-  inc qword [gs:8]
+  bt r11, 63
+  jnc .faux_intr
 
   ; call the syscall function in the kernel directly
   mov rcx, r10 ; syscall ABI uses R10 instead of RCX, fix that for normal ABI
   mov rbp, 0   ; terminate stack traces here
+  mov rax, qword syscallstatEnabled
+  cmp byte [rax], 0
+  jne .direct_profiled
   call r11
-  
-  ; Restore mask count
-  ; Faux interrupts decrease the mask count themselves!
-  dec qword [gs:8]
+
+.direct_exit:
+  ; switch to a thread woken up by the system call, if it takes precedence;
+  ; cpu_t::needResched is checked here to avoid the call in the common case
+  cmp byte [gs:32], 0
+  je .post_syscall
+  push rax
+  call sched_syscall_exit
+  pop rax
 
 .invalid_syscall:
   ; TODO: we probably want some sort of error upon an invalid syscall
@@ -71,7 +78,7 @@ syscall_stub:
   pop rcx
 
   ; mask interrupts again, for the same race condition reasons
-  ;cli
+  cli
 
   ; switch back to the user stack
   mov r12, [gs:16]   ; find current thread_t
@@ -83,6 +90,27 @@ syscall_stub:
   ; return to user long mode
   o64 sysret
 
+; direct call with system call statistics enabled (see trace/syscallstat.h)
+.direct_profiled:
+  ; push the syscall number and the start time stamp, RDTSC overwrites RDX
+  ; which holds the third argument
+  push r12
+  mov r12, rdx
+  rdtsc
+  shl rdx, 32
+  or rax, rdx
+  mov rdx, r12
+  push rax
+  call r11
+
+  ; record the call, preserving the return value
+  pop rsi
+  pop rdi
+  push rax
+  call syscallstat_record
+  pop rax
+  jmp .direct_exit
+
 ; we 'fake' an interrupt for certain system calls
 ;
 ; this code is mostly identical to that in arc/intr/stub.s, with the following
@@ -108,8 +136,33 @@ syscall_stub:
 ;
 ;   - we call R11 (the function pointer to the syscall) instead of intr_dispatch
 .faux_intr:
+  ; count the call if system call statistics are enabled; these calls do not
+  ; necessarily return, so their duration is not measured
+  mov rax, qword syscallstatEnabled
+  cmp byte [rax], 0
+  je .faux_intr_start
+  push rdi
+  push rsi
+  push rdx
+  push rcx
+  push r8
+  push r9
+  push r10
+  push r11
+  mov rdi, r12
+  call syscallstat_count
+  pop r11
+  pop r10
+  pop r9
+  pop r8
+  pop rcx
+  pop rdx
+  pop rsi
+  pop rdi
+
+.faux_intr_start:
   ; mask interrupts
-  ;cli
+  cli
 
   ; push state the processor automatically pushes during an interrupt
   mov rax, rsp
@@ -157,8 +210,8 @@ syscall_stub:
   dec qword [gs:8]
 
   ; check if we are switching from supervisor to user mode
-  mov rax, [rsp + 152]
-  and rax, 0x3000      ; Ring 3 = 0x3***, Ring 0 = 0x0***
+  mov rax, [rsp + 144]
+  and rax, 0x3         ; RPL of the CS selector
   jz .supervisor_exit
 
   ; switch back to the user's GS base if we are going from supervisor to user mode
@@ -195,8 +248,7 @@ syscall_stub:
   iretq 
 
 .faux_intr_exit:
-  ; re-enable interrupts (the SYSCALL exit routine expects it), and then dive
-  ; back into the SYSCALL exit routine
-  ;sti
-  swapgs
+  ; the faux frame returns to supervisor mode, so the kernel's GS base is
+  ; still loaded; dive back into the SYSCALL exit routine, which masks
+  ; interrupts anyway
   jmp .post_syscall
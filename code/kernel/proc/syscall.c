@@ -5,6 +5,9 @@
 #include <cpu/efer.h>
 #include <cpu/msr.h>
 #include <cpu/gdt.h>
+#include <smp/cpu.h>
+#include <stdlib/assert.h>
+#include <stddef.h>
 
 /*
  * As the kernel is in the higher high we know that the MSB of function
@@ -12,10 +15,14 @@
  * which indicates if the syscall should be a direct method call (suitable for
  * anything which doesn't need to perform a context switch) or if it should
  * emulate an interrupt (allowing calls which may switch the context e.g.
- * yield() to be implemented).
+ * exit_thread() to be implemented). yield() switches through sched_yield()
+ * and thus does not need an interrupt frame.
  */
 #define SYSCALL_DIRECT 0x8000000000000000UL
 
+/* syscall_stub() checks the reschedule flag of the current CPU directly */
+static_assert(offsetof(cpu_t, needResched) == 32, "cpu_t::needResched must be the fifth group of 8 bytes");
+
 uintptr_t syscall_table[] =
 {
 	/*  0 */ (uintptr_t)&sys_trace,
@@ -61,6 +68,29 @@ uintptr_t syscall_table[] =
 	/* 40 */ (uintptr_t)&sys_fs_delete,
 	/* 41 */ (uintptr_t)&sys_hugepage_mode,
 	/* 42 */ (uintptr_t)&sys_page_flags,
+	/* 43 */ (uintptr_t)&sys_yield_to,
+	/* 44 */ (uintptr_t)&sys_get_thread_id,
+	/* 45 */ (uintptr_t)&sys_set_thread_scheduling,
+	/* 46 */ (uintptr_t)&sys_set_core_isolation,
+	/* 47 */ (uintptr_t)&sys_get_thread_stats,
+	/* 48 */ (uintptr_t)&sys_get_cpu_stats,
+	/* 49 */ (uintptr_t)&sys_lock_torture,
+	/* 50 */ (uintptr_t)&sys_get_message_ring,
+	/* 51 */ (uintptr_t)&sys_wait_message,
+	/* 52 */ (uintptr_t)&sys_channel_create,
+	/* 53 */ (uintptr_t)&sys_channel_connect,
+	/* 54 */ (uintptr_t)&sys_channel_close,
+	/* 55 */ (uintptr_t)&sys_channel_wait,
+	/* 56 */ (uintptr_t)&sys_channel_notify,
+	/* 57 */ (uintptr_t)&sys_channel_grant,
+	/* 58 */ (uintptr_t)&sys_channel_accept_grant,
+	/* 59 */ (uintptr_t)&sys_uring_setup,
+	/* 60 */ (uintptr_t)&sys_uring_enter,
+	/* 61 */ (uintptr_t)&sys_wait_events,
+	/* 62 */ (uintptr_t)&sys_syscall_stats_enable,
+	/* 63 */ (uintptr_t)&sys_get_syscall_stats,
+	/* 64 */ (uintptr_t)&sys_mem_bench,
+	/* 65 */ (uintptr_t)&sys_set_fs_base,
 };
 uint64_t syscall_table_size = sizeof(syscall_table) / sizeof(*syscall_table);
 
@@ -68,7 +98,6 @@ void syscall_init(void)
 {
   /* unset SYSCALL_DIRECT bit on syscalls which may perform a context switch */
   syscall_table[1] &= ~SYSCALL_DIRECT;
-  syscall_table[2] &= ~SYSCALL_DIRECT;
   syscall_table[18] &= ~SYSCALL_DIRECT;
 
   /* set the SYSCALL and SYSRET selectors */
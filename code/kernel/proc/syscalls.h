@@ -4,17 +4,30 @@
 
 #include <stdint.h>
 #include <cpu/state.h>
+#include <proc/sched.h>
+#include <lock/torture.h>
+#include <stdlib/membench.h>
 #include <proc/msg.h>
+#include <proc/channel.h>
+#include <proc/uring.h>
+#include <trace/syscallstat.h>
 #include <fs/ramfs.h>
 
 // Prints the given string to kernel console. TODO remove, this is only for debugging
 int64_t sys_trace(const char *message);
 
-// TODO this does not do anything yet
+// Terminates the current process.
 void sys_exit(cpu_state_t *state);
 
 // Switches to another thread, while the current one is e.g. waiting for messages (cooperative multitasking).
-void sys_yield(cpu_state_t *state);
+int sys_yield(void);
+
+// Switches directly to the given thread of the current process, e.g. when waiting for a result produced by it.
+// If the thread cannot be run on the current core, this behaves like sys_yield(). Returns -1 if the thread does not exist.
+int sys_yield_to(int threadId);
+
+// Returns the ID of the current thread.
+int sys_get_thread_id(void);
 
 // Returns the type of the oldest non-processed message of the current process, if it exists.
 msg_type_t sys_next_message_type();
@@ -23,6 +36,55 @@ msg_type_t sys_next_message_type();
 // The parameter messageBuffer must provide enough space to fit the given message, thus next_message_type() should be called first to determine the correct message size.
 void sys_next_message(msg_header_t *messageBuffer);
 
+// Waits up to the given amount of milliseconds (negative: forever) for a message, and copies it into the given buffer,
+// which must provide MSG_RING_MAX_MESSAGE_SIZE bytes. Returns the message type, or MSG_INVALID on timeout.
+msg_type_t sys_wait_message(msg_header_t *messageBuffer, int64_t timeoutMs);
+
+// Maps the message ring of the current process read-only into its address space and returns its address.
+void *sys_get_message_ring();
+
+// Creates a named channel and maps its rings into the current process. Returns the channel handle, or -1 on error.
+int sys_channel_create(const char *name, channel_info_t *info);
+
+// Connects to the channel with the given name and maps its rings into the current process. Returns the channel handle,
+// or -1 on error.
+int sys_channel_connect(const char *name, channel_info_t *info);
+
+// Closes the given channel handle.
+void sys_channel_close(int handle);
+
+// Waits up to the given amount of milliseconds (negative: forever) for one of the given CHANNEL_EVENT_* events. Returns
+// the events that occurred, or 0 on timeout.
+int sys_channel_wait(int handle, int events, int64_t timeoutMs);
+
+// Wakes up the threads waiting for the given channel.
+void sys_channel_notify(int handle);
+
+// Moves the memory segment starting at the given address (allocated with sys_heap_alloc()) to the other side.
+bool sys_channel_grant(int handle, void *addr);
+
+// Maps the oldest pending memory grant into the current process. Returns its address and size, or 0 if there is none.
+void *sys_channel_accept_grant(int handle, uint64_t *size);
+
+// Creates a batched system call ring and maps it into the current process. Returns the ring handle and stores its
+// address, or returns -1 on error.
+int sys_uring_setup(uring_t **userRing);
+
+// Executes up to toSubmit operations from the given ring and waits up to timeoutMs milliseconds (negative: forever)
+// until at least minComplete completions are pending. Returns the number of executed operations, or -1 on error.
+int sys_uring_enter(int handle, uint32_t toSubmit, uint32_t minComplete, int64_t timeoutMs);
+
+// Waits up to the given amount of milliseconds (negative: forever) until one of the given EVENT_* sources is ready.
+// Returns the ready sources, or EVENT_TIMEOUT (if requested) on timeout.
+uint32_t sys_wait_events(uint32_t mask, int64_t timeoutMs);
+
+// Switches the recording of system call statistics on or off, and optionally discards the statistics collected so far.
+void sys_syscall_stats_enable(bool enable, bool reset);
+
+// Retrieves the system call statistics of all processes, one entry per process and used system call. Returns the number
+// of entries written, or -1 on error.
+int sys_get_syscall_stats(syscallstat_info_t *buffer, int maxCount);
+
 // Changes the currently displayed process render context.
 void sys_set_displayed_process(int contextId);
 
@@ -62,8 +124,8 @@ void *sys_heap_alloc(int size);
 // Frees the given allocated memory.
 void sys_heap_free(void *addr);
 
-// Starts a new thread and sets the instruction pointer to the given address.
-void sys_run_thread(uint64_t rip, const char *name);
+// Starts a new thread and sets the instruction pointer to the given address. Returns the ID of the new thread, or -1 on error.
+int sys_run_thread(uint64_t rip, const char *name);
 
 // Exits the current thread.
 void sys_exit_thread(cpu_state_t *state);
@@ -84,6 +146,22 @@ int sys_receive_network_packet(uint8_t *packetBuffer);
 // Sends the given network packet.
 void sys_send_network_packet(uint8_t *packet, int packetLength);
 
+// Copies the accounting data (run/wait time, switches, migrations) of up to maxCount threads of all processes into the
+// given buffer. Returns the number of entries, or -1 on error.
+int sys_get_thread_stats(sched_thread_stats_t *buffer, int maxCount);
+
+// Copies the accounting data (switches, idle time, run-queue latency histogram) of up to maxCount cores into the given
+// buffer. Returns the number of entries.
+int sys_get_cpu_stats(sched_cpu_stats_t *buffer, int maxCount);
+
+// Runs the lock torture test with the given number of iterations per core and copies up to maxCount results (one per
+// lock type) into the given buffer. Returns the number of results, or 0 if a test is already running.
+int sys_lock_torture(int iterations, lock_torture_result_t *results, int maxCount);
+
+// Runs the kernel memory routine benchmark with the given number of repetitions per size and copies up to maxCount
+// results into the given buffer. Returns the number of results, or -1 on error.
+int sys_mem_bench(int iterations, mem_bench_result_t *results, int maxCount);
+
 // Copies system information into the given buffer.
 void sys_info(int infoId, uint8_t *buffer);
 
@@ -93,6 +171,18 @@ void sys_dump(int infoId, const char *filePath);
 // Sets the core the current thread shall be run on.
 void sys_set_affinity(int coreId);
 
+// Sets scheduling class (see sched_class_t) and priority of the given thread of the current process.
+// A negative ID denotes the current thread. Returns -1 on invalid parameters.
+int sys_set_thread_scheduling(int threadId, int schedClass, int priority);
+
+// Isolates the given core for undisturbed measurements, or releases it again (see cpu_t::isolated).
+// Threads have to be moved to an isolated core explicitly using sys_set_affinity(). The boot core cannot be isolated.
+bool sys_set_core_isolation(int coreId, bool isolated);
+
+// Sets the FS base (thread pointer) of the current thread, e.g. for a custom TLS block. Returns false if the address
+// is not in user space.
+bool sys_set_fs_base(uint64_t base);
+
 // Resolves the underlying physical address of the given virtual address.
 uint64_t sys_virt_to_phy(uint64_t addr);
 
@@ -0,0 +1,62 @@
+
+#include <proc/syscalls.h>
+#include <proc/channel.h>
+#include <mm/uaccess.h>
+
+// Returns the handle created by the given channel function for the given user space name, and passes the ring
+// addresses to user space. Returns -1 on error.
+static int sys_channel_open(int (*open)(const char *, channel_info_t *), const char *name, channel_info_t *info)
+{
+	char kernelName[CHANNEL_NAME_LENGTH];
+	if(strncpy_from_user(kernelName, name, sizeof(kernelName)) < 0)
+		return -1;
+
+	channel_info_t kernelInfo;
+	int handle = open(kernelName, &kernelInfo);
+	if(handle >= 0 && !copy_to_user(info, &kernelInfo, sizeof(kernelInfo)))
+	{
+		channel_close(handle);
+		return -1;
+	}
+	return handle;
+}
+
+int sys_channel_create(const char *name, channel_info_t *info)
+{
+	return sys_channel_open(&channel_create, name, info);
+}
+
+int sys_channel_connect(const char *name, channel_info_t *info)
+{
+	return sys_channel_open(&channel_connect, name, info);
+}
+
+void sys_channel_close(int handle)
+{
+	channel_close(handle);
+}
+
+int sys_channel_wait(int handle, int events, int64_t timeoutMs)
+{
+	return channel_wait(handle, events, timeoutMs);
+}
+
+void sys_channel_notify(int handle)
+{
+	channel_notify(handle);
+}
+
+bool sys_channel_grant(int handle, void *addr)
+{
+	return channel_grant(handle, addr);
+}
+
+void *sys_channel_accept_grant(int handle, uint64_t *size)
+{
+	// The segment stays mapped if the size cannot be stored, the process is broken anyway
+	uint64_t kernelSize = 0;
+	void *addr = channel_accept_grant(handle, &kernelSize);
+	if(!copy_to_user(size, &kernelSize, sizeof(kernelSize)))
+		return 0;
+	return addr;
+}
\ No newline at end of file
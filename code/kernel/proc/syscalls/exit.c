@@ -1,6 +1,6 @@
-
 #include <proc/syscalls.h>
 #include <proc/sched.h>
+#include <proc/proc.h>
 #include <proc/thread.h>
 
 void sys_exit(cpu_state_t *state)
@@ -8,9 +8,7 @@ void sys_exit(cpu_state_t *state)
   // TODO use status code:
   // int status = state->regs[RDI];
 
-  // TODO real impl which actually kills the whole proc
-
-  thread_t *thread = thread_get();
-  thread_kill(thread);
+  /* kill all threads of the process, the reaper frees everything afterwards */
+  proc_exit(proc_get());
   sched_tick(state);
 }
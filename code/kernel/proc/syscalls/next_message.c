@@ -2,19 +2,18 @@
 #include <proc/syscalls.h>
 #include <proc/msg.h>
 #include <proc/proc.h>
-#include <stdlib/string.h>
+#include <mm/uaccess.h>
 
 void sys_next_message(msg_header_t *messageBuffer)
 {
 	// Get current process
 	proc_t *proc = proc_get();
 	
-	// Retrieve message
-	msg_header_t *msg = proc_retrieve_message(proc);
+	// Retrieve message, if there is one
+	uint8_t msg[MSG_RING_MAX_MESSAGE_SIZE] __attribute__((aligned(8)));
+	if(proc_wait_message(proc, (msg_header_t *)msg, 0) == MSG_INVALID)
+		return;
 	
-	// Copy message into user space buffer
-	memcpy(messageBuffer, msg, msg->size);
-	
-	// Free memory of retrieved message (handling is done by the user now)
-	msg_free(msg);
+	// Copy message into user space buffer; if it is invalid, the message is dropped
+	copy_to_user(messageBuffer, msg, ((msg_header_t *)msg)->size);
 }
\ No newline at end of file
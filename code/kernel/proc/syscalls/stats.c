@@ -4,6 +4,16 @@
 #include <smp/topology.h>
 #include <mm/pmm.h>
 #include <cpu/cpuid.h>
+#include <proc/proc.h>
+#include <proc/sched.h>
+#include <lock/torture.h>
+#include <stdlib/membench.h>
+#include <lock/lockstat.h>
+#include <trace/kstat.h>
+#include <trace/syscallstat.h>
+#include <mm/uaccess.h>
+#include <stdlib/stdlib.h>
+#include <stdlib/string.h>
 
 uint64_t sys_get_elapsed_milliseconds()
 {
@@ -12,8 +22,115 @@ uint64_t sys_get_elapsed_milliseconds()
 	return cpu->elapsedMsSinceStart;
 }
 
-void sys_info(int infoId, uint8_t *buffer)
+int sys_get_thread_stats(sched_thread_stats_t *buffer, int maxCount)
 {
+	if(maxCount <= 0)
+		return 0;
+	if(maxCount > SCHED_THREAD_STATS_MAX_COUNT)
+		maxCount = SCHED_THREAD_STATS_MAX_COUNT;
+	
+	// Collect into a kernel buffer first, the process and thread lists must not be locked while touching user memory
+	sched_thread_stats_t *stats = malloc(maxCount * sizeof(sched_thread_stats_t));
+	if(!stats)
+		return -1;
+	int count = proc_get_thread_stats(stats, maxCount);
+	if(!copy_to_user(buffer, stats, count * sizeof(sched_thread_stats_t)))
+		count = -1;
+	free(stats);
+	return count;
+}
+
+int sys_get_cpu_stats(sched_cpu_stats_t *buffer, int maxCount)
+{
+	int count = 0;
+	sched_cpu_stats_t stats;
+	for(int c = 0; c < cpuCount && count < maxCount; ++c)
+		if(sched_cpu_get_stats(c, &stats) && !copy_to_user(&buffer[count++], &stats, sizeof(stats)))
+			return -1;
+	return count;
+}
+
+void sys_syscall_stats_enable(bool enable, bool reset)
+{
+	syscallstat_enable(enable, reset);
+}
+
+int sys_get_syscall_stats(syscallstat_info_t *buffer, int maxCount)
+{
+	if(maxCount <= 0)
+		return 0;
+	if(maxCount > SYSCALLSTAT_MAX_INFO_COUNT)
+		maxCount = SYSCALLSTAT_MAX_INFO_COUNT;
+	
+	// Collect into a kernel buffer first, the process list must not be locked while touching user memory
+	syscallstat_info_t *stats = malloc(maxCount * sizeof(syscallstat_info_t));
+	if(!stats)
+		return -1;
+	int count = proc_get_syscall_stats(stats, maxCount);
+	if(!copy_to_user(buffer, stats, count * sizeof(syscallstat_info_t)))
+		count = -1;
+	free(stats);
+	return count;
+}
+
+int sys_lock_torture(int iterations, lock_torture_result_t *results, int maxCount)
+{
+	if(maxCount <= 0)
+		return 0;
+	if(maxCount > LOCK_TORTURE_TYPE_COUNT)
+		maxCount = LOCK_TORTURE_TYPE_COUNT;
+	
+	// The test runs for a while and yields, so do not write into user memory from inside
+	lock_torture_result_t stats[LOCK_TORTURE_TYPE_COUNT];
+	int count = lock_torture_run(iterations, stats, maxCount);
+	if(!copy_to_user(results, stats, count * sizeof(lock_torture_result_t)))
+		return -1;
+	return count;
+}
+
+int sys_mem_bench(int iterations, mem_bench_result_t *results, int maxCount)
+{
+	if(maxCount <= 0)
+		return 0;
+	if(maxCount > MEM_BENCH_MAX_RESULTS)
+		maxCount = MEM_BENCH_MAX_RESULTS;
+	
+	mem_bench_result_t *stats = malloc(maxCount * sizeof(mem_bench_result_t));
+	if(!stats)
+		return -1;
+	int count = mem_bench_run(iterations, stats, maxCount);
+	if(count > 0 && !copy_to_user(results, stats, count * sizeof(mem_bench_result_t)))
+		count = -1;
+	free(stats);
+	return count;
+}
+
+// Returns the buffer size needed by sys_info() for the given information ID, or 0 if the ID is unknown.
+static size_t sys_info_size(int infoId)
+{
+	switch(infoId)
+	{
+		case 0: return 4;
+		case 1: return topology_get_count() * 12;
+		case 2: return 8;
+		case 3: return 8;
+		case 4: return 16 + 64 * sizeof(lockstat_info_t);
+		case 5: return 8 + KSTAT_MAX_COUNT * sizeof(kstat_info_t);
+	}
+	return 0;
+}
+
+void sys_info(int infoId, uint8_t *userBuffer)
+{
+	// Fill a kernel buffer first, which is then copied to user space
+	size_t size = sys_info_size(infoId);
+	if(size == 0)
+		return;
+	uint8_t *buffer = malloc(size);
+	if(!buffer)
+		return;
+	memclr(buffer, size);
+	
 	// Act depending on information ID
 	uint32_t *buffer32 = (uint32_t *)buffer;
 	uint64_t *buffer64 = (uint64_t *)buffer;
@@ -63,8 +180,34 @@ void sys_info(int infoId, uint8_t *buffer)
 			cpu_id(0x8000001F, &eax, &ebx, &tmp, &tmp);
 			buffer32[0] = eax;
 			buffer32[1] = ebx;
+			break;
+		}
+		
+		// Return lock statistics of the 64 locks with the highest spin time (only in LOCKSTAT kernel builds)
+		// Buffer size: 16 + 64 * sizeof(lockstat_info_t) = 30224 Bytes
+		//     uint64_t count;
+		//     uint64_t untrackedAcquisitions;
+		//     lockstat_info_t infos[count];
+		case 4:
+		{
+			buffer64[0] = lockstat_get((lockstat_info_t *)&buffer64[2], 64, &buffer64[1]);
+			break;
+		}
+		
+		// Return kernel statistics (counters and histograms summed over all CPUs)
+		// Buffer size: 8 + KSTAT_MAX_COUNT * sizeof(kstat_info_t) = 18952 Bytes
+		//     uint64_t count;
+		//     kstat_info_t infos[count];
+		case 5:
+		{
+			buffer64[0] = kstat_get((kstat_info_t *)&buffer64[1], KSTAT_MAX_COUNT);
+			break;
 		}
 	}
+	
+	// An invalid buffer is simply not written
+	copy_to_user(userBuffer, buffer, size);
+	free(buffer);
 }
 
 void sys_dump(int infoId, const char *filePath)
@@ -78,5 +221,12 @@ void sys_dump(int infoId, const char *filePath)
 			pmm_dump_stack(filePath);
 			break;
 		}
+		
+		// Dump lock statistics
+		case 1:
+		{
+			lockstat_dump(filePath);
+			break;
+		}
 	}
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <proc/proc.h>
 #include <proc/sched.h>
 #include <proc/thread.h>
+#include <lock/intr.h>
 #include <stdlib/stdlib.h>
 #include <stdlib/string.h>
 #include <panic/panic.h>
@@ -10,23 +11,29 @@
 #include <proc/elf64.h>
 #include <smp/cpu.h>
 #include <fs/ramfs.h>
+#include <cpu/msr.h>
+#include <lock/preempt.h>
+#include <mm/common.h>
 
-void sys_run_thread(uint64_t rip, const char *name)
+int sys_run_thread(uint64_t rip, const char *name)
 {
 	// Create thread
-	// TODO error checking
 	thread_t *thread = thread_create(proc_get(), 0, name);
+	if(!thread)
+		return -1;
 	thread->rip = rip;
+	
+	// The thread may already exit and be freed once it is resumed
+	int id = thread->id;
 	thread_resume(thread);
+	return id;
 }
 
 void sys_exit_thread(cpu_state_t *state)
 {
-	// Stop thread
+	// Stop thread, it is freed by the reaper
 	thread_kill(thread_get());
 	sched_tick(state);
-	
-	// TODO clean up
 }
 
 bool sys_start_process(const char *programPath)
@@ -46,6 +53,7 @@ bool sys_start_process(const char *programPath)
 	if(ramfs_read(programKernelMem, programLength, fd) != programLength)
 	{
 		ramfs_close(fd);
+		free(programKernelMem);
 		return false;
 	}
 	ramfs_close(fd);
@@ -55,27 +63,48 @@ bool sys_start_process(const char *programPath)
 	proc_t *currProc = proc_get();
 	
 	// Create new process and switch address space
+	// This system call runs with interrupts enabled, so they are masked until the address space is restored: If we were
+	// preempted, the scheduler would not switch address spaces between threads of the same process, so a sibling thread
+	// would run in the new one, and we would continue in the old one
 	proc_t *proc = proc_create("user_spawned");
 	if(!proc)
 		panic("Error spawning process during system call");
+	intr_lock();
 	proc_switch(proc);
 	
 	// Load ELF file
-	if(!elf64_load(elf, programLength))
+	if(!elf64_load(elf, programLength, &proc->tls))
 	{
 		// Show error and restore current process
 		trace_printf("Error loading user-supplied ELF file\n");
 		proc_switch(currProc);
+		intr_unlock();
+		
+		// The process does not have any threads yet, so it can be destroyed right away
+		proc_destroy(proc);
+		free(programKernelMem);
 		return false;
 	}
 	
 	// Spawn thread
 	thread_t *thread = thread_create(proc, 0, "user_spawned main");
+	if(!thread)
+	{
+		trace_printf("Error creating main thread of user-supplied ELF file\n");
+		proc_switch(currProc);
+		intr_unlock();
+		
+		// As above
+		proc_destroy(proc);
+		free(programKernelMem);
+		return false;
+	}
 	thread->rip = elf->e_entry;
 	thread_resume(thread);
 	
 	// Restore current process
 	proc_switch(currProc);
+	intr_unlock();
 	
 	// Free memory containing the program executable
 	free(programKernelMem);
@@ -93,4 +122,43 @@ void sys_set_affinity(int coreId)
 	// Set affinity of current thread
 	thread_t *thread = thread_get();
 	thread->coreId = coreId;
-}
\ No newline at end of file
+}
+
+int sys_set_thread_scheduling(int threadId, int schedClass, int priority)
+{
+	// Negative ID selects the current thread
+	if(threadId < 0)
+		return sched_thread_set_class(thread_get(), (sched_class_t)schedClass, priority) ? 0 : -1;
+	
+	// Else only threads of the current process can be changed
+	thread_t *thread = proc_thread_find(proc_get(), threadId);
+	if(!thread)
+		return -1;
+	bool success = sched_thread_set_class(thread, (sched_class_t)schedClass, priority);
+	thread_put(thread);
+	return success ? 0 : -1;
+}
+
+bool sys_set_core_isolation(int coreId, bool isolated)
+{
+	return sched_set_core_isolated(coreId, isolated);
+}
+
+bool sys_set_fs_base(uint64_t base)
+{
+	if(base > VM_USER_END)
+		return false;
+	
+	// The scheduler reloads FS base from the thread on every switch, so the MSR and the cached value must not get out
+	// of sync with it
+	preempt_disable();
+	{
+		thread_t *thread = thread_get();
+		cpu_t *cpu = cpu_get();
+		thread->fs_base = base;
+		msr_write(MSR_FS_BASE, base);
+		cpu->fsBase = base;
+	}
+	preempt_enable();
+	return true;
+}
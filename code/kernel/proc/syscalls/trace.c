@@ -1,13 +1,14 @@
 
 #include <proc/syscalls.h>
-#include <mm/validate.h>
+#include <mm/uaccess.h>
 #include <trace/trace.h>
 
 int64_t sys_trace(const char *message)
 {
-  if (!valid_string(message))
+  char buffer[256];
+  if (strncpy_from_user(buffer, message, sizeof(buffer)) < 0)
     return -1; // TODO: return some meaningful err number
 
-  trace_puts(message);
+  trace_puts(buffer);
   return 0;
-}
+}
\ No newline at end of file
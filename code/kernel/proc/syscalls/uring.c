@@ -0,0 +1,19 @@
+
+#include <proc/syscalls.h>
+#include <proc/uring.h>
+#include <mm/uaccess.h>
+
+int sys_uring_setup(uring_t **userRing)
+{
+	// The ring stays allocated until the process exits if the address cannot be stored
+	uring_t *ring;
+	int handle = uring_setup(&ring);
+	if(handle >= 0 && !copy_to_user(userRing, &ring, sizeof(ring)))
+		return -1;
+	return handle;
+}
+
+int sys_uring_enter(int handle, uint32_t toSubmit, uint32_t minComplete, int64_t timeoutMs)
+{
+	return uring_enter(handle, toSubmit, minComplete, timeoutMs);
+}
\ No newline at end of file
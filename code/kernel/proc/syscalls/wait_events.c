@@ -0,0 +1,8 @@
+
+#include <proc/syscalls.h>
+#include <proc/events.h>
+
+uint32_t sys_wait_events(uint32_t mask, int64_t timeoutMs)
+{
+	return events_wait(mask, timeoutMs);
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+
+#include <proc/syscalls.h>
+#include <proc/msg.h>
+#include <proc/proc.h>
+#include <mm/uaccess.h>
+
+msg_type_t sys_wait_message(msg_header_t *messageBuffer, int64_t timeoutMs)
+{
+	// Get current process
+	proc_t *proc = proc_get();
+	
+	// Wait for message; it is dequeued into a kernel buffer first, as this happens with interrupts masked
+	uint8_t msg[MSG_RING_MAX_MESSAGE_SIZE] __attribute__((aligned(8)));
+	msg_type_t type = proc_wait_message(proc, (msg_header_t *)msg, timeoutMs);
+	if(type == MSG_INVALID)
+		return MSG_INVALID;
+	
+	// Copy message into user space buffer
+	if(!copy_to_user(messageBuffer, msg, ((msg_header_t *)msg)->size))
+		return MSG_INVALID;
+	return type;
+}
+
+void *sys_get_message_ring()
+{
+	return proc_map_message_ring();
+}
\ No newline at end of file
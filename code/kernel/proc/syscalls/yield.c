@@ -1,10 +1,26 @@
-
 #include <proc/syscalls.h>
-#include <cpu/state.h>
 #include <proc/sched.h>
+#include <proc/proc.h>
+#include <proc/thread.h>
+
+int sys_yield(void)
+{
+  sched_yield();
+  return 0; /* when yield() returns in userspace 0 is returned */
+}
+
+int sys_yield_to(int threadId)
+{
+  // Only threads of the current process can be targeted
+  thread_t *target = proc_thread_find(proc_get(), threadId);
+  if(!target)
+    return -1;
+  
+  sched_yield_to_put(target);
+  return 0;
+}
 
-void sys_yield(cpu_state_t *state)
+int sys_get_thread_id(void)
 {
-  state->regs[RAX] = 0; /* when yield() returns in userspace 0 is returned */
-  sched_tick(state);
+  return thread_get()->id;
 }
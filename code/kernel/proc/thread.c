@@ -5,12 +5,86 @@
 #include <cpu/gdt.h>
 #include <smp/cpu.h>
 #include <mm/seg.h>
+#include <mm/align.h>
+#include <mm/uaccess.h>
 #include <stdlib/stdlib.h>
 #include <stdlib/string.h>
 #include <cpu/xsave.h>
+#include <proc/reaper.h>
+#include <proc/wait.h>
 
 #define STACK_ALIGN 32
 
+// Maximum number of cached kernel stacks.
+#define KSTACK_CACHE_SIZE 32
+
+// Next thread ID.
+static int nextThreadId = 0;
+
+// Kernel stacks of destroyed threads, which are reused for new threads.
+static void *kstackCache[KSTACK_CACHE_SIZE];
+static int kstackCacheCount = 0;
+static spinlock_t kstackCacheLock = SPIN_UNLOCKED;
+
+// Returns a cached kernel stack, or allocates a new one.
+static void *thread_kstack_alloc(void)
+{
+  void *kstack = 0;
+  spin_lock_plain(&kstackCacheLock);
+  if (kstackCacheCount > 0)
+    kstack = kstackCache[--kstackCacheCount];
+  spin_unlock_plain(&kstackCacheLock);
+
+  if (!kstack)
+    kstack = memalign(STACK_ALIGN, KERNEL_STACK_SIZE);
+  return kstack;
+}
+
+// Puts the given kernel stack into the cache, or frees it if the cache is full.
+static void thread_kstack_free(void *kstack)
+{
+  spin_lock_plain(&kstackCacheLock);
+  if (kstackCacheCount < KSTACK_CACHE_SIZE)
+  {
+    kstackCache[kstackCacheCount++] = kstack;
+    kstack = 0;
+  }
+  spin_unlock_plain(&kstackCacheLock);
+
+  if (kstack)
+    free(kstack);
+}
+
+// Allocates the TLS block of the given user thread and initializes it from the process' TLS template, following
+// the x86-64 variant II layout: The block ends at the thread pointer, which is followed by the TCB.
+static bool thread_tls_alloc(proc_t *proc, thread_t *thread)
+{
+  elf64_tls_t *tls = &proc->tls;
+  if (tls->memsz == 0)
+    return true;
+
+  // The linker computes the variable offsets relative to the thread pointer using the block size rounded up to the
+  // alignment; as the segment is page-aligned, the thread pointer is aligned as well
+  size_t blockSize = (tls->memsz + tls->align - 1) & ~(tls->align - 1);
+  uint8_t *seg = seg_alloc(PAGE_ALIGN(blockSize + THREAD_TCB_SIZE), VM_R | VM_W);
+  if (!seg)
+    return false;
+
+  // The template lies in the current address space, see seg_alloc() above; the process may have unmapped it since
+  uint8_t *tp = seg + blockSize;
+  if (!copy_from_user(seg, (void *) tls->image, tls->filesz))
+  {
+    seg_free(seg);
+    return false;
+  }
+  memclr(seg + tls->filesz, blockSize - tls->filesz + THREAD_TCB_SIZE);
+  *(uint64_t *) tp = (uint64_t) tp;
+
+  thread->tls = seg;
+  thread->fs_base = (uint64_t) tp;
+  return true;
+}
+
 thread_t *thread_create(proc_t *proc, int flags, const char *name)
 {
   thread_t *thread = malloc(sizeof(*thread));
@@ -18,13 +92,28 @@ thread_t *thread_create(proc_t *proc, int flags, const char *name)
     return 0;
 
   /* allocate kernel-space stack */
-  thread->kstack = memalign(STACK_ALIGN, KERNEL_STACK_SIZE);
+  thread->kstack = thread_kstack_alloc();
   if (!thread->kstack)
   {
     free(thread);
     return 0;
   }
 
+  // Allocate space for XSAVE; kernel threads never touch vector registers
+  thread->xsave_state = 0;
+  thread->xsave_init = true;
+  thread->xsave_core = -1;
+  if (!(flags & THREAD_KERNEL))
+  {
+    thread->xsave_state = xsave_alloc();
+    if (!thread->xsave_state)
+    {
+      thread_kstack_free(thread->kstack);
+      free(thread);
+      return 0;
+    }
+  }
+
   /* allocate user-space stack */
   if (!(flags & THREAD_KERNEL))
   {
@@ -32,26 +121,56 @@ thread_t *thread_create(proc_t *proc, int flags, const char *name)
     thread->stack = seg_alloc(USER_STACK_SIZE, VM_R | VM_W);
     if (!thread->stack)
     {
-      free(thread->kstack);
+      xsave_free(thread->xsave_state);
+      thread_kstack_free(thread->kstack);
       free(thread);
       return 0;
     }
-	
-	// Make sure user-space stack is aligned to 0x...0 *before* call -> since there is no initial call, it must be aligned to 0x...8
-	uint64_t userSpaceStackPtr = (uint64_t)thread->stack;
-	while((userSpaceStackPtr & 0xF) != 0x8)
-		--userSpaceStackPtr;
-	thread->stack = (void *)userSpaceStackPtr;
+  }
+
+  // Allocate thread-local storage (ditto)
+  thread->tls = 0;
+  thread->fs_base = 0;
+  if (!(flags & THREAD_KERNEL) && !thread_tls_alloc(proc, thread))
+  {
+    seg_free(thread->stack);
+    xsave_free(thread->xsave_state);
+    thread_kstack_free(thread->kstack);
+    free(thread);
+    return 0;
   }
 
   thread->lock = SPIN_UNLOCKED;
   thread->state = THREAD_SUSPENDED;
   thread->proc = proc;
   thread->flags = flags;
+  // Make sure the stack is aligned to 0x...0 *before* call -> since there is no initial call, it must be aligned to 0x...8
+  // thread->stack keeps pointing to the segment base, so it can be freed again.
   thread->rsp = (flags & THREAD_KERNEL) ? ((uintptr_t) thread->kstack + KERNEL_STACK_SIZE) : ((uintptr_t) thread->stack + USER_STACK_SIZE);
+  thread->rsp -= 8;
   thread->kernel_rsp = (uintptr_t) thread->kstack + KERNEL_STACK_SIZE;
   thread->rflags = FLAGS_IF;
+  memset(thread->regs, 0, sizeof(thread->regs));
   thread->coreId = 0; // Use bootstrap processor by default
+  thread->id = __sync_fetch_and_add(&nextThreadId, 1);
+  thread->switch_rsp = 0;
+  thread->switch_intr_mask_count = 0;
+  thread->sched_queued = false;
+  thread->sched_class = SCHED_CLASS_NORMAL;
+  thread->sched_priority = SCHED_PRIORITY_NORMAL_DEFAULT;
+  thread->sched_slice_remaining = 0;
+  thread->sched_running = false;
+  thread->sched_last_core = -1;
+  thread->sched_last_epoch = 0;
+  thread->stat_run_cycles = 0;
+  thread->stat_wait_cycles = 0;
+  thread->stat_run_start = 0;
+  thread->stat_enqueue_time = 0;
+  thread->stat_switches_voluntary = 0;
+  thread->stat_switches_involuntary = 0;
+  thread->stat_migrations = 0;
+  thread->wait_entry = 0;
+  thread->refs = 0;
 
   if (flags & THREAD_KERNEL)
   {
@@ -65,9 +184,7 @@ thread_t *thread_create(proc_t *proc, int flags, const char *name)
     thread->ss = SLTR_USER_DATA | RPL3;
   }
 
-  // Allocate space for XSAVE
-  thread->xsave_state = xsave_alloc();
-  
+
   // Copy name
   strncpy(thread->name, name, sizeof(thread->name));
 	
@@ -96,15 +213,32 @@ void thread_resume(thread_t *thread)
 {
   spin_lock(&thread->lock);
   // TODO as above
-  thread->state = THREAD_RUNNING;
-  sched_thread_resume(thread);
+
+  /* dead threads stay dead */
+  if (thread->state != THREAD_ZOMBIE)
+  {
+    thread->state = THREAD_RUNNING;
+    sched_thread_resume(thread);
+  }
   spin_unlock(&thread->lock);
 }
 
+void thread_handoff(thread_t *thread)
+{
+  thread_resume(thread);
+  sched_yield_to(thread);
+}
+
 void thread_kill(thread_t *thread)
 {
   spin_lock(&thread->lock);
-  // TODO as above
+
+  /* threads can only die once */
+  if (thread->state == THREAD_ZOMBIE)
+  {
+    spin_unlock(&thread->lock);
+    return;
+  }
 
   /* suspend the thread if it is runnable */
   if (thread->state == THREAD_RUNNING)
@@ -115,29 +249,47 @@ void thread_kill(thread_t *thread)
    * (e.g. one thread may be waiting for another to another to deliver a
    * message), therefore we use a zombie state to indicate a process is dead.
    *
-   * once the reference count drops to zero the struct can be cleaned up for
-   * good.
+   * once the thread was switched out for good, the reaper cleans up the
+   * struct.
    */
   thread->state = THREAD_ZOMBIE;
   
-  /* free user-space stack */
-  if (!(thread->flags & THREAD_KERNEL))
+  // Free user-space stack and TLS block, if we are in the thread's address space. When the whole process exits, they
+  // are released together with all other segments
+  if (!(thread->flags & THREAD_KERNEL) && thread->proc == proc_get() && thread->proc->state == PROC_RUNNING)
+  {
     seg_free(thread->stack);
+    if (thread->tls)
+      seg_free(thread->tls);
+  }
 
   spin_unlock(&thread->lock);
+
+  // Hand over to the reaper
+  reaper_add(thread);
+}
+
+void thread_put(thread_t *thread)
+{
+  __atomic_sub_fetch(&thread->refs, 1, __ATOMIC_RELEASE);
 }
 
-void thread_destroy(thread_t *thread)
+bool thread_destroy(thread_t *thread)
 {
+  /* a thread killed while blocking must not stay in the wait queue */
+  wait_cancel(thread);
+
   /* detach thread from parent process */
-  proc_thread_remove(thread->proc, thread);
+  bool lastThread = proc_thread_remove(thread->proc, thread);
 
   /* free kernel-space stack */
-  free(thread->kstack);
+  thread_kstack_free(thread->kstack);
   
   // Free XSAVE space
-  xsave_free(thread->xsave_state);
+  if (thread->xsave_state)
+    xsave_free(thread->xsave_state);
 
   /* free thread structure itself */
   free(thread);
+  return lastThread;
 }
@@ -12,6 +12,9 @@
 #define USER_STACK_SIZE (128*1024) // 128 KB
 #define KERNEL_STACK_SIZE (16*1024) // 16 KB
 
+// Size of the thread control block behind the TLS block; its first 8 bytes point to itself (x86-64 TLS ABI).
+#define THREAD_TCB_SIZE 64
+
 typedef enum
 {
   THREAD_RUNNING,
@@ -19,7 +22,29 @@ typedef enum
   THREAD_ZOMBIE
 } thread_state_t;
 
-typedef struct
+// Scheduling classes, in descending precedence. Threads of a class only run if no thread of a preceding class
+// is runnable on the same core.
+typedef enum
+{
+  // Real-time: Runs until it yields or blocks, FIFO within the same priority. Higher priorities preempt lower ones.
+  SCHED_CLASS_RT = 0,
+  
+  // Normal time-shared threads, the priority is the weight of the time slice length.
+  SCHED_CLASS_NORMAL = 1,
+  
+  // Background threads, only run if the core would be idle otherwise.
+  SCHED_CLASS_BATCH = 2,
+  
+  SCHED_CLASS_COUNT
+} sched_class_t;
+
+#define SCHED_PRIORITY_RT_MIN 1
+#define SCHED_PRIORITY_RT_MAX 99
+#define SCHED_PRIORITY_NORMAL_MIN 1
+#define SCHED_PRIORITY_NORMAL_MAX 16
+#define SCHED_PRIORITY_NORMAL_DEFAULT 1
+
+typedef struct thread
 {
   /*
    * kernel stack for this thread. syscall_stub() relies on this being the
@@ -36,9 +61,19 @@ typedef struct
   /* base of the stacks (only used upon thread_destroy and in page fault handler) */
   void *kstack, *stack;
 
+  // Segment holding the thread-local storage block and the TCB, or 0 if the executable has no TLS.
+  // Like the user stack, it is freed in thread_kill(), or with the address space.
+  void *tls;
+
+  // Value of the FS base register, i.e. the thread pointer; loaded on every switch to this thread.
+  uint64_t fs_base;
+
   /* flags the thread was created with (ditto) */
   int flags;
 
+  // Unique thread ID.
+  int id;
+
   /* spinlock used to protect concurrent access to this structure */
   spinlock_t lock;
 
@@ -64,7 +99,63 @@ typedef struct
   uint64_t regs[15];
   uint64_t rip, rsp, rflags;
   uint64_t cs, ss;
+
+  // Vector register state. Kernel threads do not use vector registers and thus have no XSAVE area.
   void *xsave_state;
+
+  // Determines whether the vector registers were in init state when the thread was last switched out.
+  // In this case xsave_state is not up to date and the init state is loaded instead.
+  bool xsave_init;
+
+  // ID of the core that has last loaded this thread's vector state, or -1.
+  int xsave_core;
+
+  // Saved kernel stack pointer, if the thread suspended itself voluntarily (see sched_yield()); else 0.
+  // In the latter case the register file above is valid.
+  uint64_t switch_rsp;
+
+  // Interrupt mask count of the thread when it suspended itself voluntarily.
+  uint64_t switch_intr_mask_count;
+
+  // Determines whether the thread is currently contained in the scheduler's queue.
+  bool sched_queued;
+
+  // Scheduling class and priority within that class.
+  sched_class_t sched_class;
+  int sched_priority;
+
+  // Remaining timer ticks of the current time slice; 0 means unlimited.
+  int sched_slice_remaining;
+
+  // Determines whether the thread is currently running on a core.
+  bool sched_running;
+
+  // Core which last switched this thread out (or -1), and the value of its scheduler epoch at that time.
+  // Used to determine when the thread's kernel stack is not in use anymore.
+  int sched_last_core;
+  uint64_t sched_last_epoch;
+
+  // Accounting, in TSC ticks: Time spent running and waiting in the run queue, and the time stamps at which the thread
+  // was last switched in and last became runnable.
+  uint64_t stat_run_cycles;
+  uint64_t stat_wait_cycles;
+  uint64_t stat_run_start;
+  uint64_t stat_enqueue_time;
+
+  // Number of switches where the thread blocked (voluntary) or was preempted while still runnable (involuntary), and
+  // number of times it was picked by another core than the one which last ran it.
+  uint64_t stat_switches_voluntary;
+  uint64_t stat_switches_involuntary;
+  uint64_t stat_migrations;
+
+  // Node used by the reaper's list of dead threads.
+  list_node_t reap_node;
+
+  // Wait queue entry, while the thread is blocked in wait_event(); else 0.
+  struct wait_entry *wait_entry;
+
+  // Number of references obtained through proc_thread_find(). The reaper does not free the thread while it has any.
+  int refs;
 } thread_t;
 
 // Maximum name length: 31 characters.
@@ -73,7 +164,17 @@ thread_t *thread_create(struct proc *proc, int flags, const char *name);
 thread_t *thread_get(void);
 void thread_suspend(thread_t *thread);
 void thread_resume(thread_t *thread);
+
+// Resumes the given thread and immediately switches to it, if it is run by the current core.
+void thread_handoff(thread_t *thread);
+// Marks the given thread as dead and passes it to the reaper, which frees it once it is not running anymore.
 void thread_kill(thread_t *thread);
-void thread_destroy(thread_t *thread);
+
+// Drops a reference obtained through proc_thread_find().
+void thread_put(thread_t *thread);
+
+// Frees the given dead thread. Returns true if this was the last thread of its process.
+// Should only be called by the reaper.
+bool thread_destroy(thread_t *thread);
 
 #endif
@@ -0,0 +1,208 @@
+
+#include <proc/uring.h>
+#include <proc/proc.h>
+#include <proc/sched.h>
+#include <proc/syscalls.h>
+#include <proc/wait.h>
+#include <mm/heap.h>
+#include <mm/seg.h>
+#include <stdlib/stdlib.h>
+#include <stdlib/string.h>
+
+// Kernel state of a ring.
+typedef struct uring_instance
+{
+	// Kernel and user space mapping of the shared ring.
+	uring_t *ring;
+	uring_t *userRing;
+
+	// Kernel-owned positions; the copies in the shared ring are only informative.
+	uint64_t sqHead;
+	uint64_t cqTail;
+
+	// Set while a thread executes operations, as the SQ has a single consumer.
+	bool draining;
+
+	// Threads waiting for completions.
+	wait_queue_t waiters;
+} uring_instance_t;
+
+int uring_setup(uring_t **userRing)
+{
+	uring_instance_t *instance = malloc(sizeof(uring_instance_t));
+	if(!instance)
+		return -1;
+	instance->ring = heap_alloc(sizeof(uring_t), VM_R | VM_W);
+	if(!instance->ring)
+	{
+		free(instance);
+		return -1;
+	}
+	memclr(instance->ring, sizeof(uring_t));
+	instance->userRing = seg_map_shared(instance->ring, sizeof(uring_t), VM_R | VM_W);
+	if(!instance->userRing)
+	{
+		heap_free(instance->ring);
+		free(instance);
+		return -1;
+	}
+	instance->sqHead = 0;
+	instance->cqTail = 0;
+	instance->draining = false;
+	wait_queue_init(&instance->waiters);
+
+	// Find free slot
+	proc_t *proc = proc_get();
+	int handle = -1;
+	spin_lock_plain(&proc->uringLock);
+	for(int h = 0; h < URING_MAX_RINGS; ++h)
+	{
+		if(!proc->urings[h])
+		{
+			proc->urings[h] = instance;
+			handle = h;
+			break;
+		}
+	}
+	spin_unlock_plain(&proc->uringLock);
+
+	if(handle < 0)
+	{
+		seg_unmap_shared(instance->userRing);
+		heap_free(instance->ring);
+		free(instance);
+		return -1;
+	}
+	*userRing = instance->userRing;
+	return handle;
+}
+
+// Executes the given operation and returns its result.
+static int64_t uring_execute(uring_sqe_t *sqe)
+{
+	uint64_t *args = sqe->args;
+	switch(sqe->op)
+	{
+		case URING_OP_NOP:
+			return 0;
+
+		case URING_OP_VBE_RECTANGLE:
+			return sys_vbe_rectangle(args[0], args[1], args[2], args[3]);
+
+		case URING_OP_VBE_RENDER_CHAR:
+			return sys_vbe_render_char(args[0], args[1], (char)args[2]);
+
+		case URING_OP_VBE_DRAW:
+			return sys_vbe_draw((uint32_t *)args[0], args[1], args[2], args[3], args[4]);
+
+		case URING_OP_VBE_SET_FRONT_COLOR:
+			sys_vbe_set_front_color(args[0], args[1], args[2]);
+			return 0;
+
+		case URING_OP_VBE_SET_BACK_COLOR:
+			sys_vbe_set_back_color(args[0], args[1], args[2]);
+			return 0;
+
+		case URING_OP_FS_READ:
+			return sys_fs_read((uint8_t *)args[0], args[1], (ramfs_fd_t)args[2]);
+
+		case URING_OP_FS_WRITE:
+			return sys_fs_write((uint8_t *)args[0], args[1], (ramfs_fd_t)args[2]);
+
+		case URING_OP_NET_SEND:
+			sys_send_network_packet((uint8_t *)args[0], (int)args[1]);
+			return 0;
+
+		case URING_OP_NET_RECEIVE:
+			return sys_receive_network_packet((uint8_t *)args[0]);
+
+		default:
+			return -1;
+	}
+}
+
+// Wait condition of uring_enter(): Checks whether enough completions are pending.
+typedef struct
+{
+	uring_instance_t *instance;
+	uint32_t minComplete;
+} uring_wait_args_t;
+static bool uring_completions_pending(void *arg)
+{
+	uring_wait_args_t *args = (uring_wait_args_t *)arg;
+	uint64_t cqTail = __atomic_load_n(&args->instance->cqTail, __ATOMIC_ACQUIRE);
+	return cqTail - __atomic_load_n(&args->instance->ring->cqHead, __ATOMIC_ACQUIRE) >= args->minComplete;
+}
+
+int uring_enter(int handle, uint32_t toSubmit, uint32_t minComplete, int64_t timeoutMs)
+{
+	if(handle < 0 || handle >= URING_MAX_RINGS)
+		return -1;
+
+	// Rings are only freed with the process, so no reference is needed
+	proc_t *proc = proc_get();
+	uring_instance_t *instance = __atomic_load_n(&proc->urings[handle], __ATOMIC_ACQUIRE);
+	if(!instance)
+		return -1;
+	uring_t *ring = instance->ring;
+
+	// Execute submitted operations
+	int submitted = 0;
+	if(toSubmit > 0)
+	{
+		while(__atomic_exchange_n(&instance->draining, true, __ATOMIC_ACQUIRE))
+			sched_yield();
+
+		// Do not trust the user-written positions beyond the ring sizes
+		uint64_t sqTail = __atomic_load_n(&ring->sqTail, __ATOMIC_ACQUIRE);
+		uint64_t available = sqTail - instance->sqHead;
+		if(available > URING_SQ_ENTRIES)
+			available = URING_SQ_ENTRIES;
+		if(toSubmit > available)
+			toSubmit = available;
+
+		for(; (uint32_t)submitted < toSubmit; ++submitted)
+		{
+			// Stop when the CQ is full, the remaining operations stay queued
+			if(instance->cqTail - __atomic_load_n(&ring->cqHead, __ATOMIC_ACQUIRE) >= URING_CQ_ENTRIES)
+				break;
+
+			// Copy the entry first, user space might modify it concurrently
+			uring_sqe_t sqe = ring->sqes[instance->sqHead % URING_SQ_ENTRIES];
+			++instance->sqHead;
+			__atomic_store_n(&ring->sqHead, instance->sqHead, __ATOMIC_RELEASE);
+
+			uring_cqe_t *cqe = &ring->cqes[instance->cqTail % URING_CQ_ENTRIES];
+			cqe->userData = sqe.userData;
+			cqe->result = uring_execute(&sqe);
+			__atomic_store_n(&instance->cqTail, instance->cqTail + 1, __ATOMIC_RELEASE);
+			__atomic_store_n(&ring->cqTail, instance->cqTail, __ATOMIC_RELEASE);
+		}
+
+		__atomic_store_n(&instance->draining, false, __ATOMIC_RELEASE);
+		if(submitted > 0)
+			wait_wake_all(&instance->waiters);
+	}
+
+	// Wait for completions
+	if(minComplete > 0)
+	{
+		uring_wait_args_t args = { .instance = instance, .minComplete = minComplete };
+		wait_event(&instance->waiters, &uring_completions_pending, &args, timeoutMs);
+	}
+	return submitted;
+}
+
+void uring_destroy_all(proc_t *proc)
+{
+	// The user space mappings were removed together with the address space
+	for(int h = 0; h < URING_MAX_RINGS; ++h)
+	{
+		uring_instance_t *instance = proc->urings[h];
+		if(!instance)
+			continue;
+		heap_free(instance->ring);
+		free(instance);
+		proc->urings[h] = 0;
+	}
+}
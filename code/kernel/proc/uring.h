@@ -0,0 +1,89 @@
+
+#ifndef _PROC_URING_H
+#define _PROC_URING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Batched system calls through shared submission and completion rings.
+//
+// User space writes operations into the submission queue (SQ) and advances sqTail; sys_uring_enter() executes them
+// in order and posts one completion (CQE) each into the completion queue (CQ), advancing cqTail. User space consumes
+// completions and advances cqHead. Each tail is written by exactly one side, so the rings need no locking; the
+// kernel keeps its own copies of the positions it owns, user space can not confuse it by overwriting them.
+// Operations are executed synchronously, so a batch needs a single system call. Threads can wait for completions
+// posted by others via the minComplete parameter of sys_uring_enter().
+
+// Number of SQ and CQ entries. The CQ is larger, so completions can pile up while the next batch is submitted.
+#define URING_SQ_ENTRIES 256
+#define URING_CQ_ENTRIES 512
+
+// Number of rings per process.
+#define URING_MAX_RINGS 4
+
+// Supported operations. The arguments correspond to the parameters of the respective system call.
+typedef enum
+{
+	URING_OP_NOP = 0,
+	URING_OP_VBE_RECTANGLE = 1,       // posX, posY, width, height
+	URING_OP_VBE_RENDER_CHAR = 2,     // posX, posY, c
+	URING_OP_VBE_DRAW = 3,            // pixels, posX, posY, width, height
+	URING_OP_VBE_SET_FRONT_COLOR = 4, // r, g, b
+	URING_OP_VBE_SET_BACK_COLOR = 5,  // r, g, b
+	URING_OP_FS_READ = 6,             // buffer, length, fd
+	URING_OP_FS_WRITE = 7,            // buffer, length, fd
+	URING_OP_NET_SEND = 8,            // packet, packetLength
+	URING_OP_NET_RECEIVE = 9,         // packetBuffer
+} uring_op_t;
+
+// Submission queue entry.
+typedef struct
+{
+	uint32_t op;
+	uint32_t reserved;
+	uint64_t args[5];
+
+	// Passed unchanged to the completion.
+	uint64_t userData;
+} __attribute__((aligned(64))) uring_sqe_t;
+
+// Completion queue entry.
+typedef struct
+{
+	uint64_t userData;
+
+	// Return value of the operation (0 for operations without one), or -1 for unknown operations.
+	int64_t result;
+} uring_cqe_t;
+
+// Shared ring layout.
+typedef struct
+{
+	// Next SQE to be executed (written by the kernel), and next free SQE (written by user space).
+	uint64_t sqHead __attribute__((aligned(64)));
+	uint64_t sqTail __attribute__((aligned(64)));
+
+	// Next CQE to be consumed (written by user space), and next free CQE (written by the kernel).
+	uint64_t cqHead __attribute__((aligned(64)));
+	uint64_t cqTail __attribute__((aligned(64)));
+
+	uring_sqe_t sqes[URING_SQ_ENTRIES] __attribute__((aligned(4096)));
+	uring_cqe_t cqes[URING_CQ_ENTRIES];
+} uring_t;
+
+struct uring_instance;
+struct proc;
+
+// Creates a new ring for the current process and maps it. Returns the ring handle and stores the user space address,
+// or returns -1 if the process has no free ring slot or memory is exhausted.
+int uring_setup(uring_t **userRing);
+
+// Executes up to toSubmit submitted operations of the given ring, and then waits up to the given amount of
+// milliseconds (negative: forever) until at least minComplete completions are pending. Returns the number of executed
+// operations, or -1 for an invalid handle.
+int uring_enter(int handle, uint32_t toSubmit, uint32_t minComplete, int64_t timeoutMs);
+
+// Frees the rings of the given process, whose threads and address space must already be destroyed.
+void uring_destroy_all(struct proc *proc);
+
+#endif
@@ -0,0 +1,123 @@
+
+#include <proc/wait.h>
+#include <proc/thread.h>
+#include <proc/sched.h>
+#include <smp/cpu.h>
+#include <util/container.h>
+
+// Waiting threads with a timeout.
+static list_t waitTimeouts = LIST_EMPTY;
+static spinlock_t waitTimeoutsLock = SPIN_UNLOCKED;
+
+// Returns the current time in milliseconds; the boot core keeps the system time.
+static uint64_t wait_now(void)
+{
+	return __atomic_load_n(&cpu_get_bsp()->elapsedMsSinceStart, __ATOMIC_RELAXED);
+}
+
+void wait_queue_init(wait_queue_t *queue)
+{
+	list_init(&queue->waiters);
+	queue->lock = SPIN_UNLOCKED;
+}
+
+bool wait_event(wait_queue_t *queue, wait_condition_t condition, void *arg, int64_t timeoutMs)
+{
+	thread_t *thread = thread_get();
+	wait_entry_t entry;
+	entry.thread = thread;
+	entry.queue = queue;
+	entry.timed = (timeoutMs > 0);
+	entry.deadline = (entry.timed ? wait_now() + (uint64_t)timeoutMs : 0);
+	entry.timedOut = false;
+	
+	bool queued = false;
+	while(true)
+	{
+		spin_lock(&queue->lock);
+		bool result = condition(arg);
+		if(result || timeoutMs == 0 || __atomic_load_n(&entry.timedOut, __ATOMIC_SEQ_CST))
+		{
+			// Done, leave the queue
+			if(queued)
+			{
+				list_remove(&queue->waiters, &entry.node);
+				thread->wait_entry = 0;
+			}
+			spin_unlock(&queue->lock);
+			
+			if(queued && entry.timed)
+			{
+				spin_lock(&waitTimeoutsLock);
+				list_remove(&waitTimeouts, &entry.timeoutNode);
+				spin_unlock(&waitTimeoutsLock);
+			}
+			return result;
+		}
+		
+		// Enqueue on first iteration
+		if(!queued)
+		{
+			list_add_tail(&queue->waiters, &entry.node);
+			thread->wait_entry = &entry;
+			if(entry.timed)
+			{
+				spin_lock(&waitTimeoutsLock);
+				list_add_tail(&waitTimeouts, &entry.timeoutNode);
+				spin_unlock(&waitTimeoutsLock);
+			}
+			queued = true;
+		}
+		
+		// Sleep until woken up. The timer does not take the queue lock, so it might have fired before we suspended:
+		// It sets the flag before resuming us, so either we see the flag here or the resume comes after the suspend
+		thread_suspend(thread);
+		if(__atomic_load_n(&entry.timedOut, __ATOMIC_SEQ_CST))
+			thread_resume(thread);
+		spin_unlock(&queue->lock);
+		sched_yield();
+	}
+}
+
+void wait_wake_all(wait_queue_t *queue)
+{
+	spin_lock(&queue->lock);
+	list_for_each(&queue->waiters, node)
+		thread_resume(container_of(node, wait_entry_t, node)->thread);
+	spin_unlock(&queue->lock);
+}
+
+void wait_cancel(thread_t *thread)
+{
+	wait_entry_t *entry = thread->wait_entry;
+	if(!entry)
+		return;
+	
+	spin_lock(&entry->queue->lock);
+	list_remove(&entry->queue->waiters, &entry->node);
+	thread->wait_entry = 0;
+	spin_unlock(&entry->queue->lock);
+	
+	if(entry->timed)
+	{
+		spin_lock(&waitTimeoutsLock);
+		list_remove(&waitTimeouts, &entry->timeoutNode);
+		spin_unlock(&waitTimeoutsLock);
+	}
+}
+
+void wait_handle_timeouts(uint64_t nowMs)
+{
+	spin_lock(&waitTimeoutsLock);
+	list_for_each(&waitTimeouts, node)
+	{
+		// The entry stays in the list until its thread removes it, so only wake it once
+		wait_entry_t *entry = container_of(node, wait_entry_t, timeoutNode);
+		if(!entry->timedOut && entry->deadline <= nowMs)
+		{
+			__atomic_store_n(&entry->timedOut, true, __ATOMIC_SEQ_CST);
+			thread_resume(entry->thread);
+		}
+	}
+	spin_unlock(&waitTimeoutsLock);
+}
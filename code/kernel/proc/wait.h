@@ -0,0 +1,59 @@
+
+#ifndef _PROC_WAIT_H
+#define _PROC_WAIT_H
+
+#include <lock/spinlock.h>
+#include <util/list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+// Queue of threads blocking until some condition holds, e.g. until a message arrives.
+typedef struct
+{
+	list_t waiters;
+	spinlock_t lock;
+} wait_queue_t;
+
+// A thread waiting in a wait queue. Lives on the waiting thread's kernel stack.
+typedef struct wait_entry
+{
+	struct thread *thread;
+	wait_queue_t *queue;
+	list_node_t node;
+	
+	// Absolute timeout in milliseconds (see sys_get_elapsed_milliseconds()), if the wait is timed.
+	bool timed;
+	uint64_t deadline;
+	list_node_t timeoutNode;
+	
+	// Set by the timer when the deadline has passed.
+	bool timedOut;
+} wait_entry_t;
+
+// Condition function of wait_event(). Called with the wait queue lock held, i.e. with interrupts masked, so it must
+// not block or touch user memory.
+typedef bool (*wait_condition_t)(void *arg);
+
+#define WAIT_QUEUE_INIT { .waiters = LIST_EMPTY, .lock = SPIN_UNLOCKED }
+
+void wait_queue_init(wait_queue_t *queue);
+
+// Blocks the current thread until the given condition holds or the timeout (in milliseconds) has passed. A timeout of 0
+// only checks the condition once, a negative timeout waits forever. Returns whether the condition holds. The
+// condition is checked with the queue lock held, so a wait_wake_all() after making it true is never lost.
+// Timeouts are handled with the granularity of the scheduler tick.
+bool wait_event(wait_queue_t *queue, wait_condition_t condition, void *arg, int64_t timeoutMs);
+
+// Wakes all threads waiting in the given queue, so they check their condition again. May be called by interrupt
+// handlers.
+void wait_wake_all(wait_queue_t *queue);
+
+// Removes the given killed thread from the queue it is waiting in, if any. The thread must not run anymore.
+void wait_cancel(struct thread *thread);
+
+// Wakes up waiting threads whose timeout has passed. Called by the timer interrupt of the boot core.
+void wait_handle_timeouts(uint64_t nowMs);
+
+#endif
@@ -0,0 +1,93 @@
+#include <proc/workqueue.h>
+#include <proc/kthread.h>
+#include <proc/sched.h>
+#include <smp/cpu.h>
+#include <util/container.h>
+#include <lock/spinlock.h>
+#include <panic/panic.h>
+#include <stdlib/string.h>
+
+// Main function of the worker threads.
+// Runs the queued work items of the given CPU one after another, and sleeps while there is nothing to do.
+static void workqueue_run(void *arg)
+{
+	cpu_t *cpu = (cpu_t *)arg;
+	while(true)
+	{
+		// Take next item; if the queue is empty, sleep until work_queue_on() wakes us up again
+		work_t *work = 0;
+		spin_lock(&cpu->workQueueLock);
+		{
+			if(cpu->workQueue.head)
+			{
+				work = container_of(cpu->workQueue.head, work_t, node);
+				list_remove(&cpu->workQueue, &work->node);
+				work->pending = false;
+			}
+			else
+				thread_suspend(cpu->workThread);
+		}
+		spin_unlock(&cpu->workQueueLock);
+		
+		if(work)
+			work->func(work);
+		else
+			sched_yield();
+	}
+}
+
+void work_init(work_t *work, work_func_t func)
+{
+	work->func = func;
+	work->pending = false;
+}
+
+void workqueue_init(void)
+{
+	list_for_each(&cpu_list, node)
+	{
+		cpu_t *cpu = container_of(node, cpu_t, node);
+		
+		char name[32] = "worker #";
+		itoa(cpu->coreId, &name[8], 10);
+		
+		thread_t *thread = kthread_create(name, &workqueue_run, cpu, cpu->coreId);
+		if(!thread)
+			panic("couldn't create worker thread");
+		
+		// Deferred work should be done before any user thread continues
+		sched_thread_set_class(thread, SCHED_CLASS_RT, SCHED_PRIORITY_RT_MAX);
+		
+		// Items may have been queued already during boot
+		spin_lock(&cpu->workQueueLock);
+		cpu->workThread = thread;
+		spin_unlock(&cpu->workQueueLock);
+		thread_resume(thread);
+	}
+}
+
+bool work_queue(work_t *work)
+{
+	// Threads do not migrate between cores, so the core ID stays valid
+	return work_queue_on(cpu_get()->coreId, work);
+}
+
+bool work_queue_on(int coreId, work_t *work)
+{
+	cpu_t *cpu = cpu_get_by_id(coreId);
+	if(!cpu)
+		return false;
+	
+	// Items can only be queued once
+	if(!__sync_bool_compare_and_swap(&work->pending, false, true))
+		return false;
+	
+	spin_lock(&cpu->workQueueLock);
+	list_add_tail(&cpu->workQueue, &work->node);
+	thread_t *workThread = cpu->workThread;
+	spin_unlock(&cpu->workQueueLock);
+	
+	if(workThread)
+		thread_resume(workThread);
+	return true;
+}
@@ -0,0 +1,40 @@
+#ifndef _PROC_WORKQUEUE_H
+#define _PROC_WORKQUEUE_H
+
+#include <util/list.h>
+#include <stdbool.h>
+
+struct work;
+
+// Function executing a deferred work item.
+typedef void (*work_func_t)(struct work *work);
+
+// A deferred work item. Embed it into the object the work operates on, and use container_of() to get back to it.
+typedef struct work
+{
+	// Node in the work queue of a CPU.
+	list_node_t node;
+	
+	// Function doing the actual work.
+	work_func_t func;
+	
+	// Determines whether the item is currently queued. It is reset right before the function is called, so the item
+	// may be queued again while it runs.
+	bool pending;
+} work_t;
+
+// Initializes the given work item.
+void work_init(work_t *work, work_func_t func);
+
+// Starts the worker threads of all CPUs.
+void workqueue_init(void);
+
+// Queues the given work item on the current CPU. Returns false if the item is already pending.
+// This can be called from interrupt handlers: The worker thread has real-time priority and replaces the interrupted
+// thread as soon as the handler returns, so heavy work can be moved out of interrupt context (bottom half).
+bool work_queue(work_t *work);
+
+// Queues the given work item on the given CPU. Returns false if the item is already pending.
+bool work_queue_on(int coreId, work_t *work);
+
+#endif
@@ -1,13 +1,16 @@
 
 #include <smp/cpu.h>
+#include <smp/percpu.h>
 #include <cpu/msr.h>
 #include <stdlib/stdlib.h>
 #include <stdlib/string.h>
+#include <util/container.h>
 
 list_t cpu_list = LIST_EMPTY;
 int cpuCount = 0;
 
-static cpu_t cpu_bsp;
+// The cpu_t of each CPU is at the start of its per-CPU area; the BSP uses the per-CPU section of the kernel image.
+static cpu_t cpu_bsp __attribute__((__section__(".percpu.cpu")));
 
 static int nextCoreId = 0;
 
@@ -30,12 +33,10 @@ void cpu_bsp_init(void)
 
 bool cpu_ap_init(cpu_lapic_id_t lapic_id, cpu_acpi_id_t acpi_id)
 {
-  cpu_t *cpu = malloc(sizeof(*cpu));
+  cpu_t *cpu = percpu_alloc();
   if (!cpu)
     return false;
 
-  memclr(cpu, sizeof(*cpu));
-
   cpu->self = cpu;
   cpu->lapic_id = lapic_id;
   cpu->acpi_id = acpi_id;
@@ -59,4 +60,26 @@ void cpu_ap_install(cpu_t *cpu)
 cpu_t *cpu_get_bsp()
 {
 	return &cpu_bsp;
-}
\ No newline at end of file
+}
+
+cpu_t *cpu_get_by_id(int coreId)
+{
+	list_for_each(&cpu_list, node)
+	{
+		cpu_t *cpu = container_of(node, cpu_t, node);
+		if(cpu->coreId == coreId)
+			return cpu;
+	}
+	return 0;
+}
+
+cpu_t *cpu_get_by_lapic_id(cpu_lapic_id_t lapic_id)
+{
+	list_for_each(&cpu_list, node)
+	{
+		cpu_t *cpu = container_of(node, cpu_t, node);
+		if(cpu->lapic_id == lapic_id)
+			return cpu;
+	}
+	return 0;
+}
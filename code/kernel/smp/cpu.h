@@ -6,6 +6,7 @@
 #include <cpu/tss.h>
 #include <proc/proc.h>
 #include <proc/thread.h>
+#include <proc/sched.h>
 #include <util/list.h>
 #include <defs/types.h>
 #include <stdbool.h>
@@ -33,6 +34,15 @@ typedef struct cpu
 	*/
 	thread_t *thread;
 
+	// Number of nested preempt_disable() calls; the scheduler does not switch threads while it is non-zero.
+	// preempt.s relies on this being the fourth group of 8 bytes.
+	uint64_t preempt_count;
+
+	// Set when a thread becomes runnable that should replace the current one right away, i.e. if this CPU is idle or
+	// the new thread has precedence. The idle thread monitors this flag, interrupt handlers check it on return.
+	// syscall_stub() relies on this being the fifth group of 8 bytes.
+	volatile bool needResched;
+
 	/* global CPU list node */
 	list_node_t node;
 
@@ -56,9 +66,22 @@ typedef struct cpu
 	/* idle thread for this cpu */
 	thread_t *idle_thread;
 
+	// The user thread whose vector state was loaded last on this CPU.
+	// As kernel threads do not touch vector registers, these still hold the state of this thread.
+	thread_t *xsave_owner;
+
+	// Set while the kernel uses the vector registers (see kernel_fpu_begin()).
+	bool fpuActive;
+
+	// Current value of the FS base register, to skip the MSR write when switching between threads with the same value.
+	uint64_t fsBase;
+
 	/* number of APIC ticks per millisecond */
 	uint32_t apic_ticks_per_ms;
 
+	// Number of TSC ticks per millisecond, determined alongside the APIC timer frequency. 0 if the APIC timer is not used.
+	uint64_t tsc_ticks_per_ms;
+
 	// Total amount of elapsed milliseconds since the scheduler was started on this CPU (accurate to around 10ms).
 	uint64_t elapsedMsSinceStart;
 
@@ -73,6 +96,37 @@ typedef struct cpu
 	
 	// The current entry count of the CPU's TLB queue.
 	int tlbOperationQueueLength;
+	
+	// Determines whether this CPU is isolated: It does not receive scheduler ticks while running a single thread,
+	// only gets TLB shootdowns for the address space it runs, and no threads are placed on it automatically.
+	bool isolated;
+	
+	// Determines whether the scheduler timer of this CPU is currently stopped.
+	bool tickStopped;
+	
+	// Incremented each time the scheduler is entered on this CPU.
+	uint64_t schedEpoch;
+	
+	// Determines whether the idle thread waits with MONITOR/MWAIT, so writing needResched suffices to wake it up.
+	// Else it uses HLT and needs a reschedule IPI.
+	bool idleMwait;
+	
+	// Queue of deferred work items of this CPU, and the kernel thread processing them (see workqueue.h).
+	list_t workQueue;
+	spinlock_t workQueueLock;
+	thread_t *workThread;
+	
+	// Number of thread switches performed by this CPU.
+	uint64_t schedSwitches;
+	
+	// Histogram of run-queue latencies (time from a thread becoming runnable until it is picked by this CPU).
+	// Bucket i counts latencies of [2^i, 2^(i+1)) TSC ticks, bucket 0 also contains latencies below 1 tick.
+	uint64_t schedLatencyHistogram[SCHED_LATENCY_BUCKETS];
+	
+	// Determines whether RCU writers wait for quiescent states of this CPU, and the number of quiescent states it has
+	// passed so far (see rcu.h).
+	bool rcuOnline;
+	uint64_t rcuQsCount;
 } cpu_t;
 
 extern list_t cpu_list;
@@ -88,4 +142,10 @@ cpu_t *cpu_get(void);
 // Returns the bootstrap processor data.
 cpu_t *cpu_get_bsp();
 
+// Returns the processor data of the given core, or 0 if it does not exist.
+cpu_t *cpu_get_by_id(int coreId);
+
+// Returns the processor data of the core with the given local APIC ID, or 0 if it does not exist.
+cpu_t *cpu_get_by_lapic_id(cpu_lapic_id_t lapic_id);
+
 #endif
@@ -12,6 +12,7 @@
 #include <lock/barrier.h>
 #include <lock/intr.h>
 #include <lock/spinlock.h>
+#include <lock/rcu.h>
 #include <intr/apic.h>
 #include <mm/vmm.h>
 #include <time/pit.h>
@@ -28,9 +29,8 @@
 #define IDLE_STACK_SIZE	8192
 #define IDLE_STACK_ALIGN 16
 
-/* some variables used to exchange data between the BSP and APs */
-static bool ack_sipi = false;
-static cpu_t *booted_cpu;
+// Number of APs which have acknowledged the STARTUP IPI, i.e. are running on their bootstrap stack.
+static int acked_cpus = 0;
 
 /* a counter of ready CPUs, smp_init() blocks until all APs are ready */
 static int ready_cpus = 1;
@@ -46,58 +46,69 @@ static void print_cpu_info(cpu_t *cpu)
 	trace_printf(" => CPU (struct at %0#18x, id %0#10x%s)\n", cpu, cpu->lapic_id, str);
 }
 
-/* bring up an AP */
-static void smp_boot(cpu_t *cpu)
+// Brings up all APs in parallel: Each AP gets its INIT and STARTUP IPIs without waiting for the previous one to come up.
+// The APs claim their bootstrap stacks in arrival order and find their cpu_t by their local APIC ID.
+static void smp_boot_all(void)
 {
+	int apCount = cpu_list.size - 1;
+	if(apCount == 0)
+		return;
+	
 	/* figure out where the trampoline is */
-	extern int trampoline_start, trampoline_end, trampoline_stack;
+	extern int trampoline_start, trampoline_end, trampoline_stacks, trampoline_stack_index;
 	size_t trampoline_len = (uintptr_t) &trampoline_end - (uintptr_t) &trampoline_start;
 	
 	/* map the trampoline into low memory */
 	if (!vmm_map_range(TRAMPOLINE_BASE, TRAMPOLINE_BASE, trampoline_len, VM_R | VM_W | VM_X))
 		panic("couldn't map SMP trampoline code");
 
-	/* allocate a stack for this AP */
-	void *idle_stack = memalign(IDLE_STACK_ALIGN, IDLE_STACK_SIZE);
-	if (!idle_stack)
-		panic("couldn't allocate AP stack");
-
-	/* set up this cpu's bootstrap stack */
-	uint64_t *rsp = (uint64_t *) &trampoline_stack;
-	*rsp = (uint64_t) idle_stack + IDLE_STACK_SIZE;
-
-	/* set the pointer to the cpu struct of the cpu we are booting */
-	booted_cpu = cpu;
+	// Allocate bootstrap stacks for all APs
+	uint64_t *stacks = malloc(apCount * sizeof(uint64_t));
+	if (!stacks)
+		panic("couldn't allocate AP stack table");
+	for (int i = 0; i < apCount; ++i)
+	{
+		void *idle_stack = memalign(IDLE_STACK_ALIGN, IDLE_STACK_SIZE);
+		if (!idle_stack)
+			panic("couldn't allocate AP stack");
+		stacks[i] = (uint64_t) idle_stack + IDLE_STACK_SIZE;
+	}
+	*(uint64_t **) &trampoline_stacks = stacks;
+	*(uint64_t *) &trampoline_stack_index = 0;
 	
 	/* copy the trampoline into low memory */
 	memcpy((void *) TRAMPOLINE_BASE, &trampoline_start, trampoline_len);
-	
-	/* reset the ack flag */
-	ack_sipi = false;
 	barrier();
 	
-	/* send INIT IPI */
-	apic_ipi_init(cpu->lapic_id);
+	/* send INIT IPIs */
+	list_for_each(&cpu_list, node)
+	{
+		cpu_t *cpu = container_of(node, cpu_t, node);
+		if (!cpu->bsp)
+			apic_ipi_init(cpu->lapic_id);
+	}
 	pit_mdelay(10);
 	
-	/* send STARTUP IPI */
+	/* send STARTUP IPIs; a second one is only needed if not all APs have come up, the others ignore it */
 	uint8_t vector = TRAMPOLINE_BASE / FRAME_SIZE;
-	apic_ipi_startup(cpu->lapic_id, vector);
-	pit_mdelay(1);
-
-	/* send STARTUP IPI again */
-	if (!ack_sipi)
+	for (int round = 0; round < 2 && __atomic_load_n(&acked_cpus, __ATOMIC_ACQUIRE) != apCount; ++round)
 	{
-		apic_ipi_startup(cpu->lapic_id, vector);
+		list_for_each(&cpu_list, node)
+		{
+			cpu_t *cpu = container_of(node, cpu_t, node);
+			if (!cpu->bsp)
+				apic_ipi_startup(cpu->lapic_id, vector);
+		}
 		pit_mdelay(1);
 	}
 
-	/* wait for the AP to come up */
-	while (!ack_sipi)
+	/* wait for the APs to come up */
+	while (__atomic_load_n(&acked_cpus, __ATOMIC_ACQUIRE) != apCount)
 		pause_once();
 
-	/* unmap the trampoline */
+	/* unmap the trampoline; all APs have left it and loaded their stack pointers */
 	vmm_unmap_range(TRAMPOLINE_BASE, trampoline_len);
+	free(stacks);
 }
 
 void smp_init(void)
@@ -105,21 +116,13 @@ void smp_init(void)
 	// Initialize CPU topology storage
 	topology_prepare(cpuCount);
 	
-	/* bring up all of the APs */
-	list_for_each(&cpu_list, node)
-	{
-		cpu_t *cpu = container_of(node, cpu_t, node);
-		
-		if(!cpu->bsp)
-			smp_boot(cpu);
-		else
-		{
-			// Retrieve topology information
-			topology_init(cpu);
+	// Retrieve topology information of the BSP
+	cpu_t *bsp = cpu_get_bsp();
+	topology_init(bsp);
+	print_cpu_info(bsp);
 	
-			print_cpu_info(cpu);
-		}
-	}
+	/* bring up all of the APs */
+	smp_boot_all();
 
 	/* wait for all CPUs to be ready */
 	int ready;
@@ -141,16 +144,20 @@ void smp_init(void)
 
 void smp_ap_init(void)
 {
+	// Find the per-cpu data area of this AP; all APs are booted at the same time
+	cpu_t *cpu = cpu_get_by_lapic_id(apic_get_id());
+	if (!cpu)
+		halt_forever(); // Not listed in the ACPI tables
+	
 	/* save the per-cpu data area pointer so we can ack the SIPI straight away */
-	cpu_ap_install(booted_cpu);
+	cpu_ap_install(cpu);
+	rcu_cpu_online();
 
 	/* print a message to indicate the AP has been booted */
-	cpu_t *cpu = cpu_get();
 	print_cpu_info(cpu);
 
 	/* acknowledge the STARTUP IPI */
-	ack_sipi = true;
-	barrier();
+	__atomic_fetch_add(&acked_cpus, 1, __ATOMIC_RELEASE);
 
 	/* now start the real work! - set up the GDT, TSS, IDT and SYSCALL/RET */
 	gdt_init();
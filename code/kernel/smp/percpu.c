@@ -0,0 +1,18 @@
+
+#include <smp/percpu.h>
+#include <stdlib/stdlib.h>
+#include <stdlib/string.h>
+
+size_t percpu_size(void)
+{
+	return (size_t)(_percpu_end - _percpu_start);
+}
+
+void *percpu_alloc(void)
+{
+	// The bootstrap processor uses the section itself
+	void *area = memalign(64, percpu_size());
+	if(area)
+		memclr(area, percpu_size());
+	return area;
+}
@@ -0,0 +1,46 @@
+
+#ifndef _SMP_PERCPU_H
+#define _SMP_PERCPU_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-CPU variables: Variables declared with PERCPU are placed in the per-CPU section, which is copied for each CPU.
+// The copy of a CPU starts with its cpu_t, and its address is the CPU's GS base. The GS-relative offset of a variable
+// is thus the same on every CPU, so the copy of the current CPU can be accessed with a single instruction, without
+// disabling preemption or interrupts. Each copy is aligned to and padded to a multiple of the cache line size, so
+// different CPUs never share a cache line.
+//
+// Per-CPU variables are zero on all CPUs initially; initializers are not supported.
+#define PERCPU __attribute__((__section__(".percpu")))
+
+// Section boundaries, defined by the linker script.
+extern char _percpu_start[];
+extern char _percpu_end[];
+
+// Returns the GS-relative offset of the given per-CPU variable.
+#define percpu_offset(var) ((uintptr_t)&(var) - (uintptr_t)_percpu_start)
+
+// Returns a pointer to the copy of the given per-CPU variable belonging to the given cpu_t. Pass cpu_get() for the
+// current CPU; the caller is then responsible for not being migrated while using the pointer.
+#define per_cpu_ptr(var, cpu) ((__typeof__(&(var)))((uintptr_t)(cpu) + percpu_offset(var)))
+
+// Adds the given value to the current CPU's copy of the 64-bit variable at the given GS-relative offset.
+// This is a single instruction, so it is safe against interrupts and migration, but not against other CPUs.
+void percpu_add64(uintptr_t offset, uint64_t value);
+
+// Reads the current CPU's copy of the 64-bit variable at the given GS-relative offset.
+uint64_t percpu_read64(uintptr_t offset);
+
+// Shorthands for the above functions.
+#define this_cpu_add(var, value) percpu_add64(percpu_offset(var), (value))
+#define this_cpu_inc(var) percpu_add64(percpu_offset(var), 1)
+#define this_cpu_read(var) percpu_read64(percpu_offset(var))
+
+// Returns the size of the per-CPU area of each CPU.
+size_t percpu_size(void);
+
+// Allocates and clears the per-CPU area of an application processor. Its cpu_t is at the beginning.
+void *percpu_alloc(void);
+
+#endif
@@ -0,0 +1,13 @@
+; Access to per-CPU variables of the current CPU (see percpu.h).
+; The GS base points to the per-CPU area of the current CPU, so each access is a single GS-relative instruction and
+; the thread cannot be migrated in between.
+
+[global percpu_add64]
+percpu_add64:
+  add qword [gs:rdi], rsi
+  ret
+
+[global percpu_read64]
+percpu_read64:
+  mov rax, qword [gs:rdi]
+  ret
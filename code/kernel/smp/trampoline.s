@@ -12,6 +12,7 @@ EFER_NX equ 0x800
 
 ; CR0 bitmasks
 CR0_PE equ 0x1
+CR0_WP equ 0x10000
 CR0_PAGING equ 0x80000000
 
 ; CR4 bitmasks
@@ -72,9 +73,9 @@ code32:
 	mov eax, boot_pml4
 	mov cr3, eax
 
-	; enable paging (the BSP already identity-mapped us)
+	; enable paging (the BSP already identity-mapped us), with write protection as on the BSP
 	mov eax, cr0
-	or eax, CR0_PAGING
+	or eax, (CR0_PAGING + CR0_WP)
 	mov cr0, eax
 
 	; leave compatibility mode
@@ -99,9 +100,14 @@ code64:
 vcode64:
 
 	; set up the stack
+	; the APs are started in parallel, so each one claims the next entry of the stack table
 	mov rbp, 0x0 ; terminate stack traces here
-	mov rax, [qword trampoline_stack]
-	mov rsp, rax
+	mov rbx, qword trampoline_stack_index
+	mov rax, 1
+	lock xadd [rbx], rax
+	mov rbx, qword trampoline_stacks
+	mov rbx, [rbx]
+	mov rsp, [rbx + rax * 8]
 
 	; reset RFLAGS
 	push 0x0
@@ -162,8 +168,12 @@ align 16
 		dd 0
 		dd 0 ; so this is also a valid null idtr in long mode
 
-[global trampoline_stack]
-trampoline_stack: ; variable for storing the virtual address of the AP's bootstrap stack
+[global trampoline_stacks]
+trampoline_stacks: ; variable for storing the virtual address of the table of the APs' bootstrap stacks
+	dq 0
+
+[global trampoline_stack_index]
+trampoline_stack_index: ; index of the next unused entry of the stack table
 	dq 0
 
 [global trampoline_end]
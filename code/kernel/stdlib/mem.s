@@ -0,0 +1,215 @@
+; Memory copy and fill routines.
+; memcpy() and memset() choose their implementation depending on memFastStrings, which is set once at boot by
+; string_init():
+;     - FSRM (fast short REP MOVSB): REP MOVSB is fast for all sizes, so memcpy() always uses it.
+;     - ERMS (enhanced REP MOVSB/STOSB): REP MOVSB/STOSB is fast for larger sizes, but has a high startup cost.
+;     - Otherwise, and for small sizes with ERMS: REP MOVSQ/STOSQ for 8 bytes at a time, and the remainder bytewise.
+; memcpy_nt() and memclr_nt() use SSE2 non-temporal stores for large blocks, see memcpy_large() and memclr().
+
+[extern memFastStrings]
+
+; Flags of memFastStrings, must match string.c.
+STRING_ERMS equ 0x1
+STRING_FSRM equ 0x2
+
+; Minimum size for which REP MOVSB/STOSB is used with ERMS but without FSRM.
+STRING_ERMS_THRESHOLD equ 128
+
+; Page size for copy_page() and clear_page().
+STRING_PAGE_SIZE equ 4096
+
+; Copies memory, the areas must not overlap.
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Source.
+;     - rdx: Length.
+; Return value:
+;     - rax: Destination.
+[global memcpy]
+memcpy:
+	mov rax, rdi
+	mov rcx, rdx
+	movzx r8d, byte [rel memFastStrings]
+	test r8d, STRING_FSRM
+	jnz .bytes
+	cmp rdx, STRING_ERMS_THRESHOLD
+	jb .qwords
+	test r8d, STRING_ERMS
+	jnz .bytes
+.qwords:
+	shr rcx, 3
+	rep movsq
+	mov ecx, edx
+	and ecx, 7
+.bytes:
+	rep movsb
+	ret
+
+; memcpy() variant which always copies 8 bytes at a time. Same parameters.
+[global memcpy_qword]
+memcpy_qword:
+	mov rax, rdi
+	mov rcx, rdx
+	jmp memcpy.qwords
+
+; memcpy() variant which always uses REP MOVSB. Same parameters.
+[global memcpy_erms]
+memcpy_erms:
+	mov rax, rdi
+	mov rcx, rdx
+	rep movsb
+	ret
+
+; Fills memory with the given byte.
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Byte value.
+;     - rdx: Length.
+; Return value:
+;     - rax: Destination.
+[global memset]
+memset:
+	mov r9, rdi
+	movzx eax, sil
+	mov rcx, rdx
+	cmp rdx, STRING_ERMS_THRESHOLD
+	jb .qwords
+	test byte [rel memFastStrings], STRING_ERMS
+	jnz .bytes
+.qwords:
+	; replicate the byte into all 8 bytes of RAX
+	mov r8, 0x0101010101010101
+	imul rax, r8
+	shr rcx, 3
+	rep stosq
+	mov ecx, edx
+	and ecx, 7
+.bytes:
+	rep stosb
+	mov rax, r9
+	ret
+
+; memset() variant which always fills 8 bytes at a time. Same parameters.
+[global memset_qword]
+memset_qword:
+	mov r9, rdi
+	movzx eax, sil
+	mov rcx, rdx
+	jmp memset.qwords
+
+; memset() variant which always uses REP STOSB. Same parameters.
+[global memset_erms]
+memset_erms:
+	mov r9, rdi
+	movzx eax, sil
+	mov rcx, rdx
+	jmp memset.bytes
+
+; Copies a page-aligned 4K page.
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Source.
+[global copy_page]
+copy_page:
+	mov ecx, STRING_PAGE_SIZE / 8
+	rep movsq
+	ret
+
+; Zeroes a page-aligned 4K page.
+; Parameters:
+;     - rdi: Page.
+[global clear_page]
+clear_page:
+	xor eax, eax
+	mov ecx, STRING_PAGE_SIZE / 8
+	rep stosq
+	ret
+
+; Copies memory using non-temporal stores, which bypass the caches. Only for large blocks which are not read again
+; soon, and only between kernel_fpu_begin() and kernel_fpu_end().
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Source.
+;     - rdx: Length.
+; Return value:
+;     - rax: Destination.
+[global memcpy_nt]
+memcpy_nt:
+	mov rax, rdi
+	
+	; copy bytewise up to the next 16 byte boundary of the destination
+	mov rcx, rdi
+	neg rcx
+	and ecx, 15
+	cmp rcx, rdx
+	cmova rcx, rdx
+	sub rdx, rcx
+	rep movsb
+	
+	; copy 64 bytes at a time
+	mov rcx, rdx
+	shr rcx, 6
+	jz .tail
+.loop:
+	movdqu xmm0, [rsi]
+	movdqu xmm1, [rsi + 16]
+	movdqu xmm2, [rsi + 32]
+	movdqu xmm3, [rsi + 48]
+	movntdq [rdi], xmm0
+	movntdq [rdi + 16], xmm1
+	movntdq [rdi + 32], xmm2
+	movntdq [rdi + 48], xmm3
+	add rsi, 64
+	add rdi, 64
+	dec rcx
+	jnz .loop
+	
+	; order the non-temporal stores before subsequent ones
+	sfence
+.tail:
+	mov ecx, edx
+	and ecx, 63
+	rep movsb
+	ret
+
+; Zeroes memory using non-temporal stores, see memcpy_nt().
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Length.
+; Return value:
+;     - rax: Destination.
+[global memclr_nt]
+memclr_nt:
+	mov r9, rdi
+	mov rdx, rsi
+	xor eax, eax
+	
+	; clear bytewise up to the next 16 byte boundary
+	mov rcx, rdi
+	neg rcx
+	and ecx, 15
+	cmp rcx, rdx
+	cmova rcx, rdx
+	sub rdx, rcx
+	rep stosb
+	
+	; clear 64 bytes at a time
+	mov rcx, rdx
+	shr rcx, 6
+	jz .tail
+	pxor xmm0, xmm0
+.loop:
+	movntdq [rdi], xmm0
+	movntdq [rdi + 16], xmm0
+	movntdq [rdi + 32], xmm0
+	movntdq [rdi + 48], xmm0
+	add rdi, 64
+	dec rcx
+	jnz .loop
+	sfence
+.tail:
+	mov ecx, edx
+	and ecx, 63
+	rep stosb
+	mov rax, r9
+	ret
@@ -0,0 +1,113 @@
+
+#include <stdlib/membench.h>
+#include <stdlib/string.h>
+#include <stdlib/stdlib.h>
+#include <cpu/tsc.h>
+#include <cpu/fpu.h>
+#include <lock/intr.h>
+#include <stdbool.h>
+
+// Measured sizes; the buffers are large enough to keep the largest size out of the caches of most cores.
+static const uint64_t memBenchSizes[] = { 64, 1024, 64 * 1024, 1024 * 1024 };
+#define MEM_BENCH_SIZE_COUNT (int)(sizeof(memBenchSizes) / sizeof(*memBenchSizes))
+#define MEM_BENCH_BUFFER_SIZE (1024 * 1024 + 4096)
+
+// Page size of copy_page() and clear_page().
+#define MEM_BENCH_PAGE_SIZE 4096
+
+// Calls the given routine once.
+static void mem_bench_call(mem_bench_routine_t routine, uint8_t *dst, uint8_t *src, uint64_t size)
+{
+	switch(routine)
+	{
+		case MEM_BENCH_MEMCPY: memcpy(dst, src, size); break;
+		case MEM_BENCH_MEMCPY_QWORD: memcpy_qword(dst, src, size); break;
+		case MEM_BENCH_MEMCPY_ERMS: memcpy_erms(dst, src, size); break;
+		case MEM_BENCH_MEMSET: memset(dst, 0x5A, size); break;
+		case MEM_BENCH_MEMSET_QWORD: memset_qword(dst, 0x5A, size); break;
+		case MEM_BENCH_MEMSET_ERMS: memset_erms(dst, 0x5A, size); break;
+		case MEM_BENCH_MEMMOVE: memmove(dst + 8, dst, size); break;
+		case MEM_BENCH_COPY_PAGE: copy_page(dst, src); break;
+		case MEM_BENCH_CLEAR_PAGE: clear_page(dst); break;
+		case MEM_BENCH_MEMCPY_NT:
+		case MEM_BENCH_MEMCLR_NT:
+		{
+			if(!kernel_fpu_begin())
+				break;
+			if(routine == MEM_BENCH_MEMCPY_NT)
+				memcpy_nt(dst, src, size);
+			else
+				memclr_nt(dst, size);
+			kernel_fpu_end();
+			break;
+		}
+		default: break;
+	}
+}
+
+// Measures one routine with one size.
+static void mem_bench_measure(mem_bench_routine_t routine, uint8_t *dst, uint8_t *src, uint64_t size, int iterations, mem_bench_result_t *result)
+{
+	// Warm up caches and TLB
+	mem_bench_call(routine, dst, src, size);
+	
+	uint64_t minCycles = UINT64_MAX;
+	uint64_t totalCycles = 0;
+	for(int i = 0; i < iterations; ++i)
+	{
+		// Interrupts would distort single measurements
+		intr_lock();
+		uint64_t start = tsc_read();
+		mem_bench_call(routine, dst, src, size);
+		uint64_t cycles = tsc_read() - start;
+		intr_unlock();
+		
+		if(cycles < minCycles)
+			minCycles = cycles;
+		totalCycles += cycles;
+	}
+	
+	result->routine = routine;
+	result->size = size;
+	result->minCycles = minCycles;
+	result->avgCycles = totalCycles / iterations;
+}
+
+int mem_bench_run(int iterations, mem_bench_result_t *results, int maxCount)
+{
+	if(iterations <= 0)
+		iterations = 1;
+	
+	// Page aligned, so copy_page() and clear_page() can use the same buffers
+	uint8_t *src = memalign(MEM_BENCH_PAGE_SIZE, MEM_BENCH_BUFFER_SIZE);
+	uint8_t *dst = memalign(MEM_BENCH_PAGE_SIZE, MEM_BENCH_BUFFER_SIZE);
+	if(!src || !dst)
+	{
+		free(src);
+		free(dst);
+		return -1;
+	}
+	memset(src, 0xA5, MEM_BENCH_BUFFER_SIZE);
+	memset(dst, 0, MEM_BENCH_BUFFER_SIZE);
+	
+	int count = 0;
+	for(int r = 0; r < MEM_BENCH_ROUTINE_COUNT; ++r)
+	{
+		bool pageRoutine = (r == MEM_BENCH_COPY_PAGE || r == MEM_BENCH_CLEAR_PAGE);
+		for(int s = 0; s < MEM_BENCH_SIZE_COUNT && count < maxCount; ++s)
+		{
+			uint64_t size = memBenchSizes[s];
+			if(pageRoutine)
+			{
+				if(s > 0)
+					break;
+				size = MEM_BENCH_PAGE_SIZE;
+			}
+			mem_bench_measure(r, dst, src, size, iterations, &results[count++]);
+		}
+	}
+	
+	free(src);
+	free(dst);
+	return count;
+}
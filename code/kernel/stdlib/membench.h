@@ -0,0 +1,64 @@
+
+#ifndef _STDLIB_MEMBENCH_H
+#define _STDLIB_MEMBENCH_H
+
+#include <stdint.h>
+
+// Memory routines compared by the memory benchmark.
+typedef enum
+{
+	// memcpy() with the implementation selected at boot.
+	MEM_BENCH_MEMCPY = 0,
+	
+	// memcpy() copying 8 bytes at a time.
+	MEM_BENCH_MEMCPY_QWORD = 1,
+	
+	// memcpy() using REP MOVSB.
+	MEM_BENCH_MEMCPY_ERMS = 2,
+	
+	// memset() with the implementation selected at boot.
+	MEM_BENCH_MEMSET = 3,
+	
+	// memset() filling 8 bytes at a time.
+	MEM_BENCH_MEMSET_QWORD = 4,
+	
+	// memset() using REP STOSB.
+	MEM_BENCH_MEMSET_ERMS = 5,
+	
+	// memmove() with overlapping areas, copying backwards.
+	MEM_BENCH_MEMMOVE = 6,
+	
+	// copy_page() and clear_page(), only measured for the page size.
+	MEM_BENCH_COPY_PAGE = 7,
+	MEM_BENCH_CLEAR_PAGE = 8,
+	
+	// memcpy() and memclr() with SSE2 non-temporal stores, including kernel_fpu_begin() and kernel_fpu_end().
+	MEM_BENCH_MEMCPY_NT = 9,
+	MEM_BENCH_MEMCLR_NT = 10,
+	
+	MEM_BENCH_ROUTINE_COUNT
+} mem_bench_routine_t;
+
+// Maximum number of results of a benchmark run.
+#define MEM_BENCH_MAX_RESULTS 64
+
+// Result of the memory benchmark for one routine and size.
+typedef struct
+{
+	int routine;
+	
+	// Number of bytes per call.
+	uint64_t size;
+	
+	// Minimum time of a call over all repetitions, in TSC ticks.
+	uint64_t minCycles;
+	
+	// Average time of a call, in TSC ticks.
+	uint64_t avgCycles;
+} mem_bench_result_t;
+
+// Measures the kernel memory routines for small, medium and large sizes with the given number of repetitions per size.
+// Returns the number of results written, or -1 if the buffers could not be allocated.
+int mem_bench_run(int iterations, mem_bench_result_t *results, int maxCount);
+
+#endif
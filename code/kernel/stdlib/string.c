@@ -1,5 +1,30 @@
 
 #include <stdlib/string.h>
+#include <cpu/features.h>
+#include <cpu/fpu.h>
+
+/* flags of memFastStrings, must match mem.s */
+#define STRING_ERMS 0x1
+#define STRING_FSRM 0x2
+
+/* minimum size for which memcpy_large() and memclr() use non-temporal stores */
+#define STRING_NT_THRESHOLD (256 * 1024)
+
+/* fast string instructions supported by the CPU, read by memcpy() and memset() */
+uint8_t memFastStrings = 0;
+
+/* 8 byte words which may alias other types, for memmove() */
+typedef uint64_t __attribute__((__may_alias__)) string_word_t;
+
+void string_init(void)
+{
+  uint8_t flags = 0;
+  if (cpu_feature_supported(FEATURE_ERMS))
+    flags |= STRING_ERMS;
+  if (cpu_feature_supported(FEATURE_FSRM))
+    flags |= STRING_FSRM;
+  memFastStrings = flags;
+}
 
 int strcmp(const char *str1, const char *str2)
 {
@@ -15,18 +40,6 @@ int strcmp(const char *str1, const char *str2)
   return *s1 - *s2;
 }
 
-void *memset(void *ptr, int value, size_t len)
-{
-  // TODO: volatile is a hacky workaround, gcc 4.8.0 at -O3 seems to optimize
-  // away most of the code here...
-  volatile char *ptr8 = (volatile char *) ptr;
-
-  while (len--)
-    *ptr8++ = value;
-
-  return ptr;
-}
-
 void *memmove(void *dst, const void *src, size_t len)
 {
   if (src == dst)
@@ -35,11 +48,25 @@ void *memmove(void *dst, const void *src, size_t len)
   const void *src_end = (const void *) ((uintptr_t) src + len);
   if (src < dst && dst < src_end)
   {
+    /*
+     * copy backwards, the tail bytewise and then 8 bytes at a time; each word
+     * is read before the overlapping part of it is overwritten
+     */
     char *dst8 = (char *) dst;
     const char *src8 = (const char *) src;
+    size_t i = len;
 
-    for (ptrdiff_t i = len - 1; i >= 0; i--)
+    while (i % sizeof(string_word_t))
+    {
+      i--;
       dst8[i] = src8[i];
+    }
+
+    while (i)
+    {
+      i -= sizeof(string_word_t);
+      *(string_word_t *) &dst8[i] = *(const string_word_t *) &src8[i];
+    }
 
     return dst;
   }
@@ -47,17 +74,6 @@ void *memmove(void *dst, const void *src, size_t len)
   return memcpy(dst, src, len);
 }
 
-void *memcpy(void *dst, const void *src, size_t len)
-{
-  char *dst8 = (char *) dst;
-  const char *src8 = (char *) src;
-
-  while (len--)
-    *dst8++ = *src8++;
-
-  return dst;
-}
-
 int memcmp(const void *ptr1, const void *ptr2, size_t len)
 {
   const unsigned char *p1 = (const unsigned char *) ptr1;
@@ -78,9 +94,26 @@ int memcmp(const void *ptr1, const void *ptr2, size_t len)
 
 void *memclr(void *ptr, size_t len)
 {
+  if (len >= STRING_NT_THRESHOLD && kernel_fpu_begin())
+  {
+    memclr_nt(ptr, len);
+    kernel_fpu_end();
+    return ptr;
+  }
   return memset(ptr, 0, len);
 }
 
+void *memcpy_large(void *dst, const void *src, size_t len)
+{
+  if (len >= STRING_NT_THRESHOLD && kernel_fpu_begin())
+  {
+    memcpy_nt(dst, src, len);
+    kernel_fpu_end();
+    return dst;
+  }
+  return memcpy(dst, src, len);
+}
+
 char *itoa(uint64_t value, char *str, int base)
 {
 	// Only support bases {0, 1} till {0, ..., 9, A, ..., Z}
@@ -13,6 +13,37 @@ void *memcpy(void *dst, const void *src, size_t len);
 void *memmove(void *dst, const void *src, size_t len);
 int memcmp(const void *ptr1, const void *ptr2, size_t len);
 
+/*
+ * memcpy() and memset() are implemented in mem.s and use REP MOVSB/STOSB if
+ * the CPU supports fast string operations; string_init() selects the variant
+ * once at boot, before that the 8 byte variants are used
+ */
+void string_init(void);
+
+/* fixed variants of memcpy() and memset(), for benchmarks */
+void *memcpy_qword(void *dst, const void *src, size_t len);
+void *memcpy_erms(void *dst, const void *src, size_t len);
+void *memset_qword(void *ptr, int value, size_t len);
+void *memset_erms(void *ptr, int value, size_t len);
+
+/*
+ * SSE2 variants of memcpy() and memclr() with non-temporal stores, only valid
+ * between kernel_fpu_begin() and kernel_fpu_end()
+ */
+void *memcpy_nt(void *dst, const void *src, size_t len);
+void *memclr_nt(void *ptr, size_t len);
+
+/*
+ * memcpy() for large blocks which are not read again soon, e.g. into video
+ * memory; uses memcpy_nt() where possible. memclr() does the same for large
+ * blocks
+ */
+void *memcpy_large(void *dst, const void *src, size_t len);
+
+/* copy and clear a page-aligned 4K page */
+void copy_page(void *dst, const void *src);
+void clear_page(void *page);
+
 char *strncpy(char *dest, const char *src, int n);
 char *strcpy(char *dest, const char *src);
 char *itoa(uint64_t value, char *str, int base);
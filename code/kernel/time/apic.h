@@ -8,4 +8,7 @@
 void apic_timer_install_handler(intr_handler_t handler);
 void apic_monotonic(int ms);
 
+// Masks the timer interrupt of the current CPU, until apic_monotonic() is called again.
+void apic_timer_stop(void);
+
 #endif
@@ -0,0 +1,81 @@
+
+#include <trace/kstat.h>
+#include <lock/spinlock.h>
+#include <smp/cpu.h>
+#include <util/container.h>
+#include <stdlib/string.h>
+
+// Registered statistics, in registration order.
+static kstat_t *kstatFirst = 0;
+static kstat_t *kstatLast = 0;
+static int kstatCount = 0;
+static spinlock_t kstatLock = SPIN_UNLOCKED;
+
+void kstat_register(kstat_t *stat)
+{
+	spin_lock(&kstatLock);
+	if(!stat->registered && kstatCount < KSTAT_MAX_COUNT)
+	{
+		stat->next = 0;
+		if(kstatLast)
+			kstatLast->next = stat;
+		else
+			kstatFirst = stat;
+		kstatLast = stat;
+		stat->registered = true;
+		++kstatCount;
+	}
+	spin_unlock(&kstatLock);
+}
+
+// Returns the GS-relative offset of the given value of a statistic.
+static uintptr_t kstat_offset(kstat_t *stat, int index)
+{
+	return (uintptr_t)&stat->values[index] - (uintptr_t)_percpu_start;
+}
+
+void kstat_add(kstat_t *stat, uint64_t value)
+{
+	percpu_add64(kstat_offset(stat, 0), value);
+}
+
+void kstat_inc(kstat_t *stat)
+{
+	percpu_add64(kstat_offset(stat, 0), 1);
+}
+
+void kstat_record(kstat_t *stat, uint64_t value)
+{
+	int bucket = (value ? 63 - __builtin_clzll(value) : 0);
+	if(bucket >= KSTAT_HISTOGRAM_BUCKETS)
+		bucket = KSTAT_HISTOGRAM_BUCKETS - 1;
+	percpu_add64(kstat_offset(stat, bucket), 1);
+}
+
+int kstat_get(kstat_info_t *infos, int maxCount)
+{
+	// Statistics are never unregistered, so the list can be walked without the lock up to the current count
+	spin_lock(&kstatLock);
+	kstat_t *stat = kstatFirst;
+	int available = kstatCount;
+	spin_unlock(&kstatLock);
+	
+	int count = 0;
+	for(; stat && count < available && count < maxCount; stat = stat->next)
+	{
+		kstat_info_t *info = &infos[count++];
+		memclr(info, sizeof(kstat_info_t));
+		strncpy(info->name, stat->name, KSTAT_NAME_LENGTH - 1);
+		info->type = stat->type;
+		
+		// Sum up the values of all CPUs
+		int valueCount = (stat->type == KSTAT_TYPE_HISTOGRAM ? KSTAT_HISTOGRAM_BUCKETS : 1);
+		list_for_each(&cpu_list, node)
+		{
+			cpu_t *cpu = container_of(node, cpu_t, node);
+			for(int v = 0; v < valueCount; ++v)
+				info->values[v] += __atomic_load_n((uint64_t *)((uintptr_t)cpu + kstat_offset(stat, v)), __ATOMIC_RELAXED);
+		}
+	}
+	return count;
+}
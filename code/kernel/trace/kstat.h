@@ -0,0 +1,84 @@
+
+#ifndef _TRACE_KSTAT_H
+#define _TRACE_KSTAT_H
+
+#include <smp/percpu.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Kernel statistics: Named counters and histograms which subsystems register once and then update cheaply. Values are
+// kept per CPU (see percpu.h), so updating them is a single non-atomic instruction and does not bounce cache lines;
+// readers sum up the values of all CPUs.
+//
+// Usage:
+//     KSTAT_COUNTER(pmmAllocs, "pmm.allocs");
+//     ...
+//     kstat_register(&pmmAllocs);  // in the subsystem's init function
+//     ...
+//     kstat_inc(&pmmAllocs);
+
+// Number of buckets of a histogram. Bucket i counts values in [2^i, 2^(i+1)), bucket 0 also contains 0.
+#define KSTAT_HISTOGRAM_BUCKETS 32
+
+// Maximum number of registered statistics, and maximum name length including terminating 0.
+#define KSTAT_MAX_COUNT 64
+#define KSTAT_NAME_LENGTH 32
+
+// Statistic types.
+typedef enum
+{
+	KSTAT_TYPE_COUNTER = 0,
+	KSTAT_TYPE_HISTOGRAM = 1,
+} kstat_type_t;
+
+// A registered statistic.
+typedef struct kstat
+{
+	const char *name;
+	kstat_type_t type;
+	
+	// Per-CPU values: A single uint64_t for counters, KSTAT_HISTOGRAM_BUCKETS of them for histograms.
+	uint64_t *values;
+	
+	// Next registered statistic.
+	struct kstat *next;
+	bool registered;
+} kstat_t;
+
+// Defines a static counter with the given identifier and name.
+#define KSTAT_COUNTER(ident, statName) \
+	static uint64_t ident##Values PERCPU; \
+	static kstat_t ident = { .name = statName, .type = KSTAT_TYPE_COUNTER, .values = &ident##Values }
+
+// Defines a static histogram with the given identifier and name.
+#define KSTAT_HISTOGRAM(ident, statName) \
+	static uint64_t ident##Values[KSTAT_HISTOGRAM_BUCKETS] PERCPU; \
+	static kstat_t ident = { .name = statName, .type = KSTAT_TYPE_HISTOGRAM, .values = ident##Values }
+
+// Snapshot of a statistic, summed over all CPUs.
+typedef struct
+{
+	char name[KSTAT_NAME_LENGTH];
+	uint32_t type;
+	
+	// Counter value in values[0], or histogram buckets.
+	uint64_t values[KSTAT_HISTOGRAM_BUCKETS];
+} kstat_info_t;
+
+// Makes the given statistic visible to kstat_get(). Statistics can be updated before they are registered.
+void kstat_register(kstat_t *stat);
+
+// Adds the given value to a counter.
+void kstat_add(kstat_t *stat, uint64_t value);
+
+// Increments a counter.
+void kstat_inc(kstat_t *stat);
+
+// Counts the given value in the matching bucket of a histogram.
+void kstat_record(kstat_t *stat, uint64_t value);
+
+// Copies snapshots of up to maxCount registered statistics into the given buffer, in registration order. Returns the
+// number of statistics written.
+int kstat_get(kstat_info_t *infos, int maxCount);
+
+#endif
@@ -14,28 +14,34 @@ static size_t strtabsz;
 static elf64_sym_t *symtab; // TODO as above
 static size_t symtabsz;
 
-#if defined(__OPTIMIZE__)
-/* not used when optimizations enabled - see below */
-static const char *stacktrace_lookup_sym(uint64_t rip) __attribute__((__unused__));
-#endif
-
-static const char *stacktrace_lookup_sym(uint64_t rip)
+static const char *stacktrace_lookup(uint64_t addr, int type)
 {
   if (strtab && symtab)
   {
     elf64_sym_t *sym = symtab;
     for (size_t i = 0; i < (symtabsz / sizeof(*symtab)); i++, sym++)
     {
-      if (ELF64_ST_TYPE(sym->st_info) != STT_FUNC)
+      if (ELF64_ST_TYPE(sym->st_info) != type)
         continue;
 
-      uint64_t addr = (uint64_t) sym->st_value;
-      if (rip >= addr && rip < (addr + sym->st_size))
+      uint64_t start = (uint64_t) sym->st_value;
+      if (addr >= start && addr < (start + sym->st_size))
         return (const char *) (strtab + sym->st_name);
     }
   }
 
-  return "<unknown>";
+  return 0;
+}
+
+const char *stacktrace_lookup_sym(uint64_t rip)
+{
+  const char *name = stacktrace_lookup(rip, STT_FUNC);
+  return name ? name : "<unknown>";
+}
+
+const char *stacktrace_lookup_object(uint64_t addr)
+{
+  return stacktrace_lookup(addr, STT_OBJECT);
 }
 
 void stacktrace_init(multiboot_t *multiboot)
@@ -85,3 +91,19 @@ void stacktrace_emit(void)
   }
 #endif
 }
+
+size_t stacktrace_collect(uint64_t *rbp, uint64_t *rips, size_t count)
+{
+#if defined(__OPTIMIZE__)
+  /* see stacktrace_emit() */
+  return 0;
+#else
+  size_t n = 0;
+  while (rbp && n < count)
+  {
+    rips[n++] = rbp[1];
+    rbp = (uint64_t *) rbp[0];
+  }
+  return n;
+#endif
+}
@@ -3,8 +3,22 @@
 #define _STACKTRACE_H
 
 #include <init/multiboot.h>
+#include <stddef.h>
+#include <stdint.h>
 
 void stacktrace_init(multiboot_t *multiboot);
 void stacktrace_emit(void);
 
+/* returns the name of the function containing rip, or "<unknown>" */
+const char *stacktrace_lookup_sym(uint64_t rip);
+
+/* returns the name of the global variable containing addr, or NULL */
+const char *stacktrace_lookup_object(uint64_t addr);
+
+/*
+ * follows the frame pointer chain starting at rbp and stores up to count
+ * return addresses; returns 0 if frame pointers are unavailable
+ */
+size_t stacktrace_collect(uint64_t *rbp, uint64_t *rips, size_t count);
+
 #endif
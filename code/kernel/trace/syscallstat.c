@@ -0,0 +1,94 @@
+#include <trace/syscallstat.h>
+#include <cpu/tsc.h>
+#include <proc/proc.h>
+#include <proc/syscall.h>
+#include <stdlib/stdlib.h>
+#include <stdlib/string.h>
+
+volatile bool syscallstatEnabled = false;
+
+void syscallstat_enable(bool enable, bool reset)
+{
+	// Stop first, so the reset is not mixed with new calls of this core
+	if(!enable)
+		syscallstatEnabled = false;
+	if(reset)
+		proc_clear_syscall_stats();
+	if(enable)
+		syscallstatEnabled = true;
+}
+
+// Returns the statistics table of the current process, which is allocated on first use. Returns 0 if the allocation
+// fails.
+static syscallstat_entry_t *syscallstat_get_table(void)
+{
+	proc_t *proc = proc_get();
+	syscallstat_entry_t *table = __atomic_load_n(&proc->syscallStats, __ATOMIC_ACQUIRE);
+	if(table)
+		return table;
+
+	// Another thread of the process may be faster
+	table = calloc(syscall_table_size, sizeof(syscallstat_entry_t));
+	if(!table)
+		return 0;
+	syscallstat_entry_t *expected = 0;
+	if(!__atomic_compare_exchange_n(&proc->syscallStats, &expected, table, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+		free(table);
+		table = expected;
+	}
+	return table;
+}
+
+void syscallstat_record(uint64_t syscall, uint64_t startTsc)
+{
+	uint64_t cycles = tsc_read() - startTsc;
+	syscallstat_entry_t *table = syscallstat_get_table();
+	if(!table)
+		return;
+
+	// Threads of the process may run on several cores
+	syscallstat_entry_t *entry = &table[syscall];
+	int bucket = (cycles ? 63 - __builtin_clzll(cycles) : 0);
+	if(bucket >= SYSCALLSTAT_HISTOGRAM_BUCKETS)
+		bucket = SYSCALLSTAT_HISTOGRAM_BUCKETS - 1;
+	__atomic_fetch_add(&entry->calls, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&entry->cycles, cycles, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&entry->histogram[bucket], 1, __ATOMIC_RELAXED);
+}
+
+void syscallstat_count(uint64_t syscall)
+{
+	syscallstat_entry_t *table = syscallstat_get_table();
+	if(table)
+		__atomic_fetch_add(&table[syscall].calls, 1, __ATOMIC_RELAXED);
+}
+
+int syscallstat_collect(proc_t *proc, syscallstat_info_t *infos, int maxCount)
+{
+	syscallstat_entry_t *table = __atomic_load_n(&proc->syscallStats, __ATOMIC_ACQUIRE);
+	if(!table)
+		return 0;
+
+	int count = 0;
+	for(uint64_t s = 0; s < syscall_table_size && count < maxCount; ++s)
+	{
+		if(table[s].calls == 0)
+			continue;
+
+		syscallstat_info_t *info = &infos[count++];
+		memclr(info, sizeof(syscallstat_info_t));
+		strncpy(info->processName, proc->name, sizeof(info->processName) - 1);
+		info->syscall = (uint32_t)s;
+		info->stats = table[s];
+	}
+	return count;
+}
+
+void syscallstat_clear(proc_t *proc)
+{
+	// Concurrent updates may survive partially, which is fine for statistics
+	syscallstat_entry_t *table = __atomic_load_n(&proc->syscallStats, __ATOMIC_ACQUIRE);
+	if(table)
+		memclr(table, syscall_table_size * sizeof(syscallstat_entry_t));
+}
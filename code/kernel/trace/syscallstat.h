@@ -0,0 +1,56 @@
+#ifndef _TRACE_SYSCALLSTAT_H
+#define _TRACE_SYSCALLSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// System call statistics: Per process and system call number, syscall_stub() counts the calls and records their
+// duration in TSC cycles, including the time a call spends blocked or preempted. Recording is switched on and off at
+// runtime; while it is off, the stub only checks syscallstatEnabled.
+// The exit calls which go through the faux interrupt path do not return to the stub, so they are only counted.
+
+// Number of histogram buckets. Bucket i counts durations in [2^i, 2^(i+1)) cycles, bucket 0 also contains 0.
+#define SYSCALLSTAT_HISTOGRAM_BUCKETS 32
+
+// Statistics of one system call number.
+typedef struct
+{
+	uint64_t calls;
+	uint64_t cycles;
+	uint64_t histogram[SYSCALLSTAT_HISTOGRAM_BUCKETS];
+} syscallstat_entry_t;
+
+// Snapshot of the statistics of one system call number of one process.
+typedef struct
+{
+	char processName[32];
+	uint32_t syscall;
+	uint32_t reserved;
+	syscallstat_entry_t stats;
+} syscallstat_info_t;
+
+// Maximum number of snapshots returned by a single query.
+#define SYSCALLSTAT_MAX_INFO_COUNT 512
+
+struct proc;
+
+// Determines whether the system call stub records statistics. Read by syscall_stub().
+extern volatile bool syscallstatEnabled;
+
+// Switches recording on or off. If reset is set, the statistics collected so far are discarded.
+void syscallstat_enable(bool enable, bool reset);
+
+// Records a returned call of the given system call, which started at the given time stamp. Called by syscall_stub().
+void syscallstat_record(uint64_t syscall, uint64_t startTsc);
+
+// Counts a call of the given system call without measuring its duration. Called by syscall_stub().
+void syscallstat_count(uint64_t syscall);
+
+// Copies snapshots of the used system calls of the given process into the given buffer. Returns the number of entries
+// written.
+int syscallstat_collect(struct proc *proc, syscallstat_info_t *infos, int maxCount);
+
+// Discards the statistics of the given process.
+void syscallstat_clear(struct proc *proc);
+
+#endif
@@ -0,0 +1,71 @@
+; SSE2 routines for the VBE back buffers (see vbe.c). They may only be called between kernel_fpu_begin() and
+; kernel_fpu_end(). Pixels are 32-bit values, the buffers need not be aligned.
+
+; Transfers the changed pixels of a row from the current buffer to the previous buffer and video memory. Four pixels
+; are compared at a time; if any of them changed, all four are written, which keeps unchanged pixels as they are.
+; Parameters:
+;     - rdi: Row in video memory.
+;     - rsi: Row in the current buffer.
+;     - rdx: Row in the previous buffer.
+;     - rcx: Number of pixels.
+[global vbe_simd_blit_row]
+vbe_simd_blit_row:
+	mov r8, rcx
+	shr r8, 2
+	jz .tail
+.vector:
+	movdqu xmm0, [rsi]
+	movdqu xmm1, [rdx]
+	pcmpeqd xmm1, xmm0
+	pmovmskb eax, xmm1
+	cmp eax, 0xFFFF
+	je .vector_next
+	movdqu [rdx], xmm0
+	movdqu [rdi], xmm0
+.vector_next:
+	add rdi, 16
+	add rsi, 16
+	add rdx, 16
+	dec r8
+	jnz .vector
+.tail:
+	and ecx, 3
+	jz .done
+.scalar:
+	mov eax, [rsi]
+	cmp eax, [rdx]
+	je .scalar_next
+	mov [rdx], eax
+	mov [rdi], eax
+.scalar_next:
+	add rdi, 4
+	add rsi, 4
+	add rdx, 4
+	dec ecx
+	jnz .scalar
+.done:
+	ret
+
+; Fills a row with the given color.
+; Parameters:
+;     - rdi: Row.
+;     - rsi: Color.
+;     - rdx: Number of pixels.
+[global vbe_simd_fill_row]
+vbe_simd_fill_row:
+	movd xmm0, esi
+	pshufd xmm0, xmm0, 0
+	mov rcx, rdx
+	shr rcx, 2
+	jz .tail
+.vector:
+	movdqu [rdi], xmm0
+	add rdi, 16
+	dec rcx
+	jnz .vector
+.tail:
+	mov ecx, edx
+	and ecx, 3
+	mov eax, esi
+	rep stosd
+	ret
@@ -5,6 +5,7 @@
 #include <mm/heap.h>
 #include <panic/panic.h>
 #include <lock/spinlock.h>
+#include <cpu/fpu.h>
 #include <stdlib/string.h>
 
 
@@ -46,6 +47,17 @@ static uint32_t *renderBuffer;
 static vbe_context_t contexts[VBE_CONTEXT_COUNT];
 static int currentContext = 0;
 
+// Number of rows after which a blit briefly releases the context lock.
+#define VBE_BLIT_PREEMPT_ROWS 64
+
+// Minimum number of pixels for which blits and fills use vector instructions. Smaller areas do not pay off the saving
+// and restoring of the user's vector registers.
+#define VBE_SIMD_MIN_PIXELS 1024
+
+// Assembly implementations (simd.s).
+void vbe_simd_blit_row(uint32_t *renderRow, uint32_t *currentRow, uint32_t *previousRow, uint64_t count);
+void vbe_simd_fill_row(uint32_t *row, uint32_t color, uint64_t count);
+
 // Back buffers of the current drawing context.
 static uint32_t *previousBuffer; // Holds the previously rendered image
 static uint32_t *currentBuffer; // Holds the current image
@@ -100,25 +112,47 @@ static void _vbe_blit_to_video_memory(int contextId, uint32_t posX, uint32_t pos
 	// Run through rectangle pixels
 	uint32_t xSteps = renderBufferXMax - renderBufferX;
 	uint32_t ySteps = renderBufferYMax - renderBufferY;
+	bool simd = (xSteps * ySteps >= VBE_SIMD_MIN_PIXELS && kernel_fpu_begin());
 	for(uint32_t y = 0; y < ySteps; ++y)
 	{
 		uint32_t *pixelRenderBuffer = renderBuffer + (renderBufferY + y) * renderBufferWidth + renderBufferX;
 		uint32_t *pixelCurrent = currentBuffer + (posY + y) * renderBufferWidth + renderBufferX;
 		uint32_t *pixelPrevious = previousBuffer + (renderBufferY + y) * renderBufferWidth + renderBufferX;
-		for(uint32_t x = 0; x < xSteps; ++x)
+		if(simd)
+			vbe_simd_blit_row(pixelRenderBuffer, pixelCurrent, pixelPrevious, xSteps);
+		else
 		{
-			// Transfer pixel only when it was changed
-			uint32_t pixelCurrentVal = *pixelCurrent;
-			if(*pixelPrevious != pixelCurrentVal)
+			for(uint32_t x = 0; x < xSteps; ++x)
 			{
-				*pixelPrevious = pixelCurrentVal;
-				*pixelRenderBuffer = pixelCurrentVal;
+				// Transfer pixel only when it was changed
+				uint32_t pixelCurrentVal = *pixelCurrent;
+				if(*pixelPrevious != pixelCurrentVal)
+				{
+					*pixelPrevious = pixelCurrentVal;
+					*pixelRenderBuffer = pixelCurrentVal;
+				}
+				++pixelRenderBuffer;
+				++pixelCurrent;
+				++pixelPrevious;
 			}
-			++pixelRenderBuffer;
-			++pixelCurrent;
-			++pixelPrevious;
+		}
+		
+		// Large blits should not block interrupts; stop if the displayed context or its scroll position was changed
+		// meanwhile, as this redraws the entire screen anyway
+		if((y + 1) % VBE_BLIT_PREEMPT_ROWS == 0)
+		{
+			// The vector section disables preemption, so it is left while the lock is released
+			if(simd)
+				kernel_fpu_end();
+			spin_preempt_point(&vbeContextLock);
+			simd = false;
+			if(contextId != currentContext || scrollY != posY - renderBufferY)
+				break;
+			simd = kernel_fpu_begin();
 		}
 	}
+	if(simd)
+		kernel_fpu_end();
 	
 	spin_unlock(&vbeContextLock);
 }
@@ -164,6 +198,34 @@ int vbe_create_context()
 	return -1;
 }
 
+void vbe_destroy_context(int contextId)
+{
+	// The kernel context and the displayed context are kept
+	if(contextId <= VBE_KERNEL_CONTEXT || contextId >= VBE_CONTEXT_COUNT)
+		return;
+	
+	spin_lock(&vbeContextLock);
+	
+	vbe_context_t *context = &contexts[contextId];
+	if(!context->inUse || contextId == currentContext)
+	{
+		spin_unlock(&vbeContextLock);
+		return;
+	}
+	uint32_t *contextPreviousBuffer = context->previousBuffer;
+	uint32_t *contextCurrentBuffer = context->currentBuffer;
+	context->previousBuffer = 0;
+	context->currentBuffer = 0;
+	context->inUse = false;
+	
+	spin_unlock(&vbeContextLock);
+	
+	// Free buffers
+	heap_free(contextPreviousBuffer);
+	heap_free(contextCurrentBuffer);
+	trace_printf("Destroyed VBE context #%d\n", contextId);
+}
+
 void vbe_show_context(int contextId)
 {
 	// Check whether context ID is valid
@@ -188,12 +250,8 @@ void vbe_show_context(int contextId)
 		{
 			// Update "previous" buffer (it still contains the pixels when the drawing context was rendered last time), and redraw whole screen
 			uint32_t *currentBufferScrolledPtr = currentBuffer + scrollY * renderBufferWidth;
-			for(uint32_t i = 0; i < renderBufferWidth * renderBufferHeight; ++i)
-			{
-				uint32_t pixel = currentBufferScrolledPtr[i];
-				previousBuffer[i] = pixel;
-				renderBuffer[i] = pixel;
-			}
+			memcpy_large(previousBuffer, currentBufferScrolledPtr, 4 * renderBufferWidth * renderBufferHeight);
+			memcpy_large(renderBuffer, currentBufferScrolledPtr, 4 * renderBufferWidth * renderBufferHeight);
 		}
 	
 	}
@@ -214,13 +272,22 @@ int vbe_rectangle(int contextId, uint32_t posX, uint32_t posY, uint32_t width, u
 	// Draw rectangle
 	uint32_t xMax = posX + width;
 	uint32_t yMax = posY + height;
-	for(uint32_t y = posY; y < yMax; ++y)
+	if(width * height >= VBE_SIMD_MIN_PIXELS && kernel_fpu_begin())
 	{
-		uint32_t *pixel = context->currentBuffer + y * renderBufferWidth + posX;
-		for(uint32_t x = posX; x < xMax; ++x)
+		for(uint32_t y = posY; y < yMax; ++y)
+			vbe_simd_fill_row(context->currentBuffer + y * renderBufferWidth + posX, context->colorFront, width);
+		kernel_fpu_end();
+	}
+	else
+	{
+		for(uint32_t y = posY; y < yMax; ++y)
 		{
-			*pixel = context->colorFront;
-			++pixel;
+			uint32_t *pixel = context->currentBuffer + y * renderBufferWidth + posX;
+			for(uint32_t x = posX; x < xMax; ++x)
+			{
+				*pixel = context->colorFront;
+				++pixel;
+			}
 		}
 	}
 	_vbe_blit_to_video_memory(contextId, posX, posY, width, height);
@@ -264,6 +331,7 @@ int vbe_render_char(int contextId, uint32_t posX, uint32_t posY, char c)
 	int charIndex = c - ' ';
 	
 	// Run through character lines...
+	// A glyph has far less than VBE_SIMD_MIN_PIXELS pixels, so it is always rendered without vector instructions
 	for(int i = 0; i < VBE_FONT_CHARACTER_HEIGHT; ++i)
 	{
 		// ...and render bitmap of each line
@@ -328,12 +396,8 @@ void vbe_init_back_buffers()
 		panic("Could not reserve %d bytes of memory for VBE back buffer, heap allocator broken?", 4 * renderBufferWidth * renderBufferHeight);
 	
 	// Copy whole current video memory buffer to back buffers (so we don't lose previous debug outputs)
-	for(uint32_t i = 0; i < renderBufferWidth * renderBufferHeight; ++i)
-	{
-		uint32_t currentPixel = renderBuffer[i];
-		contexts[VBE_KERNEL_CONTEXT].previousBuffer[i] = currentPixel;
-		contexts[VBE_KERNEL_CONTEXT].currentBuffer[i] = currentPixel;
-	}
+	memcpy(contexts[VBE_KERNEL_CONTEXT].previousBuffer, renderBuffer, 4 * renderBufferWidth * renderBufferHeight);
+	memcpy(contexts[VBE_KERNEL_CONTEXT].currentBuffer, renderBuffer, 4 * renderBufferWidth * renderBufferHeight);
 	buffersAllocated = true;
 	
 	// Reload context to update local variables
@@ -452,8 +516,16 @@ void vbe_clear(int contextId)
 	vbe_context_t *context = &contexts[contextId];
 	
 	// Clear whole buffer
-	for(uint32_t i = 0; i < renderBufferWidth * context->currentBufferHeight; ++i)
-		context->currentBuffer[i] = context->colorBack;
+	if(kernel_fpu_begin())
+	{
+		vbe_simd_fill_row(context->currentBuffer, context->colorBack, (uint64_t)renderBufferWidth * context->currentBufferHeight);
+		kernel_fpu_end();
+	}
+	else
+	{
+		for(uint32_t i = 0; i < renderBufferWidth * context->currentBufferHeight; ++i)
+			context->currentBuffer[i] = context->colorBack;
+	}
 	
 	// Redraw, if current context
 	_vbe_blit_to_video_memory(contextId, 0, context->scrollY, renderBufferWidth, renderBufferHeight);
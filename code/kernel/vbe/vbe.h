@@ -18,6 +18,9 @@ void vbe_init_back_buffers();
 // Creates a new VBE drawing context and returns its identifier.
 int vbe_create_context();
 
+// Frees the buffers of the given drawing context, so it can be reused. The context must not be displayed.
+void vbe_destroy_context(int contextId);
+
 // Sets the currently displayed VBE drawing context and redraws the scene.
 // Should ONLY be called from proc.c, where appropriate locking is used.
 void vbe_show_context(int contextId);
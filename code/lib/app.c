@@ -7,6 +7,7 @@ ITS kernel standard library application management.
 #include <app.h>
 #include <io.h>
 #include <threading/thread.h>
+#include <internal/syscall/syscalls.h>
 
 
 /* VARIABLES */
@@ -25,6 +26,7 @@ void _start()
 
 void _end(int exitCode)
 {
-	// TODO clean exit
+	// Terminate process, the kernel frees all its resources
+	sys_exit(exitCode);
 	while(1);
 }
\ No newline at end of file
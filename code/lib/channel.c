@@ -0,0 +1,138 @@
+/*
+ITS kernel standard library inter-process channels.
+*/
+
+/* INCLUDES */
+
+#include <channel.h>
+#include <memory.h>
+#include <internal/syscall/syscalls.h>
+
+
+/* FUNCTIONS */
+
+// Copies data into the given ring, starting at the given position.
+static void ring_write(channel_ring_t *ring, uint64_t position, const void *data, int length)
+{
+	int offset = position % CHANNEL_RING_DATA_SIZE;
+	int first = CHANNEL_RING_DATA_SIZE - offset;
+	if(first > length)
+		first = length;
+	memcpy(&ring->data[offset], data, first);
+	memcpy(ring->data, (const uint8_t *)data + first, length - first);
+}
+
+// Copies data out of the given ring, starting at the given position.
+static void ring_read(channel_ring_t *ring, uint64_t position, void *buffer, int length)
+{
+	int offset = position % CHANNEL_RING_DATA_SIZE;
+	int first = CHANNEL_RING_DATA_SIZE - offset;
+	if(first > length)
+		first = length;
+	memcpy(buffer, &ring->data[offset], first);
+	memcpy((uint8_t *)buffer + first, ring->data, length - first);
+}
+
+bool channel_create(channel_t *channel, const char *name)
+{
+	channel->handle = sys_channel_create(name, &channel->info);
+	return channel->handle >= 0;
+}
+
+bool channel_connect(channel_t *channel, const char *name)
+{
+	channel->handle = sys_channel_connect(name, &channel->info);
+	return channel->handle >= 0;
+}
+
+void channel_close(channel_t *channel)
+{
+	sys_channel_close(channel->handle);
+	channel->handle = -1;
+}
+
+bool channel_send(channel_t *channel, const void *data, int length)
+{
+	// Messages are stored as 8-byte length followed by the data, padded to 8 bytes
+	uint64_t recordLength = 8 + ((length + 7) & ~7);
+	if(length < 0 || recordLength > CHANNEL_RING_DATA_SIZE)
+		return false;
+
+	// Wait for enough free space
+	channel_ring_t *ring = channel->info.sendRing;
+	uint64_t head = ring->head;
+	while(head + recordLength - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > CHANNEL_RING_DATA_SIZE)
+	{
+		// Announce that we are waiting before checking again, so the receiver either sees the flag or we see its progress
+		__atomic_store_n(&ring->senderWaiting, 1, __ATOMIC_SEQ_CST);
+		if(head + recordLength - __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) > CHANNEL_RING_DATA_SIZE)
+		{
+			int events = sys_channel_wait(channel->handle, CHANNEL_EVENT_WRITABLE | CHANNEL_EVENT_CLOSED, -1);
+			if(events & CHANNEL_EVENT_CLOSED)
+			{
+				__atomic_store_n(&ring->senderWaiting, 0, __ATOMIC_RELAXED);
+				return false;
+			}
+		}
+		__atomic_store_n(&ring->senderWaiting, 0, __ATOMIC_RELAXED);
+	}
+
+	// Write and publish the message
+	uint64_t messageLength = length;
+	ring_write(ring, head, &messageLength, 8);
+	ring_write(ring, head + 8, data, length);
+	__atomic_store_n(&ring->head, head + recordLength, __ATOMIC_SEQ_CST);
+
+	// Wake up the receiver, if necessary
+	if(__atomic_load_n(&ring->receiverWaiting, __ATOMIC_SEQ_CST))
+		sys_channel_notify(channel->handle);
+	return true;
+}
+
+int channel_receive(channel_t *channel, void *buffer, int bufferLength, int64_t timeoutMs)
+{
+	// Wait for a message
+	channel_ring_t *ring = channel->info.receiveRing;
+	uint64_t tail = ring->tail;
+	if(__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail)
+	{
+		if(timeoutMs == 0)
+			return -1;
+
+		__atomic_store_n(&ring->receiverWaiting, 1, __ATOMIC_SEQ_CST);
+		int events = sys_channel_wait(channel->handle, CHANNEL_EVENT_READABLE | CHANNEL_EVENT_CLOSED, timeoutMs);
+		__atomic_store_n(&ring->receiverWaiting, 0, __ATOMIC_RELAXED);
+		if(!(events & CHANNEL_EVENT_READABLE))
+			return -1;
+	}
+
+	// Read the message
+	uint64_t messageLength;
+	ring_read(ring, tail, &messageLength, 8);
+	ring_read(ring, tail + 8, buffer, (int)messageLength < bufferLength ? (int)messageLength : bufferLength);
+	__atomic_store_n(&ring->tail, tail + 8 + ((messageLength + 7) & ~7), __ATOMIC_SEQ_CST);
+
+	// Wake up the sender, if necessary
+	if(__atomic_load_n(&ring->senderWaiting, __ATOMIC_SEQ_CST))
+		sys_channel_notify(channel->handle);
+	return (int)messageLength;
+}
+
+bool channel_grant(channel_t *channel, void *memory)
+{
+	return sys_channel_grant(channel->handle, memory);
+}
+
+void *channel_accept_grant(channel_t *channel, uint64_t *size, int64_t timeoutMs)
+{
+	while(true)
+	{
+		void *memory = sys_channel_accept_grant(channel->handle, size);
+		if(memory || timeoutMs == 0)
+			return memory;
+
+		int events = sys_channel_wait(channel->handle, CHANNEL_EVENT_GRANT | CHANNEL_EVENT_CLOSED, timeoutMs);
+		if(!(events & CHANNEL_EVENT_GRANT))
+			return 0;
+	}
+}
\ No newline at end of file
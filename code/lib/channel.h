@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+ITS kernel standard library inter-process channels.
+
+A channel connects two processes through a pair of shared memory rings, so messages are passed without system calls
+as long as neither side has to wait. Large payloads can be passed by granting memory allocated with heap_alloc() to
+the other side, which avoids copying them.
+
+A channel may only be used by one sending and one receiving thread at a time.
+*/
+
+/* INCLUDES */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <internal/syscall/channel.h>
+
+
+/* TYPES */
+
+// A channel endpoint.
+typedef struct
+{
+	// Kernel handle.
+	int handle;
+
+	// Shared rings.
+	channel_info_t info;
+} channel_t;
+
+
+/* DECLARATIONS */
+
+// Creates a new channel with the given name (at most 31 characters), which can then be connected to by another process.
+bool channel_create(channel_t *channel, const char *name);
+
+// Connects to the channel with the given name.
+bool channel_connect(channel_t *channel, const char *name);
+
+// Closes the given channel. Memory received through grants stays valid.
+void channel_close(channel_t *channel);
+
+// Sends the given message, waiting while the ring is full. Messages can have up to CHANNEL_RING_DATA_SIZE - 8 bytes.
+// Returns false if the message is too large or the other side has closed the channel.
+bool channel_send(channel_t *channel, const void *data, int length);
+
+// Receives the next message into the given buffer, waiting up to the given amount of milliseconds (negative: forever).
+// Returns the message length, or -1 on timeout or when the other side has closed the channel. If the buffer is too
+// small, the message is truncated.
+int channel_receive(channel_t *channel, void *buffer, int bufferLength, int64_t timeoutMs);
+
+// Passes the given memory, which must have been returned by heap_alloc(), to the other side. The memory is not
+// accessible to the current process anymore afterwards.
+bool channel_grant(channel_t *channel, void *memory);
+
+// Waits up to the given amount of milliseconds (negative: forever) for memory granted by the other side, and returns
+// it. The size is stored in the given variable. The memory must be freed with heap_free().
+void *channel_accept_grant(channel_t *channel, uint64_t *size, int64_t timeoutMs);
\ No newline at end of file
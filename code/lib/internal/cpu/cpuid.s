@@ -42,8 +42,8 @@ cpuid:
 ;     - rcx: Pointer to EBX out
 ;     - r8: Pointer to ECX out
 ;     - r9: Pointer to EDX out
-[global cpuid_special]
-cpuid_special:
+[global cpuid_ext]
+cpuid_ext:
 	; Save non-volatile register
 	push rbx
 	
@@ -67,3 +67,15 @@ cpuid_special:
 	; Done
 	pop rbx
 	ret
+
+
+; Reads the given extended control register.
+; Parameters:
+;     - rdi: Register index (0 = XCR0).
+[global xgetbv_read]
+xgetbv_read:
+	mov ecx, edi
+	xgetbv
+	shl rdx, 32
+	or rax, rdx
+	ret
\ No newline at end of file
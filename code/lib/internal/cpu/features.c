@@ -0,0 +1,52 @@
+/*
+Detection of CPU features used by the library.
+*/
+
+/* INCLUDES */
+
+#include <internal/cpu/features.h>
+#include <internal/cpu/cpuid.h>
+#include <stdbool.h>
+
+
+/* VARIABLES */
+
+// Detected features; CPU_FEATURES_DETECTED is set once these are valid. Concurrent first calls detect the same value,
+// so no locking is needed.
+#define CPU_FEATURES_DETECTED 0x80000000
+static volatile uint32_t cpuFeatures = 0;
+
+
+/* FUNCTIONS */
+
+uint32_t cpu_features_get()
+{
+	uint32_t features = cpuFeatures;
+	if(features & CPU_FEATURES_DETECTED)
+		return features & ~CPU_FEATURES_DETECTED;
+	
+	features = 0;
+	uint32_t maxLeaf;
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+	cpuid(0x00000000, &maxLeaf, &ebx, &ecx, &edx);
+	cpuid(0x00000001, &eax, &ebx, &ecx, &edx);
+	
+	// AVX2 needs the OS to save the SSE and AVX state (XCR0 bits 1 and 2)
+	bool osAvx = (ecx & (1 << 27)) && (ecx & (1 << 28)) && (xgetbv_read(0) & 0x6) == 0x6;
+	if(maxLeaf >= 0x00000007)
+	{
+		cpuid_ext(0x00000007, 0, &eax, &ebx, &ecx, &edx);
+		if(osAvx && (ebx & (1 << 5)))
+			features |= CPU_FEATURE_AVX2;
+		if(ebx & (1 << 9))
+			features |= CPU_FEATURE_ERMS;
+		if(edx & (1 << 4))
+			features |= CPU_FEATURE_FSRM;
+	}
+	
+	cpuFeatures = features | CPU_FEATURES_DETECTED;
+	return features;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+Detection of CPU features used by the library.
+*/
+
+/* INCLUDES */
+
+#include <stdint.h>
+
+
+/* TYPES */
+
+// CPU features returned by cpu_features_get().
+#define CPU_FEATURE_AVX2 0x1 /* AVX2, and the OS saves the YMM registers */
+#define CPU_FEATURE_ERMS 0x2 /* enhanced REP MOVSB/STOSB */
+#define CPU_FEATURE_FSRM 0x4 /* fast short REP MOVSB */
+
+
+/* DECLARATIONS */
+
+// Returns the supported CPU features (CPU_FEATURE_* flags). The features are detected on the first call.
+uint32_t cpu_features_get();
\ No newline at end of file
@@ -57,6 +57,12 @@ static int queueBufferSize;
 // The keypress handler for each key code.
 static keypress_handler_t keypressHandlers[VKEY_MAX_VALUE + 1] = { 0 };
 
+// ID of the keyboard receiving thread.
+static int keyboardThreadId = -1;
+
+// ID of the thread currently waiting for a key press, or -1.
+static volatile int waitingThreadId = -1;
+
 
 /* FORWARD DECLARATIONS */
 
@@ -71,7 +77,7 @@ static bool queue_retrieve(vkey_t *keyCode, bool *shiftPressed);
 /* FUNCTIONS */
 
 // Keyboard receiving thread function.
-// Frequently polls the OS for new key presses and stores them in an internal queue.
+// Waits for new key presses and stores them in an internal queue.
 static void keyboard_thread(void *args)
 {
 	// Run on Core #0
@@ -82,13 +88,14 @@ static void keyboard_thread(void *args)
 	while(true)
 	{
 		// Wait for key press message
-		msg_type_t newMsgType;
-		while((newMsgType = sys_next_message_type()) == MSG_INVALID)
-			sys_yield();
-		
-		// Retrieve message
-		msg_key_press_t msg;
-		sys_next_message(&msg.header);
+		union
+		{
+			msg_key_press_t keyPress;
+			uint8_t raw[MSG_RING_MAX_MESSAGE_SIZE];
+		} buffer;
+		if(sys_wait_message(&buffer.keyPress.header, -1) != MSG_KEY_PRESS)
+			continue;
+		msg_key_press_t msg = buffer.keyPress;
 		
 		// Handle key press depending on type
 		if(key_is_navigation_key(msg.keyCode))
@@ -105,6 +112,11 @@ static void keyboard_thread(void *args)
 		{
 			// Add key press to queue
 			queue_add_element(msg.keyCode, msg.shiftModifier);
+			
+			// Hand off to waiting thread directly
+			int waitingThread = waitingThreadId;
+			if(waitingThread >= 0)
+				sys_yield_to(waitingThread);
 		}
 	}
 }
@@ -121,7 +133,7 @@ void keyboard_init()
 	queueBufferSize = 0;
 	
 	// Run keyboard receiving thread
-	run_thread(&keyboard_thread, 0, "keyboard queue");
+	keyboardThreadId = run_thread(&keyboard_thread, 0, "keyboard queue");
 }
 
 vkey_t receive_keypress(bool *shiftPressed)
@@ -129,8 +141,14 @@ vkey_t receive_keypress(bool *shiftPressed)
 	// Wait until key press message arrives
 	vkey_t keyCodeTmp;
 	bool shiftPressedTmp;
-	while(!queue_retrieve(&keyCodeTmp, &shiftPressedTmp))
-		sys_yield();
+	if(!queue_retrieve(&keyCodeTmp, &shiftPressedTmp))
+	{
+		// Let the keyboard thread run until it has delivered a key press
+		waitingThreadId = sys_get_thread_id();
+		while(!queue_retrieve(&keyCodeTmp, &shiftPressedTmp))
+			sys_yield_to(keyboardThreadId);
+		waitingThreadId = -1;
+	}
 	
 	// Shift modifier?
 	if(shiftPressed)
@@ -0,0 +1,43 @@
+#pragma once
+
+/*
+ITS kernel standard library memory and string routine variants (see memory.s).
+memcpy(), memset(), memmove(), memcmp(), strlen() and strcmp() choose one of these depending on the CPU features; they
+are only declared here for benchmarks and tests.
+*/
+
+/* INCLUDES */
+
+#include <stdint.h>
+
+
+/* TYPES */
+
+// Minimum length for which memcpy() and memset() use REP MOVSB/STOSB, if the CPU supports ERMS.
+#define MEMORY_ERMS_THRESHOLD 2048
+
+// Minimum length for which memcpy() uses REP MOVSB, if the CPU supports FSRM.
+#define MEMORY_FSRM_THRESHOLD 256
+
+
+/* DECLARATIONS */
+
+void *memcpy_sse2(void *destination, const void *source, uint64_t length);
+void *memcpy_avx2(void *destination, const void *source, uint64_t length);
+void *memcpy_erms(void *destination, const void *source, uint64_t length);
+
+// Copies to a higher, overlapping destination address.
+void *memmove_backward_sse2(void *destination, const void *source, uint64_t length);
+
+void *memset_sse2(void *array, int value, uint64_t length);
+void *memset_avx2(void *array, int value, uint64_t length);
+void *memset_erms(void *array, int value, uint64_t length);
+
+int memcmp_sse2(const void *array1, const void *array2, uint64_t length);
+int memcmp_avx2(const void *array1, const void *array2, uint64_t length);
+
+int strlen_sse2(const char *str);
+int strlen_avx2(const char *str);
+
+int strcmp_sse2(const char *str1, const char *str2);
+int strcmp_avx2(const char *str1, const char *str2);
\ No newline at end of file
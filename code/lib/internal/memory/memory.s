@@ -0,0 +1,529 @@
+; ITS kernel standard library memory and string routines.
+; memory.c and string.c choose one of the variants depending on cpu_features_get(). The SSE2 variants work on every
+; x86-64 CPU; the AVX2 variants fall back to them for short lengths and the remainders. All loads are either within
+; the given lengths, or aligned such that they do not cross into the next page.
+
+; Copies memory, the SSE2 and AVX2 variants. Copying to a lower overlapping address is allowed, as every block is read
+; before the blocks overlapping it are written.
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Source.
+;     - rdx: Length.
+; Return value:
+;     - rax: Destination.
+[global memcpy_sse2]
+memcpy_sse2:
+	mov rax, rdi
+	cmp rdx, 16
+	jb .small
+
+	; The last block is read first and written last, so the remainder needs no special handling
+	movdqu xmm7, [rsi + rdx - 16]
+	lea r8, [rdi + rdx - 16]
+
+	; Copy 64 bytes at a time
+	mov rcx, rdx
+	shr rcx, 6
+	jz .blocks16
+.loop64:
+	movdqu xmm0, [rsi]
+	movdqu xmm1, [rsi + 16]
+	movdqu xmm2, [rsi + 32]
+	movdqu xmm3, [rsi + 48]
+	movdqu [rdi], xmm0
+	movdqu [rdi + 16], xmm1
+	movdqu [rdi + 32], xmm2
+	movdqu [rdi + 48], xmm3
+	add rsi, 64
+	add rdi, 64
+	dec rcx
+	jnz .loop64
+
+	; Copy the remaining full 16 byte blocks
+.blocks16:
+	mov ecx, edx
+	and ecx, 63
+	shr ecx, 4
+	jz .last
+.loop16:
+	movdqu xmm0, [rsi]
+	movdqu [rdi], xmm0
+	add rsi, 16
+	add rdi, 16
+	dec ecx
+	jnz .loop16
+.last:
+	movdqu [r8], xmm7
+	ret
+
+	; Less than 16 bytes: Copy 8, 4, 2 and 1 bytes depending on the length bits
+.small:
+	test dl, 8
+	jz .small4
+	mov rcx, [rsi]
+	mov [rdi], rcx
+	add rsi, 8
+	add rdi, 8
+.small4:
+	test dl, 4
+	jz .small2
+	mov ecx, [rsi]
+	mov [rdi], ecx
+	add rsi, 4
+	add rdi, 4
+.small2:
+	test dl, 2
+	jz .small1
+	movzx ecx, word [rsi]
+	mov [rdi], cx
+	add rsi, 2
+	add rdi, 2
+.small1:
+	test dl, 1
+	jz .done
+	movzx ecx, byte [rsi]
+	mov [rdi], cl
+.done:
+	ret
+
+[global memcpy_avx2]
+memcpy_avx2:
+	cmp rdx, 32
+	jb memcpy_sse2
+	mov rax, rdi
+	vmovdqu ymm7, [rsi + rdx - 32]
+	lea r8, [rdi + rdx - 32]
+
+	; Copy 128 bytes at a time
+	mov rcx, rdx
+	shr rcx, 7
+	jz .blocks32
+.loop128:
+	vmovdqu ymm0, [rsi]
+	vmovdqu ymm1, [rsi + 32]
+	vmovdqu ymm2, [rsi + 64]
+	vmovdqu ymm3, [rsi + 96]
+	vmovdqu [rdi], ymm0
+	vmovdqu [rdi + 32], ymm1
+	vmovdqu [rdi + 64], ymm2
+	vmovdqu [rdi + 96], ymm3
+	sub rsi, -128
+	sub rdi, -128
+	dec rcx
+	jnz .loop128
+
+	; Copy the remaining full 32 byte blocks
+.blocks32:
+	mov ecx, edx
+	and ecx, 127
+	shr ecx, 5
+	jz .last
+.loop32:
+	vmovdqu ymm0, [rsi]
+	vmovdqu [rdi], ymm0
+	add rsi, 32
+	add rdi, 32
+	dec ecx
+	jnz .loop32
+.last:
+	vmovdqu [r8], ymm7
+
+	; Avoid the penalty of mixing dirty upper YMM halves with SSE code
+	vzeroupper
+	ret
+
+; Copies memory using REP MOVSB. Same parameters as memcpy_sse2.
+[global memcpy_erms]
+memcpy_erms:
+	mov rax, rdi
+	mov rcx, rdx
+	rep movsb
+	ret
+
+; Copies memory to a higher overlapping address, starting at the end.
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Source.
+;     - rdx: Length.
+; Return value:
+;     - rax: Destination.
+[global memmove_backward_sse2]
+memmove_backward_sse2:
+	mov rax, rdi
+	cmp rdx, 16
+	jb .bytes
+
+	; The first block is read first and written last
+	movdqu xmm7, [rsi]
+.loop16:
+	cmp rdx, 16
+	jbe .last
+	sub rdx, 16
+	movdqu xmm0, [rsi + rdx]
+	movdqu [rdi + rdx], xmm0
+	jmp .loop16
+.last:
+	movdqu [rdi], xmm7
+	ret
+
+.bytes:
+	test rdx, rdx
+	jz .done
+.byte_loop:
+	dec rdx
+	movzx ecx, byte [rsi + rdx]
+	mov [rdi + rdx], cl
+	jnz .byte_loop
+.done:
+	ret
+
+; Fills memory with the given byte, the SSE2 and AVX2 variants.
+; Parameters:
+;     - rdi: Destination.
+;     - rsi: Byte value.
+;     - rdx: Length.
+; Return value:
+;     - rax: Destination.
+[global memset_sse2]
+memset_sse2:
+	mov rax, rdi
+
+	; Replicate the byte into all 8 bytes of RCX
+	movzx ecx, sil
+	mov r8, 0x0101010101010101
+	imul rcx, r8
+	cmp rdx, 16
+	jb .small
+	movq xmm0, rcx
+	punpcklqdq xmm0, xmm0
+	lea r8, [rdi + rdx - 16]
+
+	; Fill 64 bytes at a time, then the remaining 16 byte blocks, then the last (overlapping) block
+	mov r9, rdx
+	shr r9, 6
+	jz .blocks16
+.loop64:
+	movdqu [rdi], xmm0
+	movdqu [rdi + 16], xmm0
+	movdqu [rdi + 32], xmm0
+	movdqu [rdi + 48], xmm0
+	add rdi, 64
+	dec r9
+	jnz .loop64
+.blocks16:
+	mov r9d, edx
+	and r9d, 63
+	shr r9d, 4
+	jz .last
+.loop16:
+	movdqu [rdi], xmm0
+	add rdi, 16
+	dec r9d
+	jnz .loop16
+.last:
+	movdqu [r8], xmm0
+	ret
+
+	; Less than 16 bytes
+.small:
+	test dl, 8
+	jz .small4
+	mov [rdi], rcx
+	add rdi, 8
+.small4:
+	test dl, 4
+	jz .small2
+	mov [rdi], ecx
+	add rdi, 4
+.small2:
+	test dl, 2
+	jz .small1
+	mov [rdi], cx
+	add rdi, 2
+.small1:
+	test dl, 1
+	jz .done
+	mov [rdi], cl
+.done:
+	ret
+
+[global memset_avx2]
+memset_avx2:
+	cmp rdx, 32
+	jb memset_sse2
+	mov rax, rdi
+	movzx ecx, sil
+	vmovd xmm0, ecx
+	vpbroadcastb ymm0, xmm0
+	lea r8, [rdi + rdx - 32]
+
+	; Fill 128 bytes at a time, then the remaining 32 byte blocks, then the last (overlapping) block
+	mov r9, rdx
+	shr r9, 7
+	jz .blocks32
+.loop128:
+	vmovdqu [rdi], ymm0
+	vmovdqu [rdi + 32], ymm0
+	vmovdqu [rdi + 64], ymm0
+	vmovdqu [rdi + 96], ymm0
+	sub rdi, -128
+	dec r9
+	jnz .loop128
+.blocks32:
+	mov r9d, edx
+	and r9d, 127
+	shr r9d, 5
+	jz .last
+.loop32:
+	vmovdqu [rdi], ymm0
+	add rdi, 32
+	dec r9d
+	jnz .loop32
+.last:
+	vmovdqu [r8], ymm0
+	vzeroupper
+	ret
+
+; Fills memory using REP STOSB. Same parameters as memset_sse2.
+[global memset_erms]
+memset_erms:
+	mov r9, rdi
+	mov eax, esi
+	mov rcx, rdx
+	rep stosb
+	mov rax, r9
+	ret
+
+; Compares memory, the SSE2 and AVX2 variants.
+; Parameters:
+;     - rdi: First array.
+;     - rsi: Second array.
+;     - rdx: Length.
+; Return value:
+;     - rax: Difference of the first differing bytes (unsigned), or 0 if the arrays are equal.
+[global memcmp_sse2]
+memcmp_sse2:
+	xor ecx, ecx
+.loop16:
+	lea r8, [rcx + 16]
+	cmp r8, rdx
+	ja .bytes
+	movdqu xmm0, [rdi + rcx]
+	movdqu xmm1, [rsi + rcx]
+	pcmpeqb xmm0, xmm1
+	pmovmskb eax, xmm0
+	xor eax, 0xFFFF
+	jnz .diff
+	mov rcx, r8
+	jmp .loop16
+
+	; EAX has a bit set for each differing byte
+.diff:
+	bsf eax, eax
+	add rcx, rax
+	movzx eax, byte [rdi + rcx]
+	movzx edx, byte [rsi + rcx]
+	sub eax, edx
+	ret
+
+	; Compare the remaining bytes
+.bytes:
+	cmp rcx, rdx
+	jae .equal
+	movzx eax, byte [rdi + rcx]
+	movzx r8d, byte [rsi + rcx]
+	sub eax, r8d
+	jnz .done
+	inc rcx
+	jmp .bytes
+.equal:
+	xor eax, eax
+.done:
+	ret
+
+[global memcmp_avx2]
+memcmp_avx2:
+	xor ecx, ecx
+.loop32:
+	lea r8, [rcx + 32]
+	cmp r8, rdx
+	ja .remainder
+	vmovdqu ymm0, [rdi + rcx]
+	vpcmpeqb ymm0, ymm0, [rsi + rcx]
+	vpmovmskb eax, ymm0
+	not eax
+	test eax, eax
+	jnz .diff
+	mov rcx, r8
+	jmp .loop32
+.diff:
+	vzeroupper
+	jmp memcmp_sse2.diff
+.remainder:
+	vzeroupper
+	jmp memcmp_sse2.loop16
+
+; Determines the length of a string, the SSE2 and AVX2 variants. The string is read in aligned blocks.
+; Parameters:
+;     - rdi: String.
+; Return value:
+;     - rax: Length.
+[global strlen_sse2]
+strlen_sse2:
+	mov rsi, rdi
+	and rsi, -16
+	mov ecx, edi
+	and ecx, 15
+	pxor xmm0, xmm0
+
+	; Ignore the bytes of the first block which are before the string
+	movdqa xmm1, [rsi]
+	pcmpeqb xmm1, xmm0
+	pmovmskb eax, xmm1
+	shr eax, cl
+	test eax, eax
+	jnz .found_first
+.loop:
+	add rsi, 16
+	movdqa xmm1, [rsi]
+	pcmpeqb xmm1, xmm0
+	pmovmskb eax, xmm1
+	test eax, eax
+	jz .loop
+	bsf eax, eax
+	add rax, rsi
+	sub rax, rdi
+	ret
+.found_first:
+	bsf eax, eax
+	ret
+
+[global strlen_avx2]
+strlen_avx2:
+	mov rsi, rdi
+	and rsi, -32
+	mov ecx, edi
+	and ecx, 31
+	vpxor xmm0, xmm0, xmm0
+	vpcmpeqb ymm1, ymm0, [rsi]
+	vpmovmskb eax, ymm1
+	shr eax, cl
+	test eax, eax
+	jnz .found_first
+.loop:
+	add rsi, 32
+	vpcmpeqb ymm1, ymm0, [rsi]
+	vpmovmskb eax, ymm1
+	test eax, eax
+	jz .loop
+	bsf eax, eax
+	add rax, rsi
+	sub rax, rdi
+	vzeroupper
+	ret
+.found_first:
+	bsf eax, eax
+	vzeroupper
+	ret
+
+; Compares two strings, the SSE2 and AVX2 variants. A block is only loaded if it does not cross a page boundary in
+; either string, otherwise the next bytes are compared one by one.
+; Parameters:
+;     - rdi: First string.
+;     - rsi: Second string.
+; Return value:
+;     - rax: Difference of the first differing characters (unsigned), or 0 if the strings are equal.
+[global strcmp_sse2]
+strcmp_sse2:
+	xor ecx, ecx
+	pxor xmm2, xmm2
+.loop:
+	lea rax, [rdi + rcx]
+	and eax, 4095
+	cmp eax, 4096 - 16
+	ja .bytes
+	lea rax, [rsi + rcx]
+	and eax, 4095
+	cmp eax, 4096 - 16
+	ja .bytes
+	movdqu xmm0, [rdi + rcx]
+	movdqu xmm1, [rsi + rcx]
+
+	; Stop at the first byte which differs or terminates the first string
+	pcmpeqb xmm1, xmm0
+	pcmpeqb xmm0, xmm2
+	pmovmskb eax, xmm1
+	pmovmskb edx, xmm0
+	not eax
+	and eax, 0xFFFF
+	or eax, edx
+	jnz .found
+	add rcx, 16
+	jmp .loop
+.found:
+	bsf eax, eax
+	add rcx, rax
+	movzx eax, byte [rdi + rcx]
+	movzx edx, byte [rsi + rcx]
+	sub eax, edx
+	ret
+
+	; Compare 16 bytes one by one, then try blocks again
+.bytes:
+	mov r8d, 16
+.byte_loop:
+	movzx eax, byte [rdi + rcx]
+	movzx edx, byte [rsi + rcx]
+	sub eax, edx
+	jnz .done
+	test edx, edx
+	jz .done
+	inc rcx
+	dec r8d
+	jnz .byte_loop
+	jmp .loop
+.done:
+	ret
+
+[global strcmp_avx2]
+strcmp_avx2:
+	xor ecx, ecx
+	vpxor xmm2, xmm2, xmm2
+.loop:
+	lea rax, [rdi + rcx]
+	and eax, 4095
+	cmp eax, 4096 - 32
+	ja .bytes
+	lea rax, [rsi + rcx]
+	and eax, 4095
+	cmp eax, 4096 - 32
+	ja .bytes
+	vmovdqu ymm0, [rdi + rcx]
+	vpcmpeqb ymm1, ymm0, [rsi + rcx]
+	vpcmpeqb ymm0, ymm0, ymm2
+	vpmovmskb eax, ymm1
+	vpmovmskb edx, ymm0
+	not eax
+	or eax, edx
+	jnz .found
+	add rcx, 32
+	jmp .loop
+.found:
+	vzeroupper
+	jmp strcmp_sse2.found
+.bytes:
+	mov r8d, 32
+.byte_loop:
+	movzx eax, byte [rdi + rcx]
+	movzx edx, byte [rsi + rcx]
+	sub eax, edx
+	jnz .done
+	test edx, edx
+	jz .done
+	inc rcx
+	dec r8d
+	jnz .byte_loop
+	jmp .loop
+.done:
+	vzeroupper
+	ret
\ No newline at end of file
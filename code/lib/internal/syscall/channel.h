@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ITS kernel inter-process channel definitions.
+*/
+
+/* INCLUDES */
+
+#include <stdint.h>
+
+
+/* TYPES */
+
+// Size of the data area of a channel ring.
+#define CHANNEL_RING_DATA_SIZE (64 * 1024)
+
+// Events reported by sys_channel_wait().
+#define CHANNEL_EVENT_READABLE 0x1
+#define CHANNEL_EVENT_WRITABLE 0x2
+#define CHANNEL_EVENT_GRANT    0x4
+#define CHANNEL_EVENT_CLOSED   0x8
+
+// One direction of a channel, shared by both processes.
+typedef struct
+{
+	// Number of bytes written so far. Only written by the sending side.
+	uint64_t head __attribute__((aligned(64)));
+
+	// Number of bytes read so far. Only written by the receiving side.
+	uint64_t tail __attribute__((aligned(64)));
+
+	// Set by the respective side before waiting for new data or free space.
+	uint32_t receiverWaiting __attribute__((aligned(64)));
+	uint32_t senderWaiting;
+
+	// Data, indexed by the positions modulo CHANNEL_RING_DATA_SIZE.
+	uint8_t data[CHANNEL_RING_DATA_SIZE] __attribute__((aligned(4096)));
+} channel_ring_t;
+
+// The rings of a channel endpoint.
+typedef struct
+{
+	channel_ring_t *sendRing;
+	channel_ring_t *receiveRing;
+} channel_info_t;
\ No newline at end of file
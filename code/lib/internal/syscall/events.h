@@ -0,0 +1,13 @@
+#pragma once
+
+/*
+ITS kernel event multiplexing definitions.
+*/
+
+/* TYPES */
+
+// Event sources for sys_wait_events().
+#define EVENT_MESSAGE     0x1 /* the message ring of the process is not empty */
+#define EVENT_NET_RECEIVE 0x2 /* a received network packet is pending */
+#define EVENT_CHANNEL     0x4 /* a channel of the process is readable, has a pending grant or was closed */
+#define EVENT_TIMEOUT     0x8 /* the timeout has passed */
\ No newline at end of file
@@ -37,4 +37,36 @@ typedef struct
 	
 	// The code of the pressed key.
 	vkey_t keyCode;
-} msg_key_press_t;
\ No newline at end of file
+} msg_key_press_t;
+
+// Number of slots of a message ring, and the maximum size of a message stored in a slot.
+#define MSG_RING_SIZE 64
+#define MSG_RING_MAX_MESSAGE_SIZE 24
+
+// A slot of the message ring.
+typedef struct
+{
+	// Sequence number: Equals the enqueue position + 1 when the slot holds the message enqueued at that position.
+	uint64_t sequence;
+	
+	// Message data (starts with msg_header_t).
+	uint8_t data[MSG_RING_MAX_MESSAGE_SIZE];
+} msg_ring_slot_t;
+
+// The message ring of a process, as mapped read-only by sys_get_message_ring().
+// A message is pending if slots[dequeuePos % MSG_RING_SIZE].sequence == dequeuePos + 1; it can only be removed with
+// sys_wait_message().
+typedef struct
+{
+	// Position of the next message to be enqueued.
+	uint64_t enqueuePos __attribute__((aligned(64)));
+	
+	// Position of the next message to be dequeued.
+	uint64_t dequeuePos __attribute__((aligned(64)));
+	
+	// Number of messages dropped because the ring was full.
+	uint64_t dropped __attribute__((aligned(64)));
+	
+	// Message slots.
+	msg_ring_slot_t slots[MSG_RING_SIZE] __attribute__((aligned(64)));
+} msg_ring_t;
\ No newline at end of file
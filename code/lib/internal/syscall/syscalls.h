@@ -6,17 +6,27 @@ This file defines functions for all available system calls; implementations can
 
 #include <stdint.h>
 #include <internal/syscall/msg.h>
+#include <internal/syscall/channel.h>
+#include <internal/syscall/uring.h>
+#include <internal/syscall/events.h>
 #include <internal/syscall/ramfs.h>
 
 // Prints the given string to kernel console. TODO remove, this is only for debugging
 uint64_t sys_kputs(const char *str);
 
-// TODO this does not do anything yet
-int sys_exit();
+// Terminates the current process.
+int sys_exit(int exitCode);
 
 // Switches to another thread, while the current one is e.g. waiting for messages (cooperative multitasking).
 int sys_yield();
 
+// Switches directly to the given thread of the current process, if it can be run on the current core.
+// Returns -1 if there is no such thread.
+int sys_yield_to(int threadId);
+
+// Returns the ID of the current thread.
+int sys_get_thread_id();
+
 // Returns the type of the oldest non-processed message, if it exists.
 msg_type_t sys_next_message_type();
 
@@ -24,6 +34,55 @@ msg_type_t sys_next_message_type();
 // The parameter messageBuffer must provide enough space to fit the given message, thus next_message_type() should be called first to determine the correct message size.
 void sys_next_message(msg_header_t *messageBuffer);
 
+// Waits up to the given amount of milliseconds (negative: forever) for a message, and copies it into the given buffer,
+// which must provide MSG_RING_MAX_MESSAGE_SIZE bytes. Returns the message type, or MSG_INVALID on timeout.
+msg_type_t sys_wait_message(msg_header_t *messageBuffer, int64_t timeoutMs);
+
+// Returns the read-only mapping of the current process' message ring, or 0 on failure.
+const msg_ring_t *sys_get_message_ring();
+
+// Creates a named channel and maps its rings into the current process. Returns the channel handle, or -1 on error.
+int sys_channel_create(const char *name, channel_info_t *info);
+
+// Connects to the channel with the given name and maps its rings into the current process. Returns the channel handle,
+// or -1 on error.
+int sys_channel_connect(const char *name, channel_info_t *info);
+
+// Closes the given channel handle.
+void sys_channel_close(int handle);
+
+// Waits up to the given amount of milliseconds (negative: forever) for one of the given CHANNEL_EVENT_* events. Returns
+// the events that occurred, or 0 on timeout.
+int sys_channel_wait(int handle, int events, int64_t timeoutMs);
+
+// Wakes up the threads waiting for the given channel.
+void sys_channel_notify(int handle);
+
+// Moves the memory segment starting at the given address (allocated with sys_heap_alloc()) to the other side.
+bool sys_channel_grant(int handle, void *addr);
+
+// Maps the oldest pending memory grant into the current process. Returns its address and size, or 0 if there is none.
+void *sys_channel_accept_grant(int handle, uint64_t *size);
+
+// Creates a new submission/completion ring pair and maps it into the current process. Returns the handle, or -1.
+int sys_uring_setup(uring_t **userRing);
+
+// Executes up to the given number of queued submissions, then waits up to the given amount of milliseconds (negative:
+// forever) until at least minComplete completions are available. Returns the number of executed submissions, or -1.
+int sys_uring_enter(int handle, uint32_t toSubmit, uint32_t minComplete, int64_t timeoutMs);
+
+// Waits up to the given amount of milliseconds (negative: forever) until one of the given EVENT_* sources is ready.
+// Returns the ready sources, or EVENT_TIMEOUT (if requested) on timeout. Waiting for EVENT_CHANNEL makes the other
+// sides of all channels of the process notify after sending, as with sys_channel_wait().
+uint32_t sys_wait_events(uint32_t mask, int64_t timeoutMs);
+
+// Switches the recording of system call statistics on or off, and optionally discards the statistics collected so far.
+void sys_syscall_stats_enable(bool enable, bool reset);
+
+// Retrieves the system call statistics of all processes (see the kernel's syscallstat_info_t), one entry per process
+// and used system call. Returns the number of entries written, or -1 on error.
+int sys_get_syscall_stats(void *buffer, int maxCount);
+
 // Changes the currently displayed process render context.
 void sys_set_displayed_process(int contextId);
 
@@ -63,8 +122,8 @@ void *sys_heap_alloc(int size);
 // Frees the given allocated memory.
 void sys_heap_free(void *addr);
 
-// Starts a new thread and sets the instruction pointer to the given address.
-void sys_run_thread(uint64_t rip, const char *name);
+// Starts a new thread and sets the instruction pointer to the given address. Returns the ID of the new thread.
+int sys_run_thread(uint64_t rip, const char *name);
 
 // Exits the current thread.
 void sys_exit_thread();
@@ -85,6 +144,21 @@ int sys_receive_network_packet(uint8_t *packetBuffer);
 // Sends the given network packet.
 void sys_send_network_packet(uint8_t *packet, int packetLength);
 
+// Copies the accounting data of up to maxCount threads into the given thread_stats_t buffer. Returns the number of
+// entries, or -1 on error.
+int sys_get_thread_stats(void *buffer, int maxCount);
+
+// Copies the accounting data of up to maxCount cores into the given cpu_stats_t buffer. Returns the number of entries.
+int sys_get_cpu_stats(void *buffer, int maxCount);
+
+// Runs the kernel lock torture test with the given number of iterations per core and copies up to maxCount results
+// (one per lock type) into the given buffer. Returns the number of results, or 0 if a test is already running.
+int sys_lock_torture(int iterations, void *results, int maxCount);
+
+// Runs the kernel memory routine benchmark with the given number of repetitions per size and copies up to maxCount
+// results into the given buffer. Returns the number of results, or -1 on error.
+int sys_mem_bench(int iterations, void *results, int maxCount);
+
 // Copies system information into the given buffer.
 void sys_info(int infoId, uint8_t *buffer);
 
@@ -94,6 +168,14 @@ void sys_dump(int infoId, const char *filePath);
 // Sets the core the current thread shall be run on.
 void sys_set_affinity(int coreId);
 
+// Sets scheduling class and priority of the given thread of the current process (-1 for the current thread).
+// Returns -1 on invalid parameters.
+int sys_set_thread_scheduling(int threadId, int schedClass, int priority);
+
+// Isolates the given core (no scheduler ticks while running a single thread, no unrelated TLB shootdowns, no
+// automatic thread placement), or releases it again. The boot core cannot be isolated.
+bool sys_set_core_isolation(int coreId, bool isolated);
+
 // Resolves the underlying physical address of the given virtual address.
 uint64_t sys_virt_to_phy(uint64_t addr);
 
@@ -140,4 +222,7 @@ ramfs_err_t sys_fs_delete(const char *path);
 void sys_hugepage_mode(bool enable);
 
 // Modifies the page table flags of the page containing the given address.
-uint64_t sys_page_flags(uint64_t address, uint64_t flags, bool set);
\ No newline at end of file
+uint64_t sys_page_flags(uint64_t address, uint64_t flags, bool set);
+
+// Sets the FS base (thread pointer) of the current thread.
+bool sys_set_fs_base(uint64_t base);
\ No newline at end of file
@@ -86,4 +86,27 @@ syscallwrapper sys_fs_list, 38
 syscallwrapper sys_dump, 39
 syscallwrapper sys_fs_delete, 40
 syscallwrapper sys_hugepage_mode, 41
-syscallwrapper sys_page_flags, 42
\ No newline at end of file
+syscallwrapper sys_page_flags, 42
+syscallwrapper sys_yield_to, 43
+syscallwrapper sys_get_thread_id, 44
+syscallwrapper sys_set_thread_scheduling, 45
+syscallwrapper sys_set_core_isolation, 46
+syscallwrapper sys_get_thread_stats, 47
+syscallwrapper sys_get_cpu_stats, 48
+syscallwrapper sys_lock_torture, 49
+syscallwrapper sys_get_message_ring, 50
+syscallwrapper sys_wait_message, 51
+syscallwrapper sys_channel_create, 52
+syscallwrapper sys_channel_connect, 53
+syscallwrapper sys_channel_close, 54
+syscallwrapper sys_channel_wait, 55
+syscallwrapper sys_channel_notify, 56
+syscallwrapper sys_channel_grant, 57
+syscallwrapper sys_channel_accept_grant, 58
+syscallwrapper sys_uring_setup, 59
+syscallwrapper4 sys_uring_enter, 60
+syscallwrapper sys_wait_events, 61
+syscallwrapper sys_syscall_stats_enable, 62
+syscallwrapper sys_get_syscall_stats, 63
+syscallwrapper sys_mem_bench, 64
+syscallwrapper sys_set_fs_base, 65
\ No newline at end of file
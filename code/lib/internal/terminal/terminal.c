@@ -7,6 +7,8 @@ ITS kernel standard library terminal implementation.
 #include <stdbool.h>
 #include <internal/terminal/terminal.h>
 #include <internal/syscall/syscalls.h>
+#include <uring.h>
+#include <threading/lock.h>
 
 
 /* VARIABLES */
@@ -68,19 +70,75 @@ static uint32_t terminalRowCount;
 static color_t frontColor = COLOR_DEFAULT_FOREGROUND;
 static color_t backColor = COLOR_DEFAULT_BACKGROUND;
 
+// Batched system call ring for drawing operations, so printing a character or string needs a single system call.
+// The ring must only be used by one thread at a time, e.g. the keyboard thread scrolls while others print.
+static uring_context_t drawRing;
+static bool drawRingAvailable = false;
+static mutex_t drawMutex;
+
 
 /* FUNCTIONS */
 
+// Queues a drawing operation. The completions are not needed, so they are dropped if the completion queue is full.
+static void draw_queue(uring_op_t op, uint64_t arg0, uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4)
+{
+	while(!uring_queue(&drawRing, op, arg0, arg1, arg2, arg3, arg4, 0))
+		uring_discard_completions(&drawRing);
+}
+
+// Draws a rectangle, or queues it if the draw ring is available.
+static void draw_rectangle(uint32_t posX, uint32_t posY, uint32_t width, uint32_t height)
+{
+	if(drawRingAvailable)
+		draw_queue(URING_OP_VBE_RECTANGLE, posX, posY, width, height, 0);
+	else
+		sys_vbe_rectangle(posX, posY, width, height);
+}
+
+// Renders a character, or queues it if the draw ring is available.
+static void draw_char(uint32_t posX, uint32_t posY, char c)
+{
+	if(drawRingAvailable)
+		draw_queue(URING_OP_VBE_RENDER_CHAR, posX, posY, (uint64_t)c, 0, 0);
+	else
+		sys_vbe_render_char(posX, posY, c);
+}
+
+// Draws an image, or queues it if the draw ring is available. The pixels must stay valid until draw_flush().
+static void draw_image(uint32_t *pixels, uint32_t posX, uint32_t posY, uint32_t width, uint32_t height)
+{
+	if(drawRingAvailable)
+		draw_queue(URING_OP_VBE_DRAW, (uint64_t)pixels, posX, posY, width, height);
+	else
+		sys_vbe_draw(pixels, posX, posY, width, height);
+}
+
+// Executes the queued drawing operations.
+static void draw_flush()
+{
+	if(drawRingAvailable)
+	{
+		uring_submit(&drawRing, 0, 0);
+		uring_discard_completions(&drawRing);
+	}
+}
+
 // Sets the given color as active draw front color.
 static void apply_front_color(color_t color)
 {
-	sys_vbe_set_front_color(color.r, color.g, color.b);
+	if(drawRingAvailable)
+		draw_queue(URING_OP_VBE_SET_FRONT_COLOR, color.r, color.g, color.b, 0, 0);
+	else
+		sys_vbe_set_front_color(color.r, color.g, color.b);
 }
 
 // Sets the given color as active draw back color.
 static void apply_back_color(color_t color)
 {
-	sys_vbe_set_back_color(color.r, color.g, color.b);
+	if(drawRingAvailable)
+		draw_queue(URING_OP_VBE_SET_BACK_COLOR, color.r, color.g, color.b, 0, 0);
+	else
+		sys_vbe_set_back_color(color.r, color.g, color.b);
 }
 
 // Draws the scrollbar for the current scroll position.
@@ -92,17 +150,17 @@ static void draw_scrollbar()
 	
 	// Render background
 	apply_front_color(COLOR_DEFAULT_SCROLLBAR_BACKGROUND);
-	sys_vbe_rectangle(posX, posY, SCROLLBAR_WIDTH, renderWindowHeight);
+	draw_rectangle(posX, posY, SCROLLBAR_WIDTH, renderWindowHeight);
 	
 	// Render bar
 	uint32_t barOffsetY = (scrollY * renderWindowHeight) / terminalHeight; // Order of multiplication and division reversed, to avoid loss of precision
 	apply_front_color(COLOR_DEFAULT_SCROLLBAR_BAR);
-	sys_vbe_rectangle(posX, posY + barOffsetY, SCROLLBAR_WIDTH, scrollbarBarHeight);
+	draw_rectangle(posX, posY + barOffsetY, SCROLLBAR_WIDTH, scrollbarBarHeight);
 	
 	// Render line of cursor
 	uint32_t cursorOffsetY = (currentRow * ROW_HEIGHT * renderWindowHeight) / terminalHeight;
 	apply_front_color(COLOR_DEFAULT_SCROLLBAR_CURRENT_LINE);
-	sys_vbe_rectangle(posX, posY + cursorOffsetY, SCROLLBAR_WIDTH, SCROLLBAR_CURRENT_LINE_HEIGHT);
+	draw_rectangle(posX, posY + cursorOffsetY, SCROLLBAR_WIDTH, SCROLLBAR_CURRENT_LINE_HEIGHT);
 	
 	// Reset color
 	apply_front_color(frontColor);
@@ -112,7 +170,7 @@ static void draw_scrollbar()
 static void draw_cursor()
 {
 	// Draw cursor
-	sys_vbe_rectangle(TERMINAL_PADDING + currentColumn * COLUMN_WIDTH, TERMINAL_PADDING + currentRow * ROW_HEIGHT, VBE_FONT_CHARACTER_WIDTH, VBE_FONT_CHARACTER_HEIGHT);
+	draw_rectangle(TERMINAL_PADDING + currentColumn * COLUMN_WIDTH, TERMINAL_PADDING + currentRow * ROW_HEIGHT, VBE_FONT_CHARACTER_WIDTH, VBE_FONT_CHARACTER_HEIGHT);
 }
 
 void terminal_init(int lines)
@@ -134,9 +192,14 @@ void terminal_init(int lines)
 		return;
 	}
 	
+	// Set up batched drawing; without it, each drawing operation is a separate system call
+	mutex_init(&drawMutex);
+	drawRingAvailable = uring_init(&drawRing);
+	
 	// Clear buffer
 	apply_front_color(frontColor);
 	apply_back_color(backColor);
+	draw_flush();
 	sys_vbe_clear();
 	
 	// Draw scrollbar for current display
@@ -145,9 +208,11 @@ void terminal_init(int lines)
 		scrollbarBarHeight = SCROLLBAR_BAR_MIN_HEIGHT;
 	scrollYMax = terminalHeight - renderWindowHeight;
 	draw_scrollbar();
+	draw_flush();
 }
 
-void terminal_putc(char c)
+// Prints the given character, without executing the queued drawing operations.
+static void terminal_putc_queued(char c)
 {
 	// Clear cursor
 	apply_back_color(backColor);
@@ -202,7 +267,7 @@ void terminal_putc(char c)
 		default:
 		{
 			// Just draw the character
-			sys_vbe_render_char(TERMINAL_PADDING + currentColumn * COLUMN_WIDTH, TERMINAL_PADDING + currentRow * ROW_HEIGHT, c);
+			draw_char(TERMINAL_PADDING + currentColumn * COLUMN_WIDTH, TERMINAL_PADDING + currentRow * ROW_HEIGHT, c);
 			++currentColumn;
 			break;
 		}
@@ -231,11 +296,11 @@ void terminal_putc(char c)
 		apply_front_color(backColor);
 
 		// Clear current row
-		sys_vbe_rectangle(TERMINAL_PADDING, TERMINAL_PADDING + currentRow * ROW_HEIGHT, terminalColumnCount * COLUMN_WIDTH, ROW_HEIGHT);
+		draw_rectangle(TERMINAL_PADDING, TERMINAL_PADDING + currentRow * ROW_HEIGHT, terminalColumnCount * COLUMN_WIDTH, ROW_HEIGHT);
 
 		// Clear next row, if there is any
 		if(currentRow + 1 < terminalRowCount)
-			sys_vbe_rectangle(TERMINAL_PADDING, TERMINAL_PADDING + (currentRow + 1) * ROW_HEIGHT, terminalColumnCount * COLUMN_WIDTH, ROW_HEIGHT);
+			draw_rectangle(TERMINAL_PADDING, TERMINAL_PADDING + (currentRow + 1) * ROW_HEIGHT, terminalColumnCount * COLUMN_WIDTH, ROW_HEIGHT);
 
 		// Restore color
 		apply_front_color(frontColor);
@@ -245,12 +310,23 @@ void terminal_putc(char c)
 	draw_cursor();
 }
 
+void terminal_putc(char c)
+{
+	mutex_acquire(&drawMutex);
+	terminal_putc_queued(c);
+	draw_flush();
+	mutex_release(&drawMutex);
+}
+
 void terminal_puts(const char *str)
 {
-	// Print each char
+	// Print each char, and draw them all at once
 	char c;
+	mutex_acquire(&drawMutex);
 	while((c = *str++))
-		terminal_putc(c);
+		terminal_putc_queued(c);
+	draw_flush();
+	mutex_release(&drawMutex);
 }
 
 void terminal_handle_navigation_key(vkey_t keyCode)
@@ -296,14 +372,19 @@ void terminal_handle_navigation_key(vkey_t keyCode)
 	if(newScrollY != scrollY)
 	{
 		// Scroll
+		mutex_acquire(&drawMutex);
 		sys_vbe_set_scroll_position(newScrollY);
 		scrollY = newScrollY;
 		draw_scrollbar();
+		draw_flush();
+		mutex_release(&drawMutex);
 	}
 }
 
 void terminal_draw_rectangle(uint32_t width, uint32_t height, bool moveCursor)
 {	
+	mutex_acquire(&drawMutex);
+
 	// Enough space available?
 	uint32_t drawRow = currentRow + 1;
 	uint32_t rowCount = 1 + (height / ROW_HEIGHT);
@@ -316,16 +397,20 @@ void terminal_draw_rectangle(uint32_t width, uint32_t height, bool moveCursor)
 	}
 
 	// Draw rectangle relative to current position
-	sys_vbe_rectangle(TERMINAL_PADDING + currentColumn * COLUMN_WIDTH, TERMINAL_PADDING + currentRow * ROW_HEIGHT, width, height);
+	draw_rectangle(TERMINAL_PADDING + currentColumn * COLUMN_WIDTH, TERMINAL_PADDING + currentRow * ROW_HEIGHT, width, height);
 	
 	// Skip enough rows
 	if(moveCursor)
 		currentRow += rowCount;
 	draw_scrollbar();
+	draw_flush();
+	mutex_release(&drawMutex);
 }
 
 void terminal_draw(uint32_t *pixels, uint32_t width, uint32_t height, bool moveCursor)
 {
+	mutex_acquire(&drawMutex);
+
 	// Enough space available?
 	uint32_t drawRow = currentRow + 1;
 	uint32_t rowCount = 1 + (height / ROW_HEIGHT);
@@ -338,12 +423,14 @@ void terminal_draw(uint32_t *pixels, uint32_t width, uint32_t height, bool moveC
 	}
 
 	// Draw image relative to current position
-	sys_vbe_draw(pixels, TERMINAL_PADDING + currentColumn * COLUMN_WIDTH, TERMINAL_PADDING + currentRow * ROW_HEIGHT, width, height);
+	draw_image(pixels, TERMINAL_PADDING + currentColumn * COLUMN_WIDTH, TERMINAL_PADDING + currentRow * ROW_HEIGHT, width, height);
 	
 	// Skip enough rows
 	if(moveCursor)
 		currentRow += rowCount;
 	draw_scrollbar();
+	draw_flush();
+	mutex_release(&drawMutex);
 }
 
 void terminal_set_front_color(color_t color)
@@ -7,6 +7,8 @@ ITS kernel user space memory manager.
 #include <memory.h>
 #include <stdint.h>
 #include <internal/syscall/syscalls.h>
+#include <internal/cpu/features.h>
+#include <internal/memory/memory.h>
 
 
 /* VARIABLES */
@@ -42,54 +44,55 @@ void heap_free(void *memory)
 
 void *memcpy(void *destination, const void *source, int length)
 {
-	// Copy byte wise
-	uint8_t *destinationBytes = (uint8_t *)destination;
-	const uint8_t *sourceBytes = (uint8_t *)source;
-	while(length--)
-		*destinationBytes++ = *sourceBytes++;
+	if(length <= 0)
+		return destination;
 	
-	return destination;
+	// REP MOVSB beats vector loops for large lengths, with FSRM for medium ones too
+	uint32_t features = cpu_features_get();
+	if((features & CPU_FEATURE_FSRM) && length >= MEMORY_FSRM_THRESHOLD)
+		return memcpy_erms(destination, source, length);
+	if((features & CPU_FEATURE_ERMS) && length >= MEMORY_ERMS_THRESHOLD)
+		return memcpy_erms(destination, source, length);
+	if(features & CPU_FEATURE_AVX2)
+		return memcpy_avx2(destination, source, length);
+	return memcpy_sse2(destination, source, length);
 }
 
 void *memset(void *array, int value, int length)
 {
-	// Memset byte wise
-	uint8_t *ptr = (uint8_t *)array;
-	while(length--)
-		*ptr++ = (uint8_t)value;
+	if(length <= 0)
+		return array;
 	
-	return array;
+	uint32_t features = cpu_features_get();
+	if((features & CPU_FEATURE_ERMS) && length >= MEMORY_ERMS_THRESHOLD)
+		return memset_erms(array, value, length);
+	if(features & CPU_FEATURE_AVX2)
+		return memset_avx2(array, value, length);
+	return memset_sse2(array, value, length);
 }
 
 int memcmp(const void *array1, const void *array2, int length)
 {
-	// Compare byte wise
-    const uint8_t *ptr1 = array1;
-	const uint8_t *ptr2 = array2;
-    while(length--)
-        if(*ptr1 != *ptr2)
-            return *ptr1 - *ptr2;
-        else
-		{
-            ++ptr1;
-			++ptr2;
-		}
-    return 0;
+	if(length <= 0)
+		return 0;
+	
+	if(cpu_features_get() & CPU_FEATURE_AVX2)
+		return memcmp_avx2(array1, array2, length);
+	return memcmp_sse2(array1, array2, length);
 }
 
 void *memmove(void *destination, const void *source, int length)
 {
-	// If the source address is higher than the destination address, our memcpy() implementation is safe
-	if(source > destination)
-		return memcpy(destination, source, length);
+	if(length <= 0)
+		return destination;
 	
-	// Copy byte wise backwards
-	uint8_t *destinationBytes = (uint8_t *)destination + length - 1;
-	const uint8_t *sourceBytes = (uint8_t *)source + length - 1;
-	while(length--)
-		*destinationBytes-- = *sourceBytes--;
+	// All memcpy() variants copy forwards and read each block before writing the blocks overlapping it, so they are
+	// safe unless the destination starts within the source
+	if(destination <= source || (const uint8_t *)destination >= (const uint8_t *)source + length)
+		return memcpy(destination, source, length);
 	
-	return destination;
+	// Copy backwards
+	return memmove_backward_sse2(destination, source, length);
 }
 
 uint64_t get_physical_address(uint64_t virtAddress)
@@ -5,6 +5,8 @@ ITS kernel standard library string functions.
 /* INCLUDES */
 
 #include <string.h>
+#include <internal/cpu/features.h>
+#include <internal/memory/memory.h>
 
 
 
@@ -17,11 +19,9 @@ ITS kernel standard library string functions.
 
 int strlen(const char *str)
 {
-	// Run through chars until 0 terminator is found
-	const char *c = str;
-	while(*c)
-		++c;
-	return (int)(c - str);
+	if(cpu_features_get() & CPU_FEATURE_AVX2)
+		return strlen_avx2(str);
+	return strlen_sse2(str);
 }
 
 char *strrev(char *str)
@@ -116,17 +116,9 @@ bool is_digit(char c)
 
 int strcmp(const char *str1, const char *str2)
 {
-	// Do unsigned comparison
-	const unsigned char *s1 = (const unsigned char *)str1;
-	const unsigned char *s2 = (const unsigned char *)str2;
-
-	// Compare character-wise; if *s2 == 0, the loop will exit
-	while(*s1 && (*s1 == *s2))
-	{
-		++s1;
-		++s2;
-	}
-	return *s1 - *s2;
+	if(cpu_features_get() & CPU_FEATURE_AVX2)
+		return strcmp_avx2(str1, str2);
+	return strcmp_sse2(str1, str2);
 }
 
 int strncmp(const char *str1, const char *str2, int n)
@@ -44,7 +44,7 @@ static void thread_wrapper()
 	sys_exit_thread();
 }
 
-void run_thread(thread_func_t funcPtr, void *funcArgsPtr, const char *name)
+int run_thread(thread_func_t funcPtr, void *funcArgsPtr, const char *name)
 {
 	// Only one thread can be started at a time
 	mutex_acquire(&threadCreationMutex);
@@ -55,7 +55,22 @@ void run_thread(thread_func_t funcPtr, void *funcArgsPtr, const char *name)
 	
 	// Run wrapper function in a new thread
 	uint64_t wrapperFuncAddress = (uint64_t)&thread_wrapper;
-	sys_run_thread(wrapperFuncAddress, name);
+	int threadId = sys_run_thread(wrapperFuncAddress, name);
+	
+	// The wrapper releases the mutex, unless the thread could not be created
+	if(threadId < 0)
+		mutex_release(&threadCreationMutex);
+	return threadId;
+}
+
+int get_thread_id()
+{
+	return sys_get_thread_id();
+}
+
+void yield_to_thread(int threadId)
+{
+	sys_yield_to(threadId);
 }
 
 void set_thread_affinity(int coreId)
@@ -64,4 +79,38 @@ void set_thread_affinity(int coreId)
 	// Input checking is done by system call implementation
 	sys_set_affinity(coreId);
 	sys_yield();
+}
+
+bool set_thread_scheduling(int threadId, thread_sched_class_t schedClass, int priority)
+{
+	// Input checking is done by system call implementation
+	return sys_set_thread_scheduling(threadId, schedClass, priority) == 0;
+}
+
+bool set_core_isolation(int coreId, bool isolated)
+{
+	return sys_set_core_isolation(coreId, isolated);
+}
+
+int get_thread_stats(thread_stats_t *buffer, int maxCount)
+{
+	return sys_get_thread_stats(buffer, maxCount);
+}
+
+int get_cpu_stats(cpu_stats_t *buffer, int maxCount)
+{
+	return sys_get_cpu_stats(buffer, maxCount);
+}
+
+void *get_thread_pointer()
+{
+	// FSGSBASE instructions are not enabled, so use the TCB's self pointer
+	void *threadPointer;
+	__asm__ volatile("movq %%fs:0, %0" : "=r"(threadPointer));
+	return threadPointer;
+}
+
+bool set_thread_pointer(void *threadPointer)
+{
+	return sys_set_fs_base((uint64_t)threadPointer);
 }
\ No newline at end of file
@@ -6,6 +6,8 @@ ITS kernel standard library threading functionality.
 
 /* INCLUDES */
 
+#include <stdbool.h>
+#include <stdint.h>
 
 
 /* TYPES */
@@ -13,16 +15,121 @@ ITS kernel standard library threading functionality.
 // Function signature of a thread function.
 typedef void (*thread_func_t)(void *funcArgsPtr);
 
+// Scheduling classes, in descending precedence. Must match the kernel's sched_class_t.
+typedef enum
+{
+	// Real-time: Runs until it yields, FIFO within the same priority (1 to 99). Higher priorities preempt lower ones.
+	// Note that a real-time thread which polls without yielding blocks all lower threads on its core.
+	THREAD_SCHED_RT = 0,
+	
+	// Normal time-shared thread, the priority (1 to 16) is the weight of its time slice length.
+	THREAD_SCHED_NORMAL = 1,
+	
+	// Background thread, only runs if its core would be idle otherwise.
+	THREAD_SCHED_BATCH = 2
+} thread_sched_class_t;
+
+// Thread states. Must match the kernel's thread_state_t.
+typedef enum
+{
+	// Running or waiting to be run.
+	THREAD_STATE_RUNNABLE = 0,
+	
+	// Blocked.
+	THREAD_STATE_SUSPENDED = 1,
+	
+	// Terminated, but not freed yet.
+	THREAD_STATE_ZOMBIE = 2
+} thread_state_t;
+
+// Accounting data of a thread. Must match the kernel's sched_thread_stats_t.
+// Times are given in TSC ticks (see cpu_stats_t::tscTicksPerMs).
+typedef struct
+{
+	int threadId;
+	int coreId;
+	char name[32];
+	thread_state_t state;
+	thread_sched_class_t schedClass;
+	int schedPriority;
+	
+	// Time spent running, and time spent waiting in the run queue.
+	uint64_t runCycles;
+	uint64_t waitCycles;
+	
+	// Switches where the thread blocked, and switches where it was still runnable (preemption, yield).
+	uint64_t switchesVoluntary;
+	uint64_t switchesInvoluntary;
+	
+	// Number of times the thread was run by another core than before.
+	uint64_t migrations;
+} thread_stats_t;
+
+// Number of buckets of the run-queue latency histogram. Must match the kernel's SCHED_LATENCY_BUCKETS.
+#define CPU_STATS_LATENCY_BUCKETS 32
+
+// Accounting data of a core. Must match the kernel's sched_cpu_stats_t.
+typedef struct
+{
+	int coreId;
+	bool isolated;
+	
+	// TSC frequency of the core, or 0 if unknown.
+	uint64_t tscTicksPerMs;
+	
+	// TSC value at which the data was retrieved.
+	uint64_t timestamp;
+	
+	// Number of thread switches, and TSC ticks spent in the idle thread.
+	uint64_t switches;
+	uint64_t idleCycles;
+	
+	// Run-queue latencies: Bucket i counts threads that waited [2^i, 2^(i+1)) TSC ticks before being run.
+	uint64_t latencyHistogram[CPU_STATS_LATENCY_BUCKETS];
+} cpu_stats_t;
+
 
 /* DECLARATIONS */
 
+// Thread-local variables are declared using __thread (or _Thread_local). The kernel gives each thread its own copy of
+// the executable's TLS template and points FS to it, so accesses compile to plain %fs-relative loads and stores.
+// Note that the library itself does not use thread-local variables.
+
 // Initializes the library's threading module.
 // Is internally called exactly once immediately on startup.
 // This function does not have any side effects (outputs etc.).
 void threading_init();
 
-// Runs the given function in a new thread.
-void run_thread(thread_func_t funcPtr, void *funcArgsPtr, const char *name);
+// Runs the given function in a new thread and returns its ID.
+int run_thread(thread_func_t funcPtr, void *funcArgsPtr, const char *name);
+
+// Returns the ID of the current thread.
+int get_thread_id();
+
+// Gives up the remaining time slice and switches to the given thread, if it runs on the same core.
+// Useful when waiting for a result of another thread.
+void yield_to_thread(int threadId);
 
 // Sets the core where the current thread shall be executed on.
-void set_thread_affinity(int coreId);
\ No newline at end of file
+void set_thread_affinity(int coreId);
+
+// Sets scheduling class and priority of the given thread (-1 for the current one). Returns false on invalid parameters.
+bool set_thread_scheduling(int threadId, thread_sched_class_t schedClass, int priority);
+
+// Isolates the given core for noise-free measurements, or releases it again. Returns false if the core cannot be isolated.
+// Threads need to be moved to the core explicitly using set_thread_affinity().
+bool set_core_isolation(int coreId, bool isolated);
+
+// Retrieves the accounting data of up to maxCount threads of all processes. Returns the number of entries, or -1 on error.
+int get_thread_stats(thread_stats_t *buffer, int maxCount);
+
+// Retrieves the accounting data of up to maxCount cores. Returns the number of entries.
+int get_cpu_stats(cpu_stats_t *buffer, int maxCount);
+
+// Returns the thread pointer of the current thread, i.e. the address of its thread control block.
+// Must only be called if the executable has thread-local variables or set_thread_pointer() was called before.
+void *get_thread_pointer();
+
+// Sets the thread pointer of the current thread, e.g. to a custom TLS block. The first 8 bytes at the given address
+// must contain the address itself. Returns false if the address is invalid.
+bool set_thread_pointer(void *threadPointer);
\ No newline at end of file
@@ -0,0 +1,75 @@
+/*
+ITS kernel standard library batched system calls.
+*/
+
+/* INCLUDES */
+
+#include <uring.h>
+#include <internal/syscall/syscalls.h>
+
+
+/* FUNCTIONS */
+
+bool uring_init(uring_context_t *context)
+{
+	context->handle = sys_uring_setup(&context->ring);
+	if(context->handle < 0)
+		return false;
+	context->sqTail = 0;
+	return true;
+}
+
+uring_sqe_t *uring_get_sqe(uring_context_t *context)
+{
+	// The kernel advances sqHead when it has copied an entry
+	if(context->sqTail - __atomic_load_n(&context->ring->sqHead, __ATOMIC_ACQUIRE) >= URING_SQ_ENTRIES)
+		return 0;
+	return &context->ring->sqes[context->sqTail++ % URING_SQ_ENTRIES];
+}
+
+bool uring_queue(uring_context_t *context, uring_op_t op, uint64_t arg0, uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4, uint64_t userData)
+{
+	uring_sqe_t *sqe;
+	while(!(sqe = uring_get_sqe(context)))
+	{
+		// The kernel does not execute anything while the completion queue is full, so retrying would never succeed
+		if(uring_submit(context, 0, 0) <= 0)
+			return false;
+	}
+
+	sqe->op = op;
+	sqe->args[0] = arg0;
+	sqe->args[1] = arg1;
+	sqe->args[2] = arg2;
+	sqe->args[3] = arg3;
+	sqe->args[4] = arg4;
+	sqe->userData = userData;
+	return true;
+}
+
+int uring_submit(uring_context_t *context, uint32_t minComplete, int64_t timeoutMs)
+{
+	// Publish the queued entries
+	uint64_t pending = context->sqTail - __atomic_load_n(&context->ring->sqHead, __ATOMIC_ACQUIRE);
+	__atomic_store_n(&context->ring->sqTail, context->sqTail, __ATOMIC_RELEASE);
+	if(pending == 0 && minComplete == 0)
+		return 0;
+	return sys_uring_enter(context->handle, (uint32_t)pending, minComplete, timeoutMs);
+}
+
+bool uring_next_completion(uring_context_t *context, uring_cqe_t *cqe)
+{
+	uring_t *ring = context->ring;
+	uint64_t head = ring->cqHead;
+	if(head == __atomic_load_n(&ring->cqTail, __ATOMIC_ACQUIRE))
+		return false;
+
+	*cqe = ring->cqes[head % URING_CQ_ENTRIES];
+	__atomic_store_n(&ring->cqHead, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+void uring_discard_completions(uring_context_t *context)
+{
+	__atomic_store_n(&context->ring->cqHead, __atomic_load_n(&context->ring->cqTail, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+ITS kernel standard library batched system calls.
+
+Operations are queued in a ring shared with the kernel and executed in one system call by uring_submit(), which
+avoids the system call overhead of many small operations (e.g. rendering single characters). A ring context must only
+be used by one thread at a time.
+*/
+
+/* INCLUDES */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <internal/syscall/uring.h>
+
+
+/* TYPES */
+
+// A batched system call ring.
+typedef struct
+{
+	// Kernel handle.
+	int handle;
+
+	// Shared ring.
+	uring_t *ring;
+
+	// Local submission position, published by uring_submit().
+	uint64_t sqTail;
+} uring_context_t;
+
+
+/* DECLARATIONS */
+
+// Creates a new ring. A process can have up to 4 rings.
+bool uring_init(uring_context_t *context);
+
+// Returns the next free submission entry, or 0 if the submission queue is full (call uring_submit() then).
+// The entry is queued when the function is called; unused arguments should be set to 0.
+uring_sqe_t *uring_get_sqe(uring_context_t *context);
+
+// Queues an operation with up to five arguments. If the submission queue is full, it is submitted first.
+// Completions must be consumed: Once the completion queue is full, the kernel stops executing operations. Returns false
+// if the operation could not be queued for this reason.
+bool uring_queue(uring_context_t *context, uring_op_t op, uint64_t arg0, uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4, uint64_t userData);
+
+// Executes all queued operations, then waits up to the given amount of milliseconds (negative: forever) until at least
+// minComplete completions are pending. Returns the number of executed operations.
+int uring_submit(uring_context_t *context, uint32_t minComplete, int64_t timeoutMs);
+
+// Removes the oldest pending completion and stores it in the given variable. Returns false if there is none.
+bool uring_next_completion(uring_context_t *context, uring_cqe_t *cqe);
+
+// Drops all pending completions.
+void uring_discard_completions(uring_context_t *context);
\ No newline at end of file
@@ -22,6 +22,9 @@ ITS kernel LWIP port main file.
 
 /* TYPES */
 
+// Maximum time in milliseconds the polling thread sleeps while no packets arrive.
+#define ITSLWIP_MAX_SLEEP_TIME 50
+
 // Represents an entry of the receive queue.
 typedef struct receive_queue_entry_s
 {
@@ -95,6 +98,12 @@ static uint8_t packetBuffer[ETHERNET_PACKET_SIZE];
 // The next UDP send block number.
 static uint32_t udpBlockNumber = 0;
 
+// ID of the LWIP polling thread.
+static int lwipThreadId = -1;
+
+// ID of the thread currently waiting for LWIP to make progress, or -1.
+static volatile int waitingThreadId = -1;
+
 
 /* LWIP SYSTEM FUNCTIONS */
 
@@ -113,9 +122,9 @@ uint32_t sys_now()
 
 /* FUNCTIONS */
 
-// Polls for new packets and sends ticks to LWIP.
+// Polls for new packets and sends ticks to LWIP. Returns whether a packet was received.
 // This function needs to be protected with global mutex!
-static void itslwip_poll()
+static bool itslwip_poll()
 {
 	// Packet received?
 	int packetLength = sys_receive_network_packet(packetBuffer);
@@ -134,12 +143,21 @@ static void itslwip_poll()
 	
 	// Update timers
 	sys_check_timeouts();
+	return packetLength != 0;
+}
+
+// Gives up the time slice of a thread waiting for LWIP, by switching directly to the polling thread.
+static void itslwip_wait()
+{
+	waitingThreadId = get_thread_id();
+	yield_to_thread(lwipThreadId);
 }
 
 void itslwip_run(void *args)
 {
 	// Run on Core #0
 	set_thread_affinity(0);
+	lwipThreadId = get_thread_id();
 	
 	// Initialize and acquire mutex
 	mutex_init(&lwipMutex);
@@ -169,8 +187,27 @@ void itslwip_run(void *args)
 	while(true)
 	{
 		mutex_acquire(&lwipMutex);
-		itslwip_poll();
+		bool received = itslwip_poll();
+		uint32_t sleepTime = sys_timeouts_sleeptime();
 		mutex_release(&lwipMutex);
+		
+		// Let a waiting thread consume the new data immediately
+		int waitingThread = waitingThreadId;
+		if(received && waitingThread >= 0)
+		{
+			waitingThreadId = -1;
+			yield_to_thread(waitingThread);
+		}
+		
+		// Sleep until the next packet arrives or the next LWIP timer is due; other threads may start new timers in
+		// the meantime, so do not sleep too long
+		if(!received)
+		{
+			if(sleepTime > ITSLWIP_MAX_SLEEP_TIME)
+				sleepTime = ITSLWIP_MAX_SLEEP_TIME;
+			if(sleepTime > 0)
+				sys_wait_events(EVENT_NET_RECEIVE, sleepTime);
+		}
 	}
 }
 
@@ -394,7 +431,7 @@ conn_handle_t itslwip_connect(const char *targetAddress, int targetPort, bool us
 	
 	// Wait until connection succeeds
 	while(connData->connectState == ERR_INPROGRESS)
-		sys_yield();
+		itslwip_wait();
 	
 	// Check error code
 	if(connData->connectState != ERR_OK)
@@ -527,7 +564,7 @@ void itslwip_send(conn_handle_t connHandle, uint8_t *data, int dataLength)
 	
 	// Wait until all data was sent
 	while(connData->sendQueueSize > 0)
-		sys_yield();
+		itslwip_wait();
 }
 
 void itslwip_receive_data(conn_handle_t connHandle, uint8_t *dataBuffer, int dataLength)
@@ -575,7 +612,7 @@ void itslwip_receive_data(conn_handle_t connHandle, uint8_t *dataBuffer, int dat
 			mutex_release(&connData->receiveQueueMutex);
 		}
 		else
-			sys_yield();
+			itslwip_wait();
 	}
 }
 
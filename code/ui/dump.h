@@ -3,6 +3,7 @@
 /*
 Interacts with the kernel to dump and retrieve information about:
     - Physical memory state
+    - Kernel lock contention statistics
 */
 
 /* INCLUDES */
@@ -18,6 +19,9 @@ typedef enum
 	// State of the physical memory manager.
 	DUMP_PMM_STATE = 0,
 	
+	// Kernel lock statistics (only in kernels built with LOCKSTAT=1).
+	DUMP_LOCK_STATS = 1,
+	
 } dump_type_t;
 
 
@@ -0,0 +1,97 @@
+/*
+Kernel lock contention statistics output.
+*/
+
+/* INCLUDES */
+
+#include "lockstat.h"
+#include <io.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <internal/syscall/syscalls.h>
+
+
+/* TYPES */
+
+// Lengths of the statistics arrays. Must match the kernel's lockstat.h.
+#define LOCKSTAT_SITES 4
+#define LOCKSTAT_SITE_DEPTH 2
+#define LOCKSTAT_NAME_LENGTH 32
+#define LOCKSTAT_INFO_COUNT 64
+
+// Statistics of one call site of a lock. Must match the kernel's lockstat_site_info_t.
+typedef struct
+{
+	uint64_t rip[LOCKSTAT_SITE_DEPTH];
+	char names[LOCKSTAT_SITE_DEPTH][LOCKSTAT_NAME_LENGTH];
+	uint64_t acquisitions;
+	uint64_t spinCycles;
+} lockstat_site_info_t;
+
+// Statistics of one lock. Must match the kernel's lockstat_info_t.
+typedef struct
+{
+	uint64_t lock;
+	char name[LOCKSTAT_NAME_LENGTH];
+	uint64_t acquisitions;
+	uint64_t contended;
+	uint64_t spinCycles;
+	uint64_t spinCyclesMax;
+	uint64_t holdCycles;
+	uint64_t holdCyclesMax;
+	lockstat_site_info_t sites[LOCKSTAT_SITES];
+} lockstat_info_t;
+
+// Layout of the lock statistics returned by sys_info().
+typedef struct
+{
+	uint64_t count;
+	uint64_t untrackedAcquisitions;
+	lockstat_info_t infos[LOCKSTAT_INFO_COUNT];
+} lockstat_buffer_t;
+
+
+/* FUNCTIONS */
+
+void print_lockstat(int maxLocks)
+{
+	lockstat_buffer_t *buffer = malloc(sizeof(lockstat_buffer_t));
+	sys_info(4, (uint8_t *)buffer);
+	if(buffer->count == 0)
+	{
+		printf_locked("No lock statistics available, the kernel needs to be built with LOCKSTAT=1.\n");
+		free(buffer);
+		return;
+	}
+	
+	int count = (int)buffer->count < maxLocks ? (int)buffer->count : maxLocks;
+	printf_locked("Locks with the highest spin time (times in TSC ticks):\n");
+	printf_locked("    Lock                      Acquired  Contended  Avg. spin  Max. spin  Avg. hold  Max. hold\n");
+	for(int l = 0; l < count; ++l)
+	{
+		lockstat_info_t *info = &buffer->infos[l];
+		uint64_t acquisitions = info->acquisitions ? info->acquisitions : 1;
+		if(info->name[0])
+			printf_locked("    %-24s", info->name);
+		else
+			printf_locked("    %#-24llx", info->lock);
+		printf_locked(" %9llu %10llu %10llu %10llu %10llu %10llu\n",
+			info->acquisitions, info->contended, info->spinCycles / acquisitions, info->spinCyclesMax,
+			info->holdCycles / acquisitions, info->holdCyclesMax);
+		
+		// Call sites
+		for(int s = 0; s < LOCKSTAT_SITES; ++s)
+		{
+			lockstat_site_info_t *site = &info->sites[s];
+			if(site->acquisitions == 0)
+				break;
+			printf_locked("        %9llu x, spin %10llu: %s", site->acquisitions, site->spinCycles, site->names[0]);
+			for(int d = 1; d < LOCKSTAT_SITE_DEPTH && site->rip[d]; ++d)
+				printf_locked(" < %s", site->names[d]);
+			printf_locked("\n");
+		}
+	}
+	if(buffer->untrackedAcquisitions)
+		printf_locked("%llu acquisitions of untracked locks (lock table is full).\n", buffer->untrackedAcquisitions);
+	free(buffer);
+}
\ No newline at end of file
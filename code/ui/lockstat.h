@@ -0,0 +1,19 @@
+#pragma once
+
+/*
+Prints kernel lock contention statistics.
+*/
+
+/* INCLUDES */
+
+
+
+/* TYPES */
+
+
+
+/* DECLARATIONS */
+
+// Prints the kernel spin locks with the highest spin time and their most frequent call sites. Statistics are only
+// available if the kernel was built with LOCKSTAT=1.
+void print_lockstat(int maxLocks);
\ No newline at end of file
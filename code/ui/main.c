@@ -18,6 +18,12 @@ Kernel UI process main file.
 #include <internal/terminal/terminal.h>
 #include "dump.h"
 #include "cpuid.h"
+#include "top.h"
+#include "torture.h"
+#include "lockstat.h"
+#include "stats.h"
+#include "syscalls.h"
+#include "membench.h"
 
 
 /* VARIABLES */
@@ -116,7 +122,7 @@ void main()
 	// Start LWIP thread
 	printf_locked("Starting LWIP thread...\n");
 	char *addressData[] = { ipAddress, subnetMask, gatewayAddress };
-	run_thread(&itslwip_run, addressData, "lwip");
+	int lwipThreadId = run_thread(&itslwip_run, addressData, "lwip");
 	printf_locked("Thread started.\n");
 	
 	// Command loop
@@ -164,6 +170,15 @@ void main()
 				"    reboot                        Reset the CPU\n"
 				"    addarp <ip> <mac>             Add static IP/MAC pair to ARP table\n"
 				"    custom <param>                Run custom system call with given integer parameter\n"
+				"    sched <thread> <class> [prio] Set scheduling class (rt normal batch) of thread (ui lwip <id>)\n"
+				"    isolate <core> <on|off>       Isolate core from scheduler ticks, TLB shootdowns and thread placement\n"
+				"    top [interval ms]             Print thread CPU usage, switches and run-queue latencies\n"
+				"    locktorture [iterations]      Compare kernel spin lock implementations under contention on all cores\n"
+				"    lockstat [file name]          Print kernel lock contention statistics, or dump them into the given file\n"
+				"    stats                         Print kernel statistics counters and histograms\n"
+				"    syscalls [on|off|reset]       Print per-process system call statistics, or control their recording\n"
+				"    syscallbench [iterations]     Measure the latency of a system call which does no work\n"
+				"    membench [iterations]         Compare kernel memcpy/memset implementations for several sizes\n"
 				"\n"
 				"Supported protocols: tcp udp\n"
 				"\n"
@@ -698,6 +713,153 @@ void main()
 				printf_locked("Done\n");
 			}
 		}
+		else if(strcmp(args[0], "sched") == 0)
+		{
+			if(argCount < 3)
+			{
+				terminal_set_front_color(COLOR_ERROR);
+				printf_locked("Missing argument.\n");
+			}
+			else
+			{
+				// Resolve thread
+				int threadId;
+				if(strcmp(args[1], "ui") == 0)
+					threadId = -1;
+				else if(strcmp(args[1], "lwip") == 0)
+					threadId = lwipThreadId;
+				else
+					threadId = atoi(args[1]);
+				
+				// Resolve class
+				int schedClass = -1;
+				int priority = (argCount >= 4 ? atoi(args[3]) : 1);
+				if(strcmp(args[2], "rt") == 0)
+					schedClass = THREAD_SCHED_RT;
+				else if(strcmp(args[2], "normal") == 0)
+					schedClass = THREAD_SCHED_NORMAL;
+				else if(strcmp(args[2], "batch") == 0)
+					schedClass = THREAD_SCHED_BATCH;
+				
+				if(schedClass >= 0 && set_thread_scheduling(threadId, (thread_sched_class_t)schedClass, priority))
+					printf_locked("Done\n");
+				else
+				{
+					terminal_set_front_color(COLOR_ERROR);
+					printf_locked("Invalid thread, class or priority.\n");
+				}
+			}
+		}
+		else if(strcmp(args[0], "isolate") == 0)
+		{
+			if(argCount < 3)
+			{
+				terminal_set_front_color(COLOR_ERROR);
+				printf_locked("Missing argument.\n");
+			}
+			else if(set_core_isolation(atoi(args[1]), strcmp(args[2], "on") == 0))
+				printf_locked("Done\n");
+			else
+			{
+				terminal_set_front_color(COLOR_ERROR);
+				printf_locked("Invalid core.\n");
+			}
+		}
+		else if(strcmp(args[0], "top") == 0)
+		{
+			// Sample for one second by default
+			int intervalMs = (argCount >= 2 ? atoi(args[1]) : 1000);
+			if(intervalMs <= 0)
+			{
+				terminal_set_front_color(COLOR_ERROR);
+				printf_locked("Invalid interval.\n");
+			}
+			else
+				print_top(intervalMs);
+		}
+		else if(strcmp(args[0], "locktorture") == 0)
+		{
+			int iterations = (argCount >= 2 ? atoi(args[1]) : 100000);
+			if(iterations <= 0)
+			{
+				terminal_set_front_color(COLOR_ERROR);
+				printf_locked("Invalid iteration count.\n");
+			}
+			else
+				print_lock_torture(iterations);
+		}
+		else if(strcmp(args[0], "lockstat") == 0)
+		{
+			if(argCount < 2)
+				print_lockstat(16);
+			else
+			{
+				// Absolute or relative path?
+				int pathLength = strlen(args[1]);
+				if(pathLength >= 1 && args[1][0] == '/')
+				{
+					// Use argument as entire path
+					strncpy(buffer, args[1], pathLength);
+					buffer[pathLength] = '\0';
+				}
+				else
+				{
+					// Concat current directory and given path
+					int currentDirectoryStringLength = strlen(currentDirectory);
+					strncpy(buffer, currentDirectory, currentDirectoryStringLength);
+					strncpy(&buffer[currentDirectoryStringLength], args[1], pathLength);
+					buffer[currentDirectoryStringLength + pathLength] = '\0';
+				}
+				
+				// Generate dump
+				printf_locked("Running lock statistics dump...");
+				create_dump(DUMP_LOCK_STATS, buffer);
+				printf_locked("done.\n");
+			}
+		}
+		else if(strcmp(args[0], "stats") == 0)
+		{
+			printf_locked("Kernel statistics (summed over all CPUs):\n");
+			print_kernel_stats();
+		}
+		else if(strcmp(args[0], "syscallbench") == 0)
+		{
+			int iterations = (argCount >= 2 ? atoi(args[1]) : 100000);
+			if(iterations <= 0)
+			{
+				terminal_set_front_color(COLOR_ERROR);
+				printf_locked("Invalid iteration count.\n");
+			}
+			else
+				print_syscall_benchmark(iterations);
+		}
+		else if(strcmp(args[0], "membench") == 0)
+		{
+			int iterations = (argCount >= 2 ? atoi(args[1]) : 1000);
+			if(iterations <= 0)
+			{
+				terminal_set_front_color(COLOR_ERROR);
+				printf_locked("Invalid iteration count.\n");
+			}
+			else
+				print_mem_benchmark(iterations);
+		}
+		else if(strcmp(args[0], "syscalls") == 0)
+		{
+			if(argCount < 2)
+				print_syscall_stats(24);
+			else if(strcmp(args[1], "on") == 0)
+				syscall_stats_enable(true, false);
+			else if(strcmp(args[1], "off") == 0)
+				syscall_stats_enable(false, false);
+			else if(strcmp(args[1], "reset") == 0)
+				syscall_stats_enable(true, true);
+			else
+			{
+				terminal_set_front_color(COLOR_ERROR);
+				printf_locked("Invalid argument.\n");
+			}
+		}
 		else
 		{
 			terminal_set_front_color(COLOR_ERROR);
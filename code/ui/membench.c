@@ -0,0 +1,52 @@
+/*
+Kernel memory routine benchmark output.
+*/
+
+/* INCLUDES */
+
+#include "membench.h"
+#include <io.h>
+#include <stdint.h>
+#include <internal/syscall/syscalls.h>
+
+
+/* TYPES */
+
+// Result for one routine and size. Must match the kernel's mem_bench_result_t.
+typedef struct
+{
+	int routine;
+	uint64_t size;
+	uint64_t minCycles;
+	uint64_t avgCycles;
+} mem_bench_result_t;
+
+
+/* FUNCTIONS */
+
+void print_mem_benchmark(int iterations)
+{
+	// Names of the routines, in the order of the kernel's mem_bench_routine_t
+	static const char *routineNames[] = { "memcpy", "memcpy (qword)", "memcpy (erms)", "memset", "memset (qword)",
+		"memset (erms)", "memmove (backward)", "copy_page", "clear_page", "memcpy (sse2 nt)", "memclr (sse2 nt)" };
+	const int routineCount = sizeof(routineNames) / sizeof(*routineNames);
+	
+	mem_bench_result_t results[64];
+	int count = sys_mem_bench(iterations, results, 64);
+	if(count < 0)
+	{
+		printf_locked("Memory benchmark failed.\n");
+		return;
+	}
+	
+	printf_locked("Memory routines (%d repetitions per size, times in TSC ticks):\n", iterations);
+	printf_locked("    Routine               Size     Min.     Avg.  Bytes/tick\n");
+	for(int r = 0; r < count; ++r)
+	{
+		mem_bench_result_t *result = &results[r];
+		uint64_t minCycles = result->minCycles ? result->minCycles : 1;
+		printf_locked("    %-18s %7llu %8llu %8llu %7llu.%02llu\n",
+			(unsigned)result->routine < (unsigned)routineCount ? routineNames[result->routine] : "?", result->size,
+			result->minCycles, result->avgCycles, result->size / minCycles, (result->size * 100 / minCycles) % 100);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+Runs the kernel memory routine benchmark and prints its results.
+*/
+
+/* INCLUDES */
+
+
+
+/* TYPES */
+
+
+
+/* DECLARATIONS */
+
+// Runs the kernel memory routine benchmark with the given number of repetitions per size, and prints the results.
+void print_mem_benchmark(int iterations);
\ No newline at end of file
@@ -0,0 +1,70 @@
+/*
+Kernel statistics output.
+*/
+
+/* INCLUDES */
+
+#include "stats.h"
+#include <io.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <internal/syscall/syscalls.h>
+
+
+/* TYPES */
+
+// Limits of the kernel statistics. Must match the kernel's kstat.h.
+#define KSTAT_HISTOGRAM_BUCKETS 32
+#define KSTAT_MAX_COUNT 64
+#define KSTAT_NAME_LENGTH 32
+
+// Statistic types. Must match the kernel's kstat_type_t.
+#define KSTAT_TYPE_COUNTER 0
+#define KSTAT_TYPE_HISTOGRAM 1
+
+// Snapshot of a statistic. Must match the kernel's kstat_info_t.
+typedef struct
+{
+	char name[KSTAT_NAME_LENGTH];
+	uint32_t type;
+	uint64_t values[KSTAT_HISTOGRAM_BUCKETS];
+} kstat_info_t;
+
+// Layout of the kernel statistics returned by sys_info().
+typedef struct
+{
+	uint64_t count;
+	kstat_info_t infos[KSTAT_MAX_COUNT];
+} kstat_buffer_t;
+
+
+/* FUNCTIONS */
+
+void print_kernel_stats(void)
+{
+	kstat_buffer_t *buffer = malloc(sizeof(kstat_buffer_t));
+	sys_info(5, (uint8_t *)buffer);
+	
+	for(int s = 0; s < (int)buffer->count; ++s)
+	{
+		kstat_info_t *info = &buffer->infos[s];
+		if(info->type == KSTAT_TYPE_COUNTER)
+		{
+			printf_locked("    %-31s %llu\n", info->name, info->values[0]);
+			continue;
+		}
+		
+		// Histogram: Print total and the non-empty buckets
+		uint64_t total = 0;
+		for(int b = 0; b < KSTAT_HISTOGRAM_BUCKETS; ++b)
+			total += info->values[b];
+		printf_locked("    %-31s %llu samples\n", info->name, total);
+		for(int b = 0; b < KSTAT_HISTOGRAM_BUCKETS; ++b)
+			if(info->values[b])
+				printf_locked("        >= 2^%-2d %llu\n", b, info->values[b]);
+	}
+	
+	if(buffer->count == 0)
+		printf_locked("No kernel statistics registered.\n");
+	free(buffer);
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+Prints the kernel statistics (counters and histograms registered by kernel subsystems).
+*/
+
+/* INCLUDES */
+
+
+
+/* TYPES */
+
+
+
+/* DECLARATIONS */
+
+// Prints all kernel statistics, summed over all CPUs.
+void print_kernel_stats(void);
\ No newline at end of file
@@ -0,0 +1,140 @@
+/*
+System call statistics output.
+*/
+
+/* INCLUDES */
+
+#include "syscalls.h"
+#include <io.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <internal/syscall/syscalls.h>
+
+
+/* TYPES */
+
+// Number of histogram buckets. Must match the kernel's syscallstat.h.
+#define SYSCALLSTAT_HISTOGRAM_BUCKETS 32
+
+// Maximum number of entries retrieved from the kernel.
+#define SYSCALLSTAT_INFO_COUNT 256
+
+// Statistics of one system call of one process. Must match the kernel's syscallstat_info_t.
+typedef struct
+{
+	char processName[32];
+	uint32_t syscall;
+	uint32_t reserved;
+	uint64_t calls;
+	uint64_t cycles;
+	uint64_t histogram[SYSCALLSTAT_HISTOGRAM_BUCKETS];
+} syscallstat_info_t;
+
+
+/* VARIABLES */
+
+// System call names, indexed by number. Must match the kernel's syscall table.
+static const char *syscallNames[] =
+{
+	"trace", "exit", "yield", "next_message_type", "next_message", "set_displayed_process", "vbe_rectangle",
+	"vbe_render_char", "vbe_get_screen_width", "vbe_get_screen_height", "vbe_set_front_color",
+	"vbe_set_back_color", "vbe_allocate_scroll_buffer", "vbe_set_scroll_position", "vbe_clear", "heap_alloc",
+	"heap_free", "run_thread", "exit_thread", "get_elapsed_milliseconds", "get_network_mac_address",
+	"receive_network_packet", "send_network_packet", "start_process", "info", "set_affinity", "virt_to_phy",
+	"reset", "custom", "vbe_draw", "fs_open", "fs_close", "fs_read", "fs_write", "fs_tell", "fs_seek",
+	"fs_create_directory", "fs_test_directory", "fs_list", "dump", "fs_delete", "hugepage_mode", "page_flags",
+	"yield_to", "get_thread_id", "set_thread_scheduling", "set_core_isolation", "get_thread_stats",
+	"get_cpu_stats", "lock_torture", "get_message_ring", "wait_message", "channel_create", "channel_connect",
+	"channel_close", "channel_wait", "channel_notify", "channel_grant", "channel_accept_grant", "uring_setup",
+	"uring_enter", "wait_events", "syscall_stats_enable", "get_syscall_stats", "mem_bench",
+	"set_fs_base"
+};
+
+
+/* FUNCTIONS */
+
+void syscall_stats_enable(bool enable, bool reset)
+{
+	sys_syscall_stats_enable(enable, reset);
+}
+
+// Returns the lower bound of the histogram bucket containing the given percentile.
+static uint64_t syscall_stats_percentile(syscallstat_info_t *info, int percent)
+{
+	uint64_t threshold = (info->calls * percent + 99) / 100;
+	uint64_t sum = 0;
+	for(int b = 0; b < SYSCALLSTAT_HISTOGRAM_BUCKETS; ++b)
+	{
+		sum += info->histogram[b];
+		if(sum >= threshold)
+			return b == 0 ? 0 : (1ULL << b);
+	}
+	return 1ULL << (SYSCALLSTAT_HISTOGRAM_BUCKETS - 1);
+}
+
+void print_syscall_stats(int maxEntries)
+{
+	syscallstat_info_t *infos = malloc(SYSCALLSTAT_INFO_COUNT * sizeof(syscallstat_info_t));
+	int count = sys_get_syscall_stats(infos, SYSCALLSTAT_INFO_COUNT);
+	if(count <= 0)
+	{
+		printf_locked("No system call statistics recorded, enable them with \"syscalls on\".\n");
+		free(infos);
+		return;
+	}
+	
+	// Sort by total time
+	for(int i = 1; i < count; ++i)
+	{
+		syscallstat_info_t current = infos[i];
+		int pos = i;
+		while(pos > 0 && infos[pos - 1].cycles < current.cycles)
+		{
+			infos[pos] = infos[pos - 1];
+			--pos;
+		}
+		infos[pos] = current;
+	}
+	
+	if(count > maxEntries)
+		count = maxEntries;
+	printf_locked("System calls with the highest total time (times in TSC ticks, percentiles as bucket lower bounds):\n");
+	printf_locked("    Process          System call                   Calls   Total time    Avg.   >=p50   >=p99\n");
+	for(int i = 0; i < count; ++i)
+	{
+		syscallstat_info_t *info = &infos[i];
+		uint64_t calls = info->calls ? info->calls : 1;
+		int nameCount = sizeof(syscallNames) / sizeof(syscallNames[0]);
+		if(info->syscall < (uint32_t)nameCount)
+			printf_locked("    %-16s %-24s", info->processName, syscallNames[info->syscall]);
+		else
+			printf_locked("    %-16s %-24u", info->processName, info->syscall);
+		printf_locked(" %10llu %12llu %7llu %7llu %7llu\n", info->calls, info->cycles, info->cycles / calls,
+			syscall_stats_percentile(info, 50), syscall_stats_percentile(info, 99));
+	}
+	free(infos);
+}
+
+// Reads the time stamp counter, after all preceding instructions have completed.
+static uint64_t syscall_benchmark_tsc(void)
+{
+	__builtin_ia32_lfence();
+	return __builtin_ia32_rdtsc();
+}
+
+void print_syscall_benchmark(int iterations)
+{
+	// sys_get_thread_id() only reads a field of the current thread, so this measures the entry and exit path
+	uint64_t min = UINT64_MAX;
+	uint64_t total = 0;
+	for(int i = 0; i < iterations; ++i)
+	{
+		uint64_t start = syscall_benchmark_tsc();
+		sys_get_thread_id();
+		uint64_t cycles = syscall_benchmark_tsc() - start;
+		if(cycles < min)
+			min = cycles;
+		total += cycles;
+	}
+	printf_locked("Null system call (%d iterations): min %llu, avg %llu TSC ticks\n", iterations, min, total / iterations);
+}
\ No newline at end of file
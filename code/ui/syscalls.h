@@ -0,0 +1,25 @@
+#pragma once
+
+/*
+Prints per-process system call statistics.
+*/
+
+/* INCLUDES */
+
+#include <stdbool.h>
+
+
+/* TYPES */
+
+
+
+/* DECLARATIONS */
+
+// Switches the kernel's system call statistics on or off, discarding the collected statistics if reset is set.
+void syscall_stats_enable(bool enable, bool reset);
+
+// Prints the system calls with the highest total time, with call counts and latency percentiles.
+void print_syscall_stats(int maxEntries);
+
+// Measures the round trip time of a system call which does no work, and prints the minimum and average in TSC ticks.
+void print_syscall_benchmark(int iterations);
\ No newline at end of file
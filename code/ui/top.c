@@ -0,0 +1,140 @@
+/*
+Scheduler accounting output.
+*/
+
+/* INCLUDES */
+
+#include "top.h"
+#include <io.h>
+#include <memory.h>
+#include <threading/thread.h>
+#include <internal/syscall/syscalls.h>
+
+
+/* VARIABLES */
+
+// Maximum number of threads and cores being displayed.
+#define TOP_MAX_THREADS 256
+#define TOP_MAX_CPUS 64
+
+
+/* FUNCTIONS */
+
+// Returns the entry of the given core, or 0 if it does not exist.
+static const cpu_stats_t *find_cpu(const cpu_stats_t *cpus, int cpuCount, int coreId)
+{
+	for(int c = 0; c < cpuCount; ++c)
+		if(cpus[c].coreId == coreId)
+			return &cpus[c];
+	return 0;
+}
+
+// Returns the entry of the given thread, or 0 if it does not exist.
+static const thread_stats_t *find_thread(const thread_stats_t *threads, int threadCount, int threadId)
+{
+	for(int t = 0; t < threadCount; ++t)
+		if(threads[t].threadId == threadId)
+			return &threads[t];
+	return 0;
+}
+
+// Converts the given amount of TSC ticks into microseconds, if the TSC frequency is known.
+static uint64_t ticks_to_us(uint64_t ticks, const cpu_stats_t *cpu)
+{
+	if(!cpu || cpu->tscTicksPerMs == 0)
+		return ticks;
+	return ticks * 1000 / cpu->tscTicksPerMs;
+}
+
+// Prints the given fraction in per mille as percentage.
+static void print_permille(uint64_t part, uint64_t total)
+{
+	uint64_t permille = (total == 0 ? 0 : part * 1000 / total);
+	printf_locked("%3llu.%llu%%", permille / 10, permille % 10);
+}
+
+void print_top(int intervalMs)
+{
+	thread_stats_t *threadsBefore = (thread_stats_t *)malloc(TOP_MAX_THREADS * sizeof(thread_stats_t));
+	thread_stats_t *threadsAfter = (thread_stats_t *)malloc(TOP_MAX_THREADS * sizeof(thread_stats_t));
+	cpu_stats_t *cpusBefore = (cpu_stats_t *)malloc(TOP_MAX_CPUS * sizeof(cpu_stats_t));
+	cpu_stats_t *cpusAfter = (cpu_stats_t *)malloc(TOP_MAX_CPUS * sizeof(cpu_stats_t));
+	
+	// Take two samples
+	int cpuCountBefore = get_cpu_stats(cpusBefore, TOP_MAX_CPUS);
+	int threadCountBefore = get_thread_stats(threadsBefore, TOP_MAX_THREADS);
+	uint64_t end = sys_get_elapsed_milliseconds() + intervalMs;
+	while(sys_get_elapsed_milliseconds() < end)
+		sys_yield();
+	int threadCountAfter = get_thread_stats(threadsAfter, TOP_MAX_THREADS);
+	int cpuCountAfter = get_cpu_stats(cpusAfter, TOP_MAX_CPUS);
+	
+	// Print threads; times are totals, the CPU usage refers to the sampling interval
+	printf_locked("Thread accounting (CPU usage over %d ms, times in us, 'cycles' if the TSC frequency is unknown):\n", intervalMs);
+	printf_locked("   ID Core Class State    CPU      Run total     Wait total  Vol. sw. Invol. sw.  Migr. Name\n");
+	for(int t = 0; t < threadCountAfter; ++t)
+	{
+		const thread_stats_t *thread = &threadsAfter[t];
+		const thread_stats_t *threadBefore = find_thread(threadsBefore, threadCountBefore, thread->threadId);
+		const cpu_stats_t *cpu = find_cpu(cpusAfter, cpuCountAfter, thread->coreId);
+		const cpu_stats_t *cpuBefore = find_cpu(cpusBefore, cpuCountBefore, thread->coreId);
+		
+		static const char *classNames[] = { "rt", "norm", "batch" };
+		static const char *stateNames[] = { "run", "susp", "zomb" };
+		printf_locked("%5d %4d %-5s %-5s ", thread->threadId, thread->coreId,
+			(unsigned)thread->schedClass < 3 ? classNames[thread->schedClass] : "?",
+			(unsigned)thread->state < 3 ? stateNames[thread->state] : "?");
+		
+		// Usage within the interval; threads which were created in between are measured from their start
+		uint64_t runBefore = (threadBefore ? threadBefore->runCycles : 0);
+		if(cpu && cpuBefore)
+			print_permille(thread->runCycles - runBefore, cpu->timestamp - cpuBefore->timestamp);
+		else
+			printf_locked("     ?");
+		
+		printf_locked(" %14llu %14llu %9llu %10llu %6llu %s\n",
+			ticks_to_us(thread->runCycles, cpu), ticks_to_us(thread->waitCycles, cpu),
+			thread->switchesVoluntary, thread->switchesInvoluntary, thread->migrations, thread->name);
+	}
+	if(threadCountAfter == TOP_MAX_THREADS)
+		printf_locked("(only the first %d threads are shown)\n", TOP_MAX_THREADS);
+	
+	// Print cores
+	printf_locked("\nCore accounting:\n");
+	for(int c = 0; c < cpuCountAfter; ++c)
+	{
+		const cpu_stats_t *cpu = &cpusAfter[c];
+		const cpu_stats_t *cpuBefore = find_cpu(cpusBefore, cpuCountBefore, cpu->coreId);
+		
+		printf_locked("    Core #%d%s: %llu TSC ticks/ms, ", cpu->coreId, cpu->isolated ? " (isolated)" : "", cpu->tscTicksPerMs);
+		if(cpuBefore)
+		{
+			printf_locked("%llu switches, idle ", cpu->switches - cpuBefore->switches);
+			print_permille(cpu->idleCycles - cpuBefore->idleCycles, cpu->timestamp - cpuBefore->timestamp);
+		}
+		printf_locked("\n");
+		
+		// Run-queue latency histogram since boot, skipping empty buckets
+		printf_locked("        Run-queue latency:");
+		bool empty = true;
+		for(int b = 0; b < CPU_STATS_LATENCY_BUCKETS; ++b)
+		{
+			if(cpu->latencyHistogram[b] == 0)
+				continue;
+			
+			// Use nanoseconds for the lower bucket bound, the smallest buckets are well below one microsecond
+			uint64_t lowerBound = (b == 0 ? 0 : 1ULL << b);
+			if(cpu->tscTicksPerMs)
+				printf_locked(" >=%lluns:%llu", lowerBound * 1000000 / cpu->tscTicksPerMs, cpu->latencyHistogram[b]);
+			else
+				printf_locked(" >=%llu:%llu", lowerBound, cpu->latencyHistogram[b]);
+			empty = false;
+		}
+		printf_locked(empty ? " -\n" : "\n");
+	}
+	
+	free(threadsBefore);
+	free(threadsAfter);
+	free(cpusBefore);
+	free(cpusAfter);
+}
\ No newline at end of file
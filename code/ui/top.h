@@ -0,0 +1,20 @@
+#pragma once
+
+/*
+Prints scheduler accounting information:
+    - Per-thread CPU usage, wait time, switches and migrations
+	- Per-core idle time and run-queue latency histograms
+*/
+
+/* INCLUDES */
+
+
+
+/* TYPES */
+
+
+
+/* DECLARATIONS */
+
+// Samples the scheduler accounting data over the given interval and prints per-thread and per-core usage.
+void print_top(int intervalMs);
\ No newline at end of file
@@ -0,0 +1,53 @@
+/*
+Lock torture test output.
+*/
+
+/* INCLUDES */
+
+#include "torture.h"
+#include <io.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <internal/syscall/syscalls.h>
+
+
+/* TYPES */
+
+// Result for one lock type. Must match the kernel's lock_torture_result_t.
+typedef struct
+{
+	int type;
+	int threads;
+	int iterations;
+	uint64_t avgAcquireCycles;
+	uint64_t maxAcquireCycles;
+	uint64_t avgCycles;
+	bool ok;
+} lock_torture_result_t;
+
+
+/* FUNCTIONS */
+
+void print_lock_torture(int iterations)
+{
+	// Names of the lock types, in the order of the kernel's lock_torture_type_t
+	static const char *lockNames[] = { "test-and-set", "ticket", "ticket (plain)" };
+	
+	lock_torture_result_t results[3];
+	int count = sys_lock_torture(iterations, results, 3);
+	if(count == 0)
+	{
+		printf_locked("Lock torture test is already running.\n");
+		return;
+	}
+	
+	printf_locked("Lock torture (%d acquisitions per core, times in TSC ticks):\n", iterations);
+	printf_locked("    Lock            Threads  Avg. acquire  Max. acquire  Avg. lock/unlock  Exclusion\n");
+	for(int r = 0; r < count; ++r)
+	{
+		lock_torture_result_t *result = &results[r];
+		printf_locked("    %-15s %7d %13llu %13llu %17llu  %s\n",
+			(unsigned)result->type < 3 ? lockNames[result->type] : "?", result->threads,
+			result->avgAcquireCycles, result->maxAcquireCycles, result->avgCycles, result->ok ? "ok" : "VIOLATED");
+	}
+}
\ No newline at end of file
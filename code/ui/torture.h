@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+Runs the kernel lock torture test and prints its results.
+*/
+
+/* INCLUDES */
+
+
+
+/* TYPES */
+
+
+
+/* DECLARATIONS */
+
+// Runs the kernel lock torture test with the given number of lock acquisitions per core, and prints the results.
+void print_lock_torture(int iterations);
\ No newline at end of file